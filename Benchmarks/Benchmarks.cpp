@@ -0,0 +1,562 @@
+//
+//  Benchmarks.cpp
+//  Benchmarks
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+// Micro benchmarks for fretboarderLib, run over every built-in preset and every
+// board found in Tests/boards. For each board we report the time and the number
+// of heap allocations per operation.
+//
+// usage: fretboarderBench [--iterations N] [--boards DIR]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Fretboard.hpp"
+#include "FretKernel.hpp"
+#include "FretboardBatch.hpp"
+#include "FretboardBuilder.hpp"
+#include "FretboardLocator.hpp"
+#include "InstrumentJson.hpp"
+#include "InstrumentLibrary.hpp"
+#include "NdjsonPipeline.hpp"
+#include "DxfWriter.hpp"
+#include "SvgTemplate.hpp"
+#include "LayoutOptimizer.hpp"
+#include "Sweep.hpp"
+#include "String.hpp"
+#include "Geometry.hpp"
+
+#ifndef FRETBOARDER_BOARDS_DIR
+#define FRETBOARDER_BOARDS_DIR "Tests/boards"
+#endif
+
+using namespace fretboarder;
+
+// Count every heap allocation done by the process so that we can report allocations per operation.
+static std::atomic<size_t> allocation_count(0);
+
+// GCC pairs the replaced operators by their declarations and warns that free() releases operator new memory, which
+// is what the replacements do.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    free(p);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+// Results are accumulated here so that the compiler can't drop the work being measured.
+static volatile double sink = 0;
+
+// Output of the benchmarks writing files, discards everything.
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+struct Board {
+    std::string name;
+    Instrument instrument;
+};
+
+struct Result {
+    double ns_per_op;
+    double allocations_per_op;
+};
+
+template <class Function>
+static Result measure(size_t iterations, size_t ops_per_iteration, Function&& function) {
+    // Warm up caches and any lazily initialized state before measuring.
+    function();
+
+    size_t allocations = allocation_count.load(std::memory_order_relaxed);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        function();
+    }
+    auto end = std::chrono::steady_clock::now();
+    allocations = allocation_count.load(std::memory_order_relaxed) - allocations;
+
+    double ops = double(iterations) * double(std::max<size_t>(1, ops_per_iteration));
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    return { ns / ops, double(allocations) / ops };
+}
+
+static void report(const Board& board, const char* benchmark, const Result& result) {
+    printf("%-24s %-30s %12.1f %12.2f\n", board.name.c_str(), benchmark, result.ns_per_op, result.allocations_per_op);
+}
+
+static std::vector<Board> load_boards(const std::string& directory) {
+    std::vector<Board> boards;
+    for (auto& preset : Preset::presets()) {
+        boards.push_back({ preset.name, preset.instrument });
+    }
+
+    std::vector<std::filesystem::path> files;
+    std::error_code error;
+    for (auto& entry : std::filesystem::directory_iterator(directory, error)) {
+        if (entry.path().extension() == ".frt") {
+            files.push_back(entry.path());
+        }
+    }
+    if (error) {
+        fprintf(stderr, "Unable to read boards from \"%s\": %s\n", directory.c_str(), error.message().c_str());
+    }
+    std::sort(files.begin(), files.end());
+
+    for (auto& file : files) {
+        Board board { file.filename().string(), Instrument() };
+        if (!board.instrument.load(file.string())) {
+            fprintf(stderr, "Unable to load board \"%s\"\n", file.string().c_str());
+            continue;
+        }
+        boards.push_back(board);
+    }
+    return boards;
+}
+
+static void bench_board(const Board& board, size_t iterations) {
+    const Instrument& instrument = board.instrument;
+
+    // Construction with every fret kernel this CPU supports, best one last so that it's left selected
+    for (int isa = 0; isa <= int(fret_kernel_best_isa()); isa++) {
+        set_fret_kernel_isa(FretKernelIsa(isa));
+        std::string name = std::string("Fretboard(Instrument)/") + fret_kernel_isa_name(FretKernelIsa(isa));
+        report(board, name.c_str(), measure(iterations, 1, [&]() {
+            Fretboard fretboard(instrument);
+            sink = sink + fretboard.board_shape().points[1].x;
+        }));
+    }
+
+    // Construction in a reused arena: no heap allocation at all once warmed up
+    Arena arena;
+    report(board, "Fretboard(Instrument, Arena)", measure(iterations, 1, [&]() {
+        arena.reset();
+        Fretboard fretboard(instrument, arena);
+        sink = sink + fretboard.board_shape().points[1].x;
+    }));
+
+    // Microtonal boards: as many frets in 12-TET and 31-EDO, with a perpendicular fret behind the nut
+    for (int divisions : { 12, 31 }) {
+        Instrument edo = instrument;
+        edo.number_of_frets_per_octave = divisions;
+        edo.number_of_frets = 60;
+        edo.perpendicular_fret_index = -2.5;
+        edo.validate();
+        std::string name = "Fretboard(Instrument)/" + std::to_string(divisions) + "-EDO";
+        report(board, name.c_str(), measure(iterations, 1, [&]() {
+            Fretboard fretboard(edo);
+            sink = sink + fretboard.board_shape().points[1].x;
+        }));
+    }
+
+    // Every string with its own offsets (True Temperament style): O(1) table lookups, and curved frets in one buffer
+    Temperament true_temperament;
+    for (int s = 0; s < instrument.number_of_strings; s++) {
+        std::vector<double> cents;
+        for (int fret = 0; fret <= instrument.number_of_frets; fret++) {
+            cents.push_back(((fret * 7 + s * 3) % 11 - 5) * 0.5);
+        }
+        true_temperament.set_offsets(s, cents);
+    }
+    Instrument tempered = instrument;
+    tempered.temperament = &true_temperament;
+    tempered.validate();
+    report(board, "Fretboard(Instrument)/tempered", measure(iterations, 1, [&]() {
+        Fretboard fretboard(tempered);
+        sink = sink + fretboard.board_shape().points[1].x;
+    }));
+
+    // Batches of the same board, serially and on every hardware thread
+    static ThreadPool serial(1);
+    std::vector<Instrument> order(256, instrument);
+    FretboardBatch batch;
+    ThreadPool* pools[] = { &serial, &ThreadPool::shared() };
+    for (ThreadPool* pool : pools) {
+        std::string name = "generate_batch/" + std::to_string(pool->thread_count());
+        report(board, name.c_str(), measure(iterations / 16 + 1, order.size(), [&]() {
+            generate_batch(order, batch, *pool);
+            sink = sink + batch[order.size() - 1].board_shape().points[1].x;
+        }));
+    }
+
+    // Layout search around the board, per candidate evaluated
+    LayoutSearch search(instrument);
+    search.perpendicular_fret_index = { 0, 12, 7 };
+    search.scale_length_treble = { instrument.scale_length[0] * 0.95, instrument.scale_length[0] * 1.05, 6 };
+    search.scale_length_bass = { instrument.scale_length[1] * 0.95, instrument.scale_length[1] * 1.1, 6 };
+    search.targets.max_fret_angle = { 10, 1, LayoutTargetKind::at_most };
+    search.targets.heel = { instrument.scale_length[1] * 0.75, 1 };
+    search.refinements = 0;
+    report(board, "optimize_layout", measure(iterations / 100 + 1, 7 * 6 * 6, [&]() {
+        sink = sink + optimize_layout(search).front().cost;
+    }));
+
+    // Sweeps, per point
+    NullBuffer null_buffer;
+    std::ostream null_stream(&null_buffer);
+    Sweep sweep(instrument);
+    sweep.add_axis("scale_length", instrument.scale_length[1] * 0.95, instrument.scale_length[1] * 1.05, 16, 1);
+    sweep.add_axis("perpendicular_fret_index", 0, 12, 16);
+    CsvSweepWriter csv_writer(null_stream);
+    report(board, "Sweep/csv", measure(iterations / 100 + 1, sweep.size(), [&]() {
+        sweep.run(csv_writer);
+    }));
+    ColumnarSweepWriter columnar_writer(null_stream);
+    report(board, "Sweep/columnar", measure(iterations / 100 + 1, sweep.size(), [&]() {
+        sweep.run(columnar_writer);
+    }));
+
+    // Incremental rebuilds after changing a single field, the way the preview does while editing
+    FretboardBuilder builder;
+    Instrument edited = instrument;
+    builder.build(edited);
+    report(board, "FretboardBuilder/fret_slots", measure(iterations, 1, [&]() {
+        edited.fret_slots_width = edited.fret_slots_width == instrument.fret_slots_width ? instrument.fret_slots_width * 1.5 : instrument.fret_slots_width;
+        sink = sink + builder.build(edited).fret_table().column(FretTable::shape_x0)[0];
+    }));
+    report(board, "FretboardBuilder/nut_thickness", measure(iterations, 1, [&]() {
+        edited.nut_thickness = edited.nut_thickness == instrument.nut_thickness ? instrument.nut_thickness * 1.5 : instrument.nut_thickness;
+        sink = sink + builder.build(edited).nut_shape().points[0].x;
+    }));
+    report(board, "FretboardBuilder/scale_length", measure(iterations, 1, [&]() {
+        edited.scale_length[0] = edited.scale_length[0] == instrument.scale_length[0] ? instrument.scale_length[0] * 1.01 : instrument.scale_length[0];
+        sink = sink + builder.build(edited).board_shape().points[1].x;
+    }));
+
+    Fretboard fretboard(instrument);
+    const auto& strings = fretboard.strings();
+    int frets = instrument.number_of_frets;
+
+    report(board, "String::point_at_fret", measure(iterations, strings.size() * (frets + 1), [&]() {
+        double sum = 0;
+        for (const auto& string : strings) {
+            for (int fret = 0; fret <= frets; fret++) {
+                sum += string.point_at_fret(fret).x;
+            }
+        }
+        sink = sink + sum;
+    }));
+
+    // Fractional indices (microtonal layouts, side dots...), one at a time and with the SIMD kernel
+    std::vector<double> indices;
+    for (int i = 0; i < 1024; i++) {
+        indices.push_back(i * frets / 1024.0 + 0.01);
+    }
+    std::vector<Point> points(strings.size() * indices.size());
+    report(board, "String::point_at_fret/fraction", measure(iterations / 100 + 1, points.size(), [&]() {
+        double sum = 0;
+        for (const auto& string : strings) {
+            for (double index : indices) {
+                sum += string.point_at_fret(index).x;
+            }
+        }
+        sink = sink + sum;
+    }));
+    report(board, "Fretboard::points_at_frets", measure(iterations / 100 + 1, points.size(), [&]() {
+        fretboard.points_at_frets(indices, points);
+        sink = sink + points[points.size() / 2].x;
+    }));
+
+    // Derivatives of the fret positions, exact and with central finite differences over the same parameters. The
+    // jacobian is reused, like an optimizer computing one per step does.
+    FretboardJacobian jacobian;
+    report(board, "Fretboard::jacobian", measure(iterations, 1, [&]() {
+        fretboard.jacobian(jacobian);
+        sink = sink + jacobian.string_point(0, 0, FretboardJacobian::scale_length_bass).x;
+    }));
+
+    struct { const char* name; int element; } parameters[] = {
+        { "scale_length", 0 }, { "scale_length", 1 }, { "perpendicular_fret_index", 0 },
+        { "inter_string_spacing_at_nut", 0 }, { "inter_string_spacing_at_bridge", 0 }
+    };
+    report(board, "jacobian/finite differences", measure(iterations / 10 + 1, 1, [&]() {
+        double sum = 0;
+        for (const auto& parameter : parameters) {
+            const InstrumentField* field = find_instrument_field(parameter.name);
+            for (double h : { 1e-5, -1e-5 }) {
+                Instrument changed = instrument;
+                field->set(changed, field->get(instrument, parameter.element) + h, parameter.element);
+                Fretboard other(changed);
+                for (const auto& string : other.strings()) {
+                    for (int fret = 0; fret <= frets; fret++) {
+                        sum += string.point_at_fret(fret).x;
+                    }
+                }
+                sum += other.fret_lines()[0].point1.x;
+            }
+        }
+        sink = sink + sum;
+    }));
+
+    // Fret cell lookups for probes spread over the whole board
+    FretboardLocator locator(fretboard);
+    std::vector<Point> probes;
+    const Quad& shape = fretboard.board_shape();
+    for (int i = 0; i < 4096; i++) {
+        double a = (i % 64) / 63.0;
+        double b = (i / 64) / 63.0;
+        Point top = shape.points[0] * (1 - a) + shape.points[1] * a;
+        Point bottom = shape.points[3] * (1 - a) + shape.points[2] * a;
+        probes.push_back(top * (1 - b) + bottom * b);
+    }
+    std::vector<FretboardLocation> locations(probes.size());
+    report(board, "FretboardLocator::locate", measure(iterations / 100 + 1, probes.size(), [&]() {
+        locator.locate(probes, locations);
+        sink = sink + locations[probes.size() / 2].u;
+    }));
+
+    // Same strings in single precision, for previews
+    std::vector<BasicString<float>> float_strings;
+    for (const auto& string : strings) {
+        float_strings.push_back(BasicString<float>(string.index(), float(string.scale_length()), float(string.perpendicular_fret_index()),
+                                                   float(string.y_at_start()), float(string.y_at_bridge()), instrument.has_zero_fret,
+                                                   float(string.nut_to_zero_fret_offset()), string.number_of_frets_per_octave()));
+    }
+
+    report(board, "String<float>::point_at_fret", measure(iterations, float_strings.size() * (frets + 1), [&]() {
+        float sum = 0;
+        for (const auto& string : float_strings) {
+            for (int fret = 0; fret <= frets; fret++) {
+                sum += string.point_at_fret(float(fret)).x;
+            }
+        }
+        sink = sink + sum;
+    }));
+
+    std::vector<Vector> string_lines;
+    for (const auto& string : strings) {
+        string_lines.push_back(string.line());
+    }
+    const auto& fret_lines = fretboard.fret_lines();
+
+    report(board, "Vector::intersection", measure(iterations, string_lines.size() * fret_lines.size(), [&]() {
+        double sum = 0;
+        for (const auto& fret_line : fret_lines) {
+            for (const auto& string_line : string_lines) {
+                sum += fret_line.intersection(string_line).x;
+            }
+        }
+        sink = sink + sum;
+    }));
+
+    // Strings against themselves rotated by a hair: every intersection goes through the exact path
+    report(board, "Vector::intersection/exact", measure(iterations, string_lines.size(), [&]() {
+        double sum = 0;
+        for (const auto& string_line : string_lines) {
+            Vector rotated(string_line.point1, string_line.point2 + Point(0, 1e-9));
+            Point p;
+            string_line.intersect(rotated, p);
+            sum += p.x;
+        }
+        sink = sink + sum;
+    }));
+
+    std::vector<Line2D> fret_lines_2d;
+    for (const auto& fret_line : fret_lines) {
+        fret_lines_2d.push_back(Line2D(fret_line));
+    }
+    std::vector<double> xs(fret_lines_2d.size());
+    std::vector<double> ys(fret_lines_2d.size());
+
+    report(board, "intersect(Line2D)", measure(iterations, string_lines.size() * fret_lines_2d.size(), [&]() {
+        double sum = 0;
+        for (const auto& string_line : string_lines) {
+            intersect(fret_lines_2d, Line2D(string_line), xs, ys);
+            sum += xs.back();
+        }
+        sink = sink + sum;
+    }));
+
+    // Reading the JSON form of the board, through the DOM and with the dedicated parser
+    std::string text = json(instrument).dump(4);
+    Instrument parsed;
+    report(board, "from_json(json::parse)", measure(iterations, 1, [&]() {
+        parsed = json::parse(text).get<Instrument>();
+        sink = sink + parsed.scale_length[0];
+    }));
+    report(board, "parse_instrument_json", measure(iterations, 1, [&]() {
+        parse_instrument_json(text.data(), text.data() + text.size(), parsed);
+        sink = sink + parsed.scale_length[0];
+    }));
+
+    // Loading the board from a JSON .frt and from a binary one
+    for (auto format : { InstrumentFileFormat::json, InstrumentFileFormat::binary }) {
+        bool binary = format == InstrumentFileFormat::binary;
+        std::string path = (std::filesystem::temp_directory_path() / (binary ? "fretboarderBench.bin.frt" : "fretboarderBench.frt")).string();
+        if (!instrument.save(path, format)) {
+            fprintf(stderr, "Unable to save \"%s\"\n", path.c_str());
+            continue;
+        }
+        Instrument loaded;
+        report(board, binary ? "Instrument::load/binary" : "Instrument::load/json", measure(iterations, 1, [&]() {
+            loaded.load(path);
+            sink = sink + loaded.scale_length[0];
+        }));
+        if (!binary) {
+            // What load() used to do, the reference for the bulk imports
+            report(board, "Instrument::load/json (DOM)", measure(iterations, 1, [&]() {
+                std::ifstream ifs(path);
+                json j;
+                ifs >> j;
+                loaded = j.get<Instrument>();
+                loaded.validate();
+                sink = sink + loaded.scale_length[0];
+            }));
+        }
+        std::filesystem::remove(path);
+    }
+
+    // 1024 lines of it through the NDJSON batch mode, stage after stage and pipelined
+    std::string lines;
+    for (int i = 0; i < 1024; i++) {
+        lines += json(instrument).dump() + "\n";
+    }
+    for (bool pipelined : { false, true }) {
+        NdjsonPipelineOptions options;
+        options.pipelined = pipelined;
+        report(board, pipelined ? "run_ndjson_pipeline/pipelined" : "run_ndjson_pipeline/sequential",
+               measure(iterations / 100 + 1, 1024, [&]() {
+            std::istringstream input(lines);
+            std::ostringstream output;
+            run_ndjson_pipeline(input, output, options);
+            sink = sink + double(output.tellp());
+        }));
+    }
+
+    // DXF export: formatting alone, then to a file
+    DxfWriter dxf_writer;
+    for (auto version : { DxfVersion::r12, DxfVersion::r2000 }) {
+        DxfOptions options;
+        options.version = version;
+        bool r2000 = version == DxfVersion::r2000;
+        report(board, r2000 ? "DxfWriter::write/r2000" : "DxfWriter::write/r12", measure(iterations, 1, [&]() {
+            dxf_writer.write(fretboard, null_stream, options);
+        }));
+    }
+    std::string dxf_path = (std::filesystem::temp_directory_path() / "fretboarderBench.dxf").string();
+    report(board, "DxfWriter::save", measure(iterations / 10 + 1, 1, [&]() {
+        dxf_writer.save(fretboard, dxf_path, DxfOptions());
+    }));
+    std::filesystem::remove(dxf_path);
+
+    // Full scale SVG templates, one board and 1024 of them in parallel, reusing the page buffers
+    SvgTemplate svg_template;
+    report(board, "SvgTemplate::generate", measure(iterations, 1, [&]() {
+        svg_template.generate(fretboard);
+        sink = sink + svg_template.page(0).size();
+    }));
+    std::vector<Instrument> svg_instruments(1024, instrument);
+    FretboardBatch svg_fretboards;
+    generate_batch(svg_instruments, svg_fretboards);
+    SvgTemplateBatch svg_templates;
+    report(board, "generate_svg_templates", measure(iterations / 100 + 1, svg_instruments.size(), [&]() {
+        generate_svg_templates(svg_fretboards, svg_templates);
+        sink = sink + svg_templates[0].page(0).size();
+    }));
+
+    // The same board among 4096 others in a library file
+    std::string path = (std::filesystem::temp_directory_path() / "fretboarderBench.frtlib").string();
+    InstrumentLibraryWriter writer;
+    for (int i = 0; i < 4096; i++) {
+        Instrument other = instrument;
+        other.scale_length[0] += i * 0.01;
+        writer.add(board.name + " #" + std::to_string(i), other);
+    }
+    if (!writer.save(path)) {
+        fprintf(stderr, "Unable to save \"%s\"\n", path.c_str());
+        return;
+    }
+    InstrumentLibrary library;
+    report(board, "InstrumentLibrary::open", measure(iterations, 1, [&]() {
+        library.open(path);
+        sink = sink + library.size();
+    }));
+    std::vector<std::string> names;
+    for (int i = 0; i < 4096; i += 64) {
+        names.push_back(board.name + " #" + std::to_string(i));
+    }
+    Instrument found;
+    report(board, "InstrumentLibrary::find", measure(iterations / 10 + 1, names.size(), [&]() {
+        for (const auto& name : names) {
+            library.find(name, found);
+            sink = sink + found.scale_length[0];
+        }
+    }));
+    library.close();
+    std::filesystem::remove(path);
+}
+
+int main(int argc, const char* argv[]) {
+    size_t iterations = 2000;
+    std::string directory = FRETBOARDER_BOARDS_DIR;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--iterations") && i + 1 < argc) {
+            iterations = std::max(1l, atol(argv[++i]));
+        } else if (!strcmp(argv[i], "--boards") && i + 1 < argc) {
+            directory = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--iterations N] [--boards DIR]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    auto boards = load_boards(directory);
+    if (boards.empty()) {
+        fprintf(stderr, "No boards to benchmark\n");
+        return 1;
+    }
+
+    printf("%-24s %-30s %12s %12s\n", "board", "benchmark", "ns/op", "allocs/op");
+    for (const auto& board : boards) {
+        bench_board(board, iterations);
+    }
+
+    return 0;
+}
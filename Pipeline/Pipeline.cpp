@@ -0,0 +1,84 @@
+//
+//  Pipeline.cpp
+//  Pipeline
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+// Batch mode for fretboarderLib: reads one Instrument JSON per line (NDJSON) and writes one line per fretboard with
+// its fret lines, fret slots, board shape and construction distances, see run_ndjson_pipeline().
+//
+// usage: fretboarderPipeline [--batch N] [--sequential] [--stats] [INPUT [OUTPUT]]
+//
+// INPUT and OUTPUT default to stdin and stdout. --stats prints the number of lines, fretboards and errors and the
+// throughput to stderr.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "NdjsonPipeline.hpp"
+
+using namespace fretboarder;
+
+int main(int argc, const char* argv[]) {
+    NdjsonPipelineOptions options;
+    bool print_stats = false;
+    std::vector<const char*> files;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--batch") && i + 1 < argc) {
+            options.batch_size = std::max(1l, atol(argv[++i]));
+        } else if (!strcmp(argv[i], "--sequential")) {
+            options.pipelined = false;
+        } else if (!strcmp(argv[i], "--stats")) {
+            print_stats = true;
+        } else if (argv[i][0] != '-' && files.size() < 2) {
+            files.push_back(argv[i]);
+        } else {
+            fprintf(stderr, "usage: %s [--batch N] [--sequential] [--stats] [INPUT [OUTPUT]]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::ifstream input_file;
+    if (files.size() > 0) {
+        input_file.open(files[0], std::ifstream::in | std::ifstream::binary);
+        if (!input_file.is_open()) {
+            fprintf(stderr, "Unable to read \"%s\"\n", files[0]);
+            return 1;
+        }
+    }
+    std::ofstream output_file;
+    if (files.size() > 1) {
+        output_file.open(files[1], std::ofstream::out | std::ofstream::binary);
+        if (!output_file.is_open()) {
+            fprintf(stderr, "Unable to write \"%s\"\n", files[1]);
+            return 1;
+        }
+    }
+    std::istream& input = files.size() > 0 ? input_file : std::cin;
+    std::ostream& output = files.size() > 1 ? output_file : std::cout;
+    std::ios::sync_with_stdio(false);
+
+    NdjsonPipelineStats stats;
+    auto start = std::chrono::steady_clock::now();
+    bool ok = run_ndjson_pipeline(input, output, options, &stats);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (print_stats) {
+        fprintf(stderr, "%zu lines, %zu fretboards, %zu errors in %.3fs (%.0f lines/s)\n",
+                stats.lines, stats.fretboards, stats.errors, seconds, seconds > 0 ? stats.lines / seconds : 0.0);
+    }
+    if (!ok) {
+        fprintf(stderr, "Unable to write the output\n");
+        return 1;
+    }
+    return 0;
+}
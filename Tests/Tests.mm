@@ -8,9 +8,31 @@
 
 #import <XCTest/XCTest.h>
 
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <random>
+#include <set>
+#include <sstream>
+
 #include "Fretboard.hpp"
 #include "String.hpp"
 #include "Geometry.hpp"
+#include "Dual.hpp"
+#include "FretKernel.hpp"
+#include "FretboardBatch.hpp"
+#include "FretboardBuilder.hpp"
+#include "FretboardLocator.hpp"
+#include "InstrumentFile.hpp"
+#include "InstrumentJson.hpp"
+#include "InstrumentLibrary.hpp"
+#include "LayoutOptimizer.hpp"
+#include "NdjsonPipeline.hpp"
+#include "DxfWriter.hpp"
+#include "SvgTemplate.hpp"
+#include "Sweep.hpp"
 
 using namespace fretboarder;
 
@@ -25,6 +47,12 @@ std::string filePath(const std::string& path) {
     return pp;
 }
 
+std::string temporaryFilePath(const std::string& name) {
+    std::string path = NSTemporaryDirectory().UTF8String;
+    path += "/" + name;
+    return path;
+}
+
 
 @implementation Tests
 
@@ -217,6 +245,1512 @@ std::string filePath(const std::string& path) {
 }
 
 
+- (void)testLine2DIntersection {
+    fretboarder::Vector v0(fretboarder::Point(0, 0), fretboarder::Point(1, 10));
+    fretboarder::Vector v1(fretboarder::Point(1, 0), fretboarder::Point(0, 10));
+
+    fretboarder::Point r;
+    XCTAssert(Line2D(v0).intersection(Line2D(v1), r));
+    XCTAssertEqualWithAccuracy(r.x, 0.5, 1e-12);
+    XCTAssertEqualWithAccuracy(r.y, 5, 1e-12);
+
+    // Parallel lines don't intersect
+    XCTAssertFalse(Line2D(0, 0, 1, 1).intersection(Line2D(0, 1, 2, 2), r));
+
+    // Batched version gives the same results as Vector::intersection
+    std::vector<Line2D> lines;
+    for (int i = 0; i < 10; i++) {
+        lines.push_back(Line2D(fretboarder::Point(i, -1), fretboarder::Point(i * 1.1, 1)));
+    }
+    fretboarder::Vector border(fretboarder::Point(-5, 0.5), fretboarder::Point(20, 0.7));
+    std::vector<double> xs(lines.size());
+    std::vector<double> ys(lines.size());
+    XCTAssert(intersect(lines, Line2D(border), xs, ys));
+    for (size_t i = 0; i < lines.size(); i++) {
+        fretboarder::Vector line(fretboarder::Point(lines[i].x, lines[i].y), fretboarder::Point(lines[i].x + lines[i].dx, lines[i].y + lines[i].dy));
+        fretboarder::Point e = line.intersection(border);
+        XCTAssertEqualWithAccuracy(xs[i], e.x, 1e-12);
+        XCTAssertEqualWithAccuracy(ys[i], e.y, 1e-12);
+    }
+}
+
+- (void)testRobustIntersection {
+    // Nearly parallel lines, the plain formula is off by 4e-9 (exact intersection computed with rationals)
+    fretboarder::Point p(0.1, 0.7);
+    fretboarder::Point d0(1, 1e-9);
+    fretboarder::Point d1(1, 1e-9 + 1e-20);
+    fretboarder::Vector v0(p - d0, p + d0);
+    fretboarder::Vector v1(p - d1 * 3.1, p + d1 * 1.3);
+
+    fretboarder::Point r;
+    XCTAssert(v0.intersect(v1, r) == IntersectionResult::found);
+    XCTAssertEqualWithAccuracy(r.x, 0.4571428586020409, 1e-15);
+    XCTAssertEqualWithAccuracy(r.y, 0.7000000003571428, 1e-15);
+
+    // Parallel and degenerated lines are reported instead of returning garbage
+    fretboarder::Vector v2(fretboarder::Point(0, 0), fretboarder::Point(1, 0x1p-10));
+    XCTAssert(v2.intersect(fretboarder::Vector(fretboarder::Point(0, 1), fretboarder::Point(1, 1 + 0x1p-10)), r) == IntersectionResult::parallel);
+    XCTAssert(v2.intersect(fretboarder::Vector(fretboarder::Point(2, 0x1p-9), fretboarder::Point(5, 5 * 0x1p-10)), r) == IntersectionResult::parallel);
+    XCTAssert(v0.intersect(fretboarder::Vector(p, p), r) == IntersectionResult::parallel);
+    XCTAssertFalse(v0.intersection(fretboarder::Vector(p, p), r));
+    XCTAssert(v0.intersect(fretboarder::Vector(fretboarder::Point(0, 0, 1), fretboarder::Point(1, 0, 1)), r) == IntersectionResult::not_coplanar);
+
+    // Same as the plain formula in the common case
+    fretboarder::Vector a(fretboarder::Point(0, 0), fretboarder::Point(1, 10));
+    fretboarder::Vector b(fretboarder::Point(1, 0), fretboarder::Point(0, 10));
+    XCTAssert(a.intersect(b, r) == IntersectionResult::found);
+    XCTAssertEqual(r.x, 0.5);
+    XCTAssertEqual(r.y, 5);
+
+    // Same for Line2D, one by one and batched. Their directions are the rounded differences of the points, which
+    // moves the intersection to x = 0.45714286567346946 (the plain formula gives 0.45714286284483208)
+    Line2D l0(v0);
+    XCTAssert(l0.intersection(Line2D(v1), r));
+    XCTAssertEqualWithAccuracy(r.x, 0.45714286567346946, 1e-15);
+    XCTAssertEqualWithAccuracy(r.y, 0.7000000003571428, 1e-15);
+    XCTAssertFalse(l0.intersection(Line2D(0, 1, l0.dx, l0.dy), r));
+    std::vector<Line2D> lines = { Line2D(v1), Line2D(0, 1, l0.dx, l0.dy) };
+    std::vector<double> xs(2, -1);
+    std::vector<double> ys(2, -1);
+    XCTAssertFalse(intersect(lines, l0, xs, ys));
+    XCTAssertEqualWithAccuracy(xs[0], 0.45714286567346946, 1e-15);
+    XCTAssertEqualWithAccuracy(ys[0], 0.7000000003571428, 1e-15);
+    XCTAssertEqual(xs[1], -1);
+
+    // Every board is fine, strings collapsed on a single line aren't
+    for (const char* name : { "breaking.frt", "breaking2.frt" }) {
+        Instrument instrument;
+        XCTAssert(instrument.load(filePath(name)));
+        XCTAssert(Fretboard(instrument).is_valid());
+    }
+    Instrument degenerated;
+    degenerated.scale_length[0] = degenerated.scale_length[1];
+    degenerated.inter_string_spacing_at_nut = 0;
+    degenerated.inter_string_spacing_at_bridge = 0;
+    degenerated.overhangs[0] = degenerated.overhangs[1] = degenerated.overhangs[2] = degenerated.overhangs[3] = 0;
+    degenerated.validate();
+    XCTAssertFalse(Fretboard(degenerated).is_valid());
+    XCTAssert(Fretboard(Instrument()).is_valid());
+}
+
+- (void)testFretTableColumns {
+    Instrument instrument;
+    Fretboard fretboard(instrument);
+    const FretTable& table = fretboard.fret_table();
+
+    XCTAssertEqual(table.size(), fretboard.fret_lines().size());
+    XCTAssertEqual(table.column(FretTable::line_x1).size(), table.size());
+    XCTAssertEqual(table.data().size(), table.size() * FretTable::column_count);
+
+    for (size_t i = 0; i < table.size(); i++) {
+        auto line = fretboard.fret_lines()[i];
+        auto slot = fretboard.fret_slots()[i];
+        auto shape = fretboard.fret_slot_shapes()[i];
+        XCTAssertEqual(table.column(FretTable::line_x1)[i], line.point1.x);
+        XCTAssertEqual(table.column(FretTable::line_y2)[i], line.point2.y);
+        XCTAssertEqual(table.column(FretTable::slot_y1)[i], slot.point1.y);
+        XCTAssertEqual(table.column(FretTable::slot_x2)[i], slot.point2.x);
+        XCTAssertEqual(table.column(FretTable::shape_x2)[i], shape.points[2].x);
+        XCTAssertEqual(table.column(FretTable::shape_y3)[i], shape.points[3].y);
+    }
+
+    FretTable copy = table;
+    XCTAssert(copy.slot(3).point1 == table.slot(3).point1);
+}
+
+- (void)testFretKernelInstructionSets {
+    std::vector<Instrument> instruments;
+    for (auto& preset : Preset::presets()) {
+        instruments.push_back(preset.instrument);
+    }
+    Instrument breaking;
+    XCTAssert(breaking.load(filePath("breaking.frt")));
+    instruments.push_back(breaking);
+
+    for (auto& instrument : instruments) {
+        set_fret_kernel_isa(FretKernelIsa::scalar);
+        Fretboard reference(instrument);
+
+        for (int isa = 1; isa <= int(fret_kernel_best_isa()); isa++) {
+            set_fret_kernel_isa(FretKernelIsa(isa));
+            Fretboard fretboard(instrument);
+            auto expected = reference.fret_table().data();
+            auto actual = fretboard.fret_table().data();
+            XCTAssertEqual(expected.size(), actual.size());
+            for (size_t i = 0; i < expected.size(); i++) {
+                XCTAssertEqualWithAccuracy(expected[i], actual[i], 1e-9);
+            }
+        }
+    }
+    set_fret_kernel_isa(fret_kernel_best_isa());
+
+    // Frets nearly parallel to a border are intersected exactly by every instruction set (see testRobustIntersection)
+    fretboarder::Point p(0.1, 0.7);
+    fretboarder::Point d0(1, 1e-9);
+    fretboarder::Point d1(1, 1e-9 + 1e-20);
+    Line2D border(p - d0, p + d0);
+    fretboarder::Point expected;
+    XCTAssert(Line2D(p - d1 * 3.1, p + d1 * 1.3).intersection(border, expected));
+    std::vector<double> t(7, 0.5);
+    FretKernelInput input;
+    input.first_start = p - d1 * 3.1;
+    input.last_start = p + d1 * 1.3;
+    input.first_t = t;
+    input.last_t = t;
+    input.first_border = input.last_border = input.first_tang_border = input.last_tang_border = border;
+    input.parts = fret_kernel_lines;
+    for (int isa = 0; isa <= int(fret_kernel_best_isa()); isa++) {
+        FretTable table;
+        table.resize(t.size());
+        build_frets(input, table, FretKernelIsa(isa));
+        for (size_t i = 0; i < t.size(); i++) {
+            XCTAssertEqual(table.column(FretTable::line_x1)[i], expected.x);
+            XCTAssertEqual(table.column(FretTable::slot_y2)[i], expected.y);
+        }
+    }
+}
+
+- (void)testFretRatioTables {
+    XCTAssert(FretRatioTable::get(12.5) == nullptr);
+    XCTAssert(FretRatioTable::get(0) == nullptr);
+    XCTAssert(FretRatioTable::get(19) == FretRatioTable::get(19));
+    static_assert(twelve_tet_ratios[FretRatioTable::octaves_below * 12] == 1.0, "ratio at the nut");
+    static_assert(twelve_tet_ratios[FretRatioTable::octaves_below * 12 + 12] == 0.5, "ratio at the octave");
+
+    for (double n : { 12.0, 19.0, 24.0, 31.0 }) {
+        const FretRatioTable* table = FretRatioTable::get(n);
+        XCTAssert(table != nullptr);
+        // Inside and outside of the precomputed range
+        for (int i = -10 * int(n); i <= 10 * int(n); i++) {
+            double expected = pow(2, -i / n);
+            XCTAssertEqualWithAccuracy(table->ratio(i), expected, expected * 1e-15);
+        }
+        XCTAssertEqualWithAccuracy(table->ratio(2.5), pow(2, -2.5 / n), 1e-15);
+    }
+
+    String string(0, 650, 0, 0, 0, false, 0);
+    for (int i = -24; i <= 36; i++) {
+        XCTAssertEqualWithAccuracy(string.distance_from_bridge(i), 650 / pow(2, i / 12.0), 1e-10);
+    }
+}
+
+- (void)testConstexprPresets {
+    constexpr Point p = Line2D(0, 0, 1, 10).intersection(Line2D(1, 0, -1, 10));
+    static_assert(p == Point(0.5, 5), "compile time intersection");
+    static_assert(builtin_presets[0].instrument.number_of_frets == 22, "Telecaster has 22 frets");
+    static_assert(builtin_presets[3].instrument.scale_length[0] == cmFromInch(34), "Jazz bass scale");
+
+    XCTAssertEqual(Preset::presets().size(), builtin_presets.size());
+    XCTAssert(std::string(Preset::presets()[0].name) == "Telecaster");
+}
+
+- (void)testFretboardBuilder {
+    FretboardBuilder builder;
+    Instrument instrument;
+    builder.build(instrument);
+    XCTAssertEqual(builder.last_stages(), unsigned(stage_all));
+
+    builder.build(instrument);
+    XCTAssertEqual(builder.last_stages(), 0u);
+
+    instrument.fret_slots_width = 0.08;
+    builder.build(instrument);
+    XCTAssertEqual(builder.last_stages(), unsigned(stage_fret_slot_shapes));
+
+    instrument.nut_thickness = 0.5;
+    builder.build(instrument);
+    XCTAssertEqual(builder.last_stages(), unsigned(stage_shapes | stage_construction_distances));
+
+    instrument.hidden_tang_length = 0.3;
+    builder.build(instrument);
+    XCTAssertEqual(builder.last_stages(), unsigned(stage_tang_borders | stage_fret_lines | stage_fret_slot_shapes));
+
+    instrument.fretboard_thickness = 1;
+    builder.build(instrument);
+    XCTAssertEqual(builder.last_stages(), 0u);
+    XCTAssertEqual(builder.fretboard().instrument().fretboard_thickness, 1);
+
+    // Fields no stage depends on still reach the fretboard
+    instrument.carve_nut_slot = !instrument.carve_nut_slot;
+    builder.build(instrument);
+    XCTAssertEqual(builder.last_stages(), 0u);
+    XCTAssertEqual(builder.fretboard().instrument().carve_nut_slot, instrument.carve_nut_slot);
+    instrument.carve_nut_slot = true;
+    builder.build(instrument);
+    std::ostringstream dxf;
+    DxfWriter().write(builder.fretboard(), dxf);
+    XCTAssert(dxf.str().find("NUT_SLOT") != std::string::npos);
+
+    // Whatever changed, the result must be the same as building from scratch
+    auto check = [&]() {
+        const Fretboard& updated = builder.build(instrument);
+        Fretboard reference(instrument);
+        auto expected = reference.fret_table().data();
+        auto actual = updated.fret_table().data();
+        XCTAssertEqual(expected.size(), actual.size());
+        for (size_t i = 0; i < expected.size() && i < actual.size(); i++) {
+            XCTAssertEqual(expected[i], actual[i]);
+        }
+        for (int i = 0; i < 4; i++) {
+            XCTAssert(reference.board_shape().points[i] == updated.board_shape().points[i]);
+            XCTAssert(reference.nut_shape().points[i] == updated.nut_shape().points[i]);
+            XCTAssert(reference.nut_slot_shape().points[i] == updated.nut_slot_shape().points[i]);
+            XCTAssert(reference.strings_shape().points[i] == updated.strings_shape().points[i]);
+        }
+        XCTAssertEqual(reference.construction_distance_at_heel(), updated.construction_distance_at_heel());
+        XCTAssertEqual(reference.construction_distance_at_12th_fret(), updated.construction_distance_at_12th_fret());
+        XCTAssertEqual(reference.construction_distance_at_octave(), updated.construction_distance_at_octave());
+    };
+
+    check();
+    instrument.number_of_frets = 36;
+    check();
+    instrument.number_of_strings = 15;
+    instrument.validate();
+    check();
+    instrument.overhangs[2] = 0.5;
+    check();
+    instrument.has_zero_fret = false;
+    instrument.validate();
+    check();
+    instrument.number_of_frets = 10;
+    check();
+    instrument.number_of_strings = 1;
+    instrument.validate();
+    check();
+    instrument.overhangs[0] = 1;
+    check();
+    instrument.last_fret_cut_offset = 0.5;
+    check();
+
+    // Nothing is built from instruments that aren't buildable, and everything is built after them
+    instrument.number_of_strings = 0;
+    XCTAssertFalse(instrument.is_buildable());
+    const Fretboard& empty = builder.build(instrument);
+    XCTAssertFalse(empty.is_valid());
+    XCTAssert(empty.strings().empty());
+    XCTAssertEqual(empty.fret_table().size(), size_t(0));
+    XCTAssertEqual(empty.jacobian().string_count(), size_t(0));
+    XCTAssertEqual(FretboardLocator(empty).locate(Point(1, 0)).inside, false);
+    instrument.number_of_strings = 6;
+    instrument.validate();
+    check();
+    XCTAssertEqual(builder.last_stages(), unsigned(stage_all));
+    XCTAssert(builder.fretboard().is_valid());
+    instrument.number_of_frets = 1001;
+    XCTAssert(instrument.build_error() != nullptr);
+    XCTAssertFalse(Fretboard(instrument).is_valid());
+}
+
+- (void)testArenaConstruction {
+    Instrument instrument;
+    instrument.number_of_strings = 15;
+    instrument.number_of_frets = 36;
+    instrument.validate();
+    Fretboard reference(instrument);
+
+    Arena arena(1024);
+    size_t capacity = 0;
+    for (int i = 0; i < 3; i++) {
+        arena.reset();
+        Fretboard fretboard(instrument, arena);
+        XCTAssert(fretboard.strings().get_allocator().arena() == &arena);
+        XCTAssertEqual(fretboard.strings().capacity(), fretboard.strings().size());
+        auto expected = reference.fret_table().data();
+        auto actual = fretboard.fret_table().data();
+        XCTAssertEqual(expected.size(), actual.size());
+        for (size_t j = 0; j < expected.size(); j++) {
+            XCTAssertEqual(expected[j], actual[j]);
+        }
+
+        // Once warmed up the arena doesn't need more memory
+        if (i == 0) {
+            capacity = arena.capacity();
+        }
+        XCTAssertEqual(arena.capacity(), capacity);
+        XCTAssert(arena.used() > 0);
+
+        // Copies don't depend on the arena
+        Fretboard copy = fretboard;
+        XCTAssert(copy.strings().get_allocator().arena() == nullptr);
+    }
+
+    void* p = arena.allocate(3, 1);
+    void* q = arena.allocate(8, 64);
+    XCTAssert(p != nullptr);
+    XCTAssertEqual(reinterpret_cast<uintptr_t>(q) % 64, uintptr_t(0));
+}
+
+- (void)testGenerateBatch {
+    std::vector<Instrument> instruments;
+    for (int i = 0; i < 100; i++) {
+        Instrument instrument = Preset::presets()[i % Preset::presets().size()].instrument;
+        instrument.number_of_strings = 4 + i % 12;
+        instrument.number_of_frets = 20 + i % 17;
+        instrument.validate();
+        instruments.push_back(instrument);
+    }
+
+    ThreadPool pool(4);
+    XCTAssertEqual(pool.thread_count(), size_t(4));
+
+    FretboardBatch batch;
+    for (int run = 0; run < 2; run++) {
+        generate_batch(instruments, batch, pool);
+        XCTAssertEqual(batch.size(), instruments.size());
+        for (size_t i = 0; i < instruments.size(); i++) {
+            Fretboard reference(instruments[i]);
+            XCTAssertEqual(batch[i].strings().size(), size_t(instruments[i].number_of_strings));
+            auto expected = reference.fret_table().data();
+            auto actual = batch[i].fret_table().data();
+            XCTAssertEqual(expected.size(), actual.size());
+            for (size_t j = 0; j < expected.size() && j < actual.size(); j++) {
+                XCTAssertEqual(expected[j], actual[j]);
+            }
+        }
+    }
+
+    // Every index is done exactly once, even when the work is uneven
+    std::vector<std::atomic<int>> done(1000);
+    pool.parallel_for(done.size(), 3, [&](size_t begin, size_t end, size_t worker) {
+        XCTAssert(worker < pool.thread_count());
+        for (size_t i = begin; i < end; i++) {
+            if (i < 100) {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+            done[i]++;
+        }
+    });
+    for (auto& count : done) {
+        XCTAssertEqual(count.load(), 1);
+    }
+}
+
+- (void)testLayoutOptimizer {
+    Instrument instrument;
+    instrument.number_of_strings = 7;
+    instrument.validate();
+
+    LayoutSearch search(instrument);
+    search.perpendicular_fret_index = { 0, 12, 13 };
+    search.scale_length_treble = { 63.5, 66, 6 };
+    search.scale_length_bass = { 63.5, 70, 14 };
+    search.targets.max_fret_angle = { 0, 1 };
+    search.best_count = 5;
+
+    // Straight frets only happen with a single scale length
+    auto best = optimize_layout(search);
+    XCTAssertEqual(best.size(), size_t(5));
+    XCTAssertEqual(best[0].cost, 0);
+    XCTAssertEqual(best[0].instrument.scale_length[0], best[0].instrument.scale_length[1]);
+    for (size_t i = 1; i < best.size(); i++) {
+        XCTAssert(best[i - 1].cost <= best[i].cost);
+    }
+
+    // Fanned frets, but not too much, with the heel at a given distance
+    search.targets.max_fret_angle = { 8, 1, LayoutTargetKind::at_most };
+    search.targets.bridge_angle = { 6, 1, LayoutTargetKind::at_least };
+    search.targets.heel = { 49.2, 1 };
+    ThreadPool serial(1);
+    ThreadPool pool(3);
+    auto expected = optimize_layout(search, serial);
+    auto actual = optimize_layout(search, pool);
+    XCTAssertEqual(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size() && i < actual.size(); i++) {
+        XCTAssertEqual(expected[i].cost, actual[i].cost);
+        XCTAssertEqual(expected[i].instrument.perpendicular_fret_index, actual[i].instrument.perpendicular_fret_index);
+        XCTAssertEqual(expected[i].instrument.scale_length[1], actual[i].instrument.scale_length[1]);
+    }
+
+    LayoutMetrics metrics = measure_layout(Fretboard(actual[0].instrument));
+    XCTAssertEqual(metrics.heel, actual[0].metrics.heel);
+    XCTAssert(metrics.max_fret_angle <= 8.5);
+    XCTAssert(metrics.bridge_angle >= 5.5);
+    XCTAssertEqualWithAccuracy(metrics.heel, 49.2, 0.5);
+
+    // Strings meeting at the nut: no nut, the narrowest one, but not a fretboard
+    LayoutSearch narrow(instrument);
+    narrow.inter_string_spacing_at_nut = { 0, 1, 5 };
+    narrow.targets.nut_width = { 0, 1 };
+    narrow.best_count = 3;
+    Instrument degenerated = instrument;
+    degenerated.inter_string_spacing_at_nut = 0;
+    degenerated.validate();
+    XCTAssertFalse(Fretboard(degenerated).is_valid());
+    best = optimize_layout(narrow);
+    XCTAssertEqual(best.size(), size_t(3));
+    for (const auto& candidate : best) {
+        XCTAssert(candidate.instrument.inter_string_spacing_at_nut > 0);
+        XCTAssert(Fretboard(candidate.instrument).is_valid());
+    }
+}
+
+- (void)testSweep {
+    Instrument instrument;
+    Sweep sweep(instrument);
+    XCTAssert(sweep.add_axis("scale_length", 63, 66, 3, 1));
+    XCTAssert(sweep.add_axis("number_of_frets", 20, 24, 2));
+    XCTAssert(sweep.add_axis("perpendicular_fret_index", 0, 7, 2));
+    XCTAssertFalse(sweep.add_axis("scale_length", 63, 66, 3, 2));
+    XCTAssertFalse(sweep.add_axis("no_such_field", 0, 1, 2));
+    XCTAssertFalse(sweep.add_axis("temperament", 0, 1, 2));
+    XCTAssertEqual(sweep.size(), size_t(12));
+
+    auto columns = sweep.columns();
+    XCTAssertEqual(columns[0], "scale_length[1]");
+    XCTAssertEqual(columns[1], "number_of_frets");
+    XCTAssertEqual(columns[4], "construction_distance_at_heel");
+
+    // Last axis varies the fastest
+    Instrument point = sweep.instrument(7);
+    XCTAssertEqual(point.scale_length[1], 64.5);
+    XCTAssertEqual(point.number_of_frets, 24);
+    XCTAssertEqual(point.perpendicular_fret_index, 7);
+
+    ThreadPool pool(2);
+    std::ostringstream csv;
+    CsvSweepWriter csv_writer(csv);
+    XCTAssert(sweep.run(csv_writer, pool, 5));
+    std::istringstream lines(csv.str());
+    std::string line;
+    std::vector<std::string> rows;
+    while (std::getline(lines, line)) {
+        rows.push_back(line);
+    }
+    XCTAssertEqual(rows.size(), size_t(13));
+    Fretboard fretboard(point);
+    std::vector<double> values;
+    std::istringstream row(rows[8]);
+    std::string value;
+    while (std::getline(row, value, ',')) {
+        values.push_back(strtod(value.c_str(), nullptr));
+    }
+    XCTAssertEqual(values.size(), columns.size());
+    XCTAssertEqual(values[1], 24);
+    XCTAssertEqual(values[3], fretboard.construction_distance_at_nut_side());
+    XCTAssertEqual(values.back(), 1);
+    XCTAssertEqual(columns.back(), "valid");
+
+    std::ostringstream binary;
+    ColumnarSweepWriter binary_writer(binary);
+    XCTAssert(sweep.run(binary_writer, pool, 5));
+    std::string data = binary.str();
+    XCTAssertEqual(data.substr(0, 8), "FRTSWEEP");
+    uint32_t column_count;
+    memcpy(&column_count, data.data() + 12, 4);
+    XCTAssertEqual(column_count, uint32_t(columns.size()));
+    size_t offset = 16;
+    for (size_t c = 0; c < column_count; c++) {
+        uint32_t length;
+        memcpy(&length, data.data() + offset, 4);
+        XCTAssertEqual(data.substr(offset + 4, length), columns[c]);
+        offset += 4 + length;
+    }
+    std::vector<uint64_t> chunks;
+    std::vector<double> heels;
+    for (;;) {
+        uint64_t rows;
+        memcpy(&rows, data.data() + offset, 8);
+        offset += 8;
+        chunks.push_back(rows);
+        if (!rows) {
+            break;
+        }
+        for (size_t r = 0; r < rows; r++) {
+            double heel;
+            memcpy(&heel, data.data() + offset + (4 * rows + r) * sizeof(double), sizeof(double));
+            heels.push_back(heel);
+        }
+        offset += rows * column_count * sizeof(double);
+    }
+    XCTAssertEqual(offset, data.size());
+    XCTAssertEqual(chunks, std::vector<uint64_t>({ 5, 5, 2, 0 }));
+    XCTAssertEqual(heels[7], fretboard.construction_distance_at_heel());
+
+    // Points with no strings aren't built, their metrics are NaN
+    Sweep strings(instrument);
+    XCTAssert(strings.add_axis("number_of_strings", 0, 6, 7));
+    std::ostringstream strings_csv;
+    CsvSweepWriter strings_writer(strings_csv);
+    XCTAssert(strings.run(strings_writer, pool));
+    std::istringstream strings_lines(strings_csv.str());
+    rows.clear();
+    while (std::getline(strings_lines, line)) {
+        rows.push_back(line);
+    }
+    XCTAssertEqual(rows.size(), size_t(8));
+    for (size_t r = 1; r < rows.size(); r++) {
+        values.clear();
+        std::istringstream row(rows[r]);
+        while (std::getline(row, value, ',')) {
+            values.push_back(strtod(value.c_str(), nullptr));
+        }
+        XCTAssertEqual(values[0], r - 1);
+        XCTAssertEqual(std::isnan(values[1]), r == 1);
+        XCTAssertEqual(values.back(), r == 1 ? 0 : 1);
+    }
+}
+
+- (void)testScalarTypes {
+    String reference(2, 64.77, 7, 2.15, 3.5, true, 0.3);
+    BasicString<float> fast(2, 64.77f, 7, 2.15f, 3.5f, true, 0.3f);
+    BasicString<long double> audit(2, 64.77L, 7, 2.15L, 3.5L, true, 0.3L);
+    for (int fret = 0; fret <= 24; fret++) {
+        Point expected = reference.point_at_fret(fret);
+        XCTAssertEqualWithAccuracy(fast.point_at_fret(fret).x, expected.x, 1e-4);
+        XCTAssertEqualWithAccuracy(fast.point_at_fret(fret).y, expected.y, 1e-4);
+        XCTAssertEqualWithAccuracy(double(audit.point_at_fret(fret).x), expected.x, 1e-12);
+        XCTAssertEqualWithAccuracy(double(audit.point_at_fret(fret).y), expected.y, 1e-12);
+    }
+
+    // Derivatives with respect to the scale length and the perpendicular fret, checked with finite differences
+    typedef Dual<double, 2> D;
+    const double scale_length = 64.77;
+    const double perpendicular = 7.5;
+    BasicString<D> dual(2, D::variable(scale_length, 0), D::variable(perpendicular, 1), 2.15, 3.5, true, 0.3);
+    const double h = 1e-6;
+    String longer(2, scale_length + h, perpendicular, 2.15, 3.5, true, 0.3);
+    String shorter(2, scale_length - h, perpendicular, 2.15, 3.5, true, 0.3);
+    String after(2, scale_length, perpendicular + h, 2.15, 3.5, true, 0.3);
+    String before(2, scale_length, perpendicular - h, 2.15, 3.5, true, 0.3);
+    for (int fret = 0; fret <= 24; fret++) {
+        BasicPoint<D> p = dual.point_at_fret(fret);
+        XCTAssertEqualWithAccuracy(p.x.value, String(2, scale_length, perpendicular, 2.15, 3.5, true, 0.3).point_at_fret(fret).x, 1e-12);
+        XCTAssertEqualWithAccuracy(p.x.derivative(0), (longer.point_at_fret(fret).x - shorter.point_at_fret(fret).x) / (2 * h), 1e-6);
+        XCTAssertEqualWithAccuracy(p.y.derivative(0), (longer.point_at_fret(fret).y - shorter.point_at_fret(fret).y) / (2 * h), 1e-6);
+        XCTAssertEqualWithAccuracy(p.x.derivative(1), (after.point_at_fret(fret).x - before.point_at_fret(fret).x) / (2 * h), 1e-6);
+    }
+
+    // Geometry works the same way
+    BasicVector<D> a(BasicPoint<D>(D::variable(1, 0), 0), BasicPoint<D>(1, 1));
+    BasicVector<D> b(BasicPoint<D>(0, 0.5), BasicPoint<D>(2, 0.5));
+    BasicPoint<D> i = a.intersection(b);
+    XCTAssertEqual(i.x.value, 1);
+    XCTAssertEqual(i.x.derivative(0), 0.5);
+    XCTAssertEqual(i.y.derivative(0), 0);
+}
+
+- (void)testFretboardJacobian {
+    // Equal temperament, and tempered outer strings to have different fret positions at both ends of the fret lines
+    // and around the perpendicular fret. Not on a fret, where the slope of the tempered ratios changes.
+    Temperament temperament;
+    temperament.set_offsets(0, { 0, 3.5, -2, 1.5, -4, 2, 0.5, 0, -1, 2.5, -3, 1 });
+    temperament.set_offsets(6, { 0, -1.5, 2, -2.5, 3, -0.5, 1, 0, 1.5, -2, 0.5, -1 });
+    // Perpendicular fret behind the nut, between frets for the same reason, a single string between fake ones and left
+    // handed
+    Instrument instruments[4];
+    for (Instrument& instrument : instruments) {
+        instrument.number_of_strings = 7;
+        instrument.scale_length[1] = 68.58;
+        instrument.perpendicular_fret_index = 7.25;
+    }
+    instruments[1].perpendicular_fret_index = -2.5;
+    instruments[2].number_of_strings = 1;
+    instruments[3].right_handed = false;
+    // Reused from one fretboard to the next
+    FretboardJacobian jacobian;
+    for (Instrument& instrument : instruments) for (const Temperament* t : { (const Temperament*)nullptr, (const Temperament*)&temperament }) {
+        instrument.temperament = t;
+        instrument.validate();
+        Fretboard fretboard(instrument);
+        fretboard.jacobian(jacobian);
+        XCTAssertEqual(jacobian.string_count(), fretboard.strings().size());
+        XCTAssertEqual(jacobian.fret_count(), fretboard.fret_table().size());
+
+        // Central finite differences
+        const double h = 1e-5;
+        for (int parameter = 0; parameter < FretboardJacobian::parameter_count; parameter++) {
+            Instrument plus = instrument;
+            Instrument minus = instrument;
+            double* values[2] = { nullptr, nullptr };
+            switch (parameter) {
+                case FretboardJacobian::scale_length_treble: values[0] = &plus.scale_length[0]; values[1] = &minus.scale_length[0]; break;
+                case FretboardJacobian::scale_length_bass: values[0] = &plus.scale_length[1]; values[1] = &minus.scale_length[1]; break;
+                case FretboardJacobian::perpendicular_fret_index: values[0] = &plus.perpendicular_fret_index; values[1] = &minus.perpendicular_fret_index; break;
+                case FretboardJacobian::inter_string_spacing_at_nut: values[0] = &plus.inter_string_spacing_at_nut; values[1] = &minus.inter_string_spacing_at_nut; break;
+                case FretboardJacobian::inter_string_spacing_at_bridge: values[0] = &plus.inter_string_spacing_at_bridge; values[1] = &minus.inter_string_spacing_at_bridge; break;
+            }
+            *values[0] += h;
+            *values[1] -= h;
+            plus.validate();
+            minus.validate();
+            Fretboard after(plus);
+            Fretboard before(minus);
+
+            auto p = FretboardJacobian::Parameter(parameter);
+            for (size_t fret = 0; fret < jacobian.fret_count(); fret++) {
+                int index = int(fret) + (instrument.has_zero_fret ? 0 : 1);
+                for (size_t string = 0; string < jacobian.string_count(); string++) {
+                    Point expected = (after.strings()[string].point_at_fret(index) - before.strings()[string].point_at_fret(index)) * (1 / (2 * h));
+                    XCTAssertEqualWithAccuracy(jacobian.string_point(string, fret, p).x, expected.x, 1e-5);
+                    XCTAssertEqualWithAccuracy(jacobian.string_point(string, fret, p).y, expected.y, 1e-5);
+                }
+                Vector line = jacobian.fret_line(fret, p);
+                Point expected1 = (after.fret_lines()[fret].point1 - before.fret_lines()[fret].point1) * (1 / (2 * h));
+                Point expected2 = (after.fret_lines()[fret].point2 - before.fret_lines()[fret].point2) * (1 / (2 * h));
+                XCTAssertEqualWithAccuracy(line.point1.x, expected1.x, 1e-5);
+                XCTAssertEqualWithAccuracy(line.point1.y, expected1.y, 1e-5);
+                XCTAssertEqualWithAccuracy(line.point2.x, expected2.x, 1e-5);
+                XCTAssertEqualWithAccuracy(line.point2.y, expected2.y, 1e-5);
+            }
+        }
+    }
+}
+
+
+- (void)testFretboardLocator {
+    Instrument instrument;
+    instrument.scale_length[0] = 640;
+    instrument.scale_length[1] = 690;
+    instrument.perpendicular_fret_index = 7;
+    instrument.validate();
+    Fretboard fretboard(instrument);
+    FretboardLocator locator(fretboard);
+    const auto& strings = fretboard.strings();
+    XCTAssertEqual(locator.fret_count(), fretboard.fret_table().size());
+    XCTAssertEqual(locator.string_count(), strings.size());
+
+    // Center of every cell, from the points of the strings at the frets around it
+    std::vector<fretboarder::Point> points;
+    for (size_t fret = 0; fret + 1 < locator.fret_count(); fret++) {
+        for (size_t string = 0; string + 1 < strings.size(); string++) {
+            fretboarder::Point center;
+            for (size_t f = fret; f <= fret + 1; f++) {
+                for (size_t s = string; s <= string + 1; s++) {
+                    center = center + strings[s].point_at_fret(int(f)) * 0.25;
+                }
+            }
+            points.push_back(center);
+        }
+    }
+    std::vector<FretboardLocation> locations(points.size());
+    locator.locate(points, locations);
+    size_t i = 0;
+    for (size_t fret = 0; fret + 1 < locator.fret_count(); fret++) {
+        for (size_t string = 0; string + 1 < strings.size(); string++, i++) {
+            XCTAssert(locations[i].inside);
+            XCTAssertEqual(locations[i].fret, int(fret));
+            XCTAssertEqual(locations[i].string_gap, int(string));
+            XCTAssertEqualWithAccuracy(locations[i].u, 0.5, 1e-9);
+            XCTAssertEqualWithAccuracy(locations[i].v, 0.5, 1e-9);
+        }
+    }
+
+    // Points on the strings at the frets are on the edges of the cells
+    FretboardLocation location = locator.locate(strings[1].point_at_fret(3) * 0.999 + strings[2].point_at_fret(4) * 0.001);
+    XCTAssertEqual(location.fret, 3);
+    XCTAssertEqual(location.string_gap, 1);
+    XCTAssertEqualWithAccuracy(location.u, 0.001, 0.001);
+    XCTAssertEqualWithAccuracy(location.v, 0.001, 0.001);
+
+    // Outside of the strings and frets
+    location = locator.locate(strings[0].point_at_nut() - fretboarder::Point(10, 0));
+    XCTAssertFalse(location.inside);
+    XCTAssertEqual(location.fret, -1);
+    location = locator.locate(strings[0].point_at_bridge());
+    XCTAssertFalse(location.inside);
+    XCTAssertEqual(location.fret, int(locator.fret_count()) - 1);
+
+    // Same as a linear scan for points all over the fretboard
+    const Quad& board = fretboard.board_shape();
+    for (int k = 0; k < 1000; k++) {
+        double a = (k % 37) / 36.0;
+        double b = (k / 37) / 27.0;
+        fretboarder::Point top = board.points[0] * (1 - a) + board.points[1] * a;
+        fretboarder::Point bottom = board.points[3] * (1 - a) + board.points[2] * a;
+        fretboarder::Point p = top * (1 - b) + bottom * b;
+        location = locator.locate(p);
+        int fret = -1;
+        for (const auto& line : fretboard.fret_lines()) {
+            fretboarder::Point d = line.point2 - line.point1;
+            fretboarder::Point along = strings[0].point_at_bridge() - strings[0].point_at_nut();
+            double side = (d.x * (p.y - line.point1.y) - d.y * (p.x - line.point1.x)) * (d.x * along.y - d.y * along.x);
+            fret += side >= 0 ? 1 : 0;
+        }
+        XCTAssertEqual(location.fret, fret);
+    }
+
+    // Curved frets: the cells are bounded by the segments of the fret polylines, not by the fret lines
+    Temperament temperament;
+    temperament.set_offsets(2, { 0, 15, -15, 15, -15, 15, -15, 15, -15, 15, -15, 15, -15 });
+    instrument.temperament = &temperament;
+    Fretboard curved(instrument);
+    XCTAssert(curved.has_curved_frets());
+    FretboardLocator curved_locator(curved);
+    const auto& curved_strings = curved.strings();
+    for (size_t fret = 0; fret + 1 < curved_locator.fret_count(); fret++) {
+        for (size_t string = 0; string + 1 < curved_strings.size(); string++) {
+            fretboarder::Point a = curved_strings[string].point_at_fret(int(fret));
+            fretboarder::Point b = curved_strings[string].point_at_fret(int(fret) + 1);
+            fretboarder::Point c = curved_strings[string + 1].point_at_fret(int(fret) + 1);
+            fretboarder::Point d = curved_strings[string + 1].point_at_fret(int(fret));
+            for (double u : { 0.02, 0.5, 0.98 }) {
+                for (double v : { 0.02, 0.5, 0.98 }) {
+                    fretboarder::Point p = a * ((1 - u) * (1 - v)) + b * (u * (1 - v)) + c * (u * v) + d * ((1 - u) * v);
+                    location = curved_locator.locate(p);
+                    XCTAssert(location.inside);
+                    XCTAssertEqual(location.fret, int(fret));
+                    XCTAssertEqual(location.string_gap, int(string));
+                    XCTAssertEqualWithAccuracy(location.u, u, 1e-9);
+                    XCTAssertEqualWithAccuracy(location.v, v, 1e-9);
+                }
+            }
+        }
+    }
+}
+
+- (void)testPointsAtFrets {
+    for (double x = -60; x <= 60; x += 0.0137) {
+        XCTAssertEqualWithAccuracy(fret_kernel_exp2(x) / exp2(x), 1, 1e-12);
+    }
+
+    Instrument instrument;
+    instrument.scale_length[0] = 640;
+    instrument.scale_length[1] = 690;
+    instrument.perpendicular_fret_index = 7;
+    instrument.validate();
+    Fretboard fretboard(instrument);
+    const auto& strings = fretboard.strings();
+
+    // Odd count so that every version leaves some indices to the scalar one
+    std::vector<double> indices;
+    for (double index = -12; index <= 36; index += 0.137) {
+        indices.push_back(index);
+    }
+    indices.push_back(100);
+    std::vector<fretboarder::Point> points(indices.size());
+    for (int isa = 0; isa <= int(fret_kernel_best_isa()); isa++) {
+        set_fret_kernel_isa(FretKernelIsa(isa));
+        for (const auto& string : strings) {
+            string.points_at_frets(indices, points);
+            for (size_t i = 0; i < indices.size(); i++) {
+                fretboarder::Point e = string.point_at_fret(indices[i]);
+                XCTAssertEqualWithAccuracy(points[i].x, e.x, 1e-9 * string.scale_length());
+                XCTAssertEqualWithAccuracy(points[i].y, e.y, 1e-9 * string.scale_length());
+            }
+            XCTAssert(points.back() == string.point_at_bridge());
+        }
+    }
+    set_fret_kernel_isa(fret_kernel_best_isa());
+
+    // Every string, string after string
+    std::vector<fretboarder::Point> all(strings.size() * indices.size());
+    fretboard.points_at_frets(indices, all);
+    for (size_t s = 0; s < strings.size(); s++) {
+        strings[s].points_at_frets(indices, points);
+        XCTAssert(std::equal(points.begin(), points.end(), all.begin() + s * indices.size()));
+    }
+}
+
+- (void)testTemperament {
+    Instrument instrument;
+    instrument.perpendicular_fret_index = 7;
+    instrument.validate();
+    Fretboard equal(instrument);
+    auto same_line = [](const Vector& a, const Vector& b) { return a.point1 == b.point1 && a.point2 == b.point2; };
+
+    // Untouched 12-TET is the same as no temperament
+    Temperament twelve;
+    instrument.temperament = &twelve;
+    instrument.validate();
+    Fretboard tempered(instrument);
+    for (size_t fret = 0; fret < equal.fret_lines().size(); fret++) {
+        XCTAssert(same_line(tempered.fret_lines()[fret], equal.fret_lines()[fret]));
+    }
+    for (size_t s = 0; s < equal.strings().size(); s++) {
+        for (int fret = -12; fret <= 100; fret++) {
+            XCTAssert(tempered.strings()[s].point_at_fret(fret) == equal.strings()[s].point_at_fret(fret));
+        }
+    }
+
+    // No shared table for these, they still give equal divisions
+    XCTAssertEqual(Temperament(0).frets_per_octave(), 1);
+    XCTAssertEqual(Temperament(-5).ratio(0, 1), 0.5);
+    Temperament fine(1201);
+    XCTAssertEqual(fine.frets_per_octave(), 1201);
+    XCTAssertEqual(fine.ratio(0, 1201), 0.5);
+    XCTAssertEqualWithAccuracy(fine.ratio(0, 100), pow(2, -100.0 / 1201), 1e-15);
+
+    // Just major scale, 7 frets per octave
+    Temperament major = Temperament::just({ 9.0 / 8, 5.0 / 4, 4.0 / 3, 3.0 / 2, 5.0 / 3, 15.0 / 8 });
+    XCTAssertEqual(major.frets_per_octave(), 7);
+    instrument.temperament = &major;
+    instrument.validate();
+    XCTAssertEqual(instrument.number_of_frets_per_octave, 7);
+    Fretboard just(instrument);
+    for (const auto& string : just.strings()) {
+        double l = string.scale_length();
+        XCTAssertEqualWithAccuracy(string.distance_from_start(2), l / 5, 1e-12 * l);
+        XCTAssertEqualWithAccuracy(string.distance_from_start(4), l / 3, 1e-12 * l);
+        XCTAssertEqualWithAccuracy(string.distance_from_start(7), l / 2, 1e-12 * l);
+        XCTAssertEqualWithAccuracy(string.distance_from_start(11), l * 2 / 3, 1e-12 * l);
+        XCTAssertEqualWithAccuracy(string.distance_from_start(-7), -l, 1e-12 * l);
+    }
+
+    // Per string offsets, they don't accumulate
+    Temperament offsets;
+    offsets.set_offsets(2, { 0, 0, 0, 0, 0, 50 });
+    offsets.set_offsets(2, { 0, 0, 0, 0, 0, 10 });
+    XCTAssertEqual(offsets.ratio(2, 5), twelve.ratio(2, 5) * pow(2, -10.0 / 1200));
+    XCTAssertEqual(offsets.ratio(2, 6), twelve.ratio(2, 6));
+    XCTAssertEqual(offsets.ratio(3, 5), twelve.ratio(3, 5));
+    XCTAssertEqual(offsets.table(0), offsets.table(5));
+    instrument.temperament = &offsets;
+    instrument.validate();
+    FretboardBuilder builder;
+    const Fretboard& built = builder.build(instrument);
+    for (size_t s = 0; s < built.strings().size(); s++) {
+        const String& string = built.strings()[s];
+        for (int fret = 0; fret <= instrument.number_of_frets; fret++) {
+            double expected = string.scale_length() * pow(2, -fret / 12.0) * (s == 2 && fret == 5 ? pow(2, -10.0 / 1200) : 1);
+            XCTAssertEqualWithAccuracy(string.distance_from_bridge(fret), expected, 1e-12 * expected);
+        }
+    }
+    // Between frets, the ratios are interpolated from the tempered ones
+    const String& offset = built.strings()[2];
+    double between = offset.scale_length() * sqrt(offsets.ratio(2, 4) * offsets.ratio(2, 5));
+    XCTAssertEqualWithAccuracy(offset.distance_from_bridge(4.5), between, 1e-12 * between);
+    XCTAssertEqualWithAccuracy(offsets.table(2)->ratio(5.25), pow(offsets.ratio(2, 5), 0.75) * pow(offsets.ratio(2, 6), 0.25), 1e-15);
+    // The tempered strings fall back to point_at_fret()
+    std::vector<double> indices = { 4, 5, 5.5 };
+    std::vector<fretboarder::Point> points(indices.size());
+    built.strings()[2].points_at_frets(indices, points);
+    for (size_t i = 0; i < indices.size(); i++) {
+        XCTAssert(points[i] == built.strings()[2].point_at_fret(indices[i]));
+    }
+
+    // Offsetting an outer string moves one end of its fret line, and the builder sees the temperament change
+    offsets.set_offsets(0, { 0, 0, 0, 20 });
+    Temperament outer(std::move(offsets));
+    instrument.temperament = &outer;
+    const Fretboard& rebuilt = builder.build(instrument);
+    XCTAssertFalse(same_line(rebuilt.fret_lines()[3], equal.fret_lines()[3]));
+    XCTAssert(same_line(rebuilt.fret_lines()[4], equal.fret_lines()[4]));
+}
+
+- (void)testCurvedFrets {
+    Instrument instrument;
+    Fretboard straight(instrument);
+    XCTAssertFalse(straight.has_curved_frets());
+    XCTAssert(straight.fret_polylines().empty());
+
+    Temperament temperament;
+    temperament.set_offsets(3, { 0, 10, -10, 5, -5, 15, -15, 8, -8, 4, -4, 12 });
+    instrument.temperament = &temperament;
+    FretboardBuilder builder;
+    const Fretboard& fretboard = builder.build(instrument);
+    XCTAssert(fretboard.has_curved_frets());
+
+    const auto& strings = fretboard.strings();
+    const auto& polylines = fretboard.fret_polylines();
+    const auto& slots = fretboard.fret_slot_polylines();
+    const auto& outlines = fretboard.fret_slot_outlines();
+    XCTAssertEqual(polylines.size(), fretboard.fret_lines().size());
+    XCTAssertEqual(slots.size(), polylines.size());
+    XCTAssertEqual(outlines.size(), polylines.size());
+    XCTAssertEqual(polylines.points().size(), polylines.size() * (strings.size() + 2));
+
+    auto distance = [](const Point& p, const Point& a, const Point& b) {
+        Point d = b - a;
+        return ((p.x - a.x) * d.y - (p.y - a.y) * d.x) / sqrt(d.x * d.x + d.y * d.y);
+    };
+    double half_width = instrument.fret_slots_width / 2;
+    for (size_t fret = 0; fret < polylines.size(); fret++) {
+        auto line = polylines[fret];
+        auto slot = slots[fret];
+        auto outline = outlines[fret];
+        XCTAssertEqual(line.size(), strings.size() + 2);
+        XCTAssertEqual(outline.size(), slot.size() * 2);
+        for (size_t s = 0; s < strings.size(); s++) {
+            XCTAssert(line[s + 1] == strings[s].point_at_fret(int(fret)));
+            XCTAssert(slot[s + 1] == line[s + 1]);
+        }
+
+        // The ends are on the borders, along the segments to the outer strings
+        const Quad& board = fretboard.board_shape();
+        Vector table_slot = fretboard.fret_slots()[fret];
+        Point first_tang = table_slot.point1 + (board.points[1] - board.points[0]);
+        Point last_tang = table_slot.point2 + (board.points[2] - board.points[3]);
+        size_t n = slot.size();
+        XCTAssertEqualWithAccuracy(distance(line[0], board.points[0], board.points[1]), 0, 1e-12);
+        XCTAssertEqualWithAccuracy(distance(line[n - 1], board.points[3], board.points[2]), 0, 1e-12);
+        XCTAssertEqualWithAccuracy(distance(line[0], line[1], line[2]), 0, 1e-12);
+        XCTAssertEqualWithAccuracy(distance(line[n - 1], line[n - 3], line[n - 2]), 0, 1e-12);
+        XCTAssertEqualWithAccuracy(distance(slot[0], table_slot.point1, first_tang), 0, 1e-12);
+        XCTAssertEqualWithAccuracy(distance(slot[n - 1], table_slot.point2, last_tang), 0, 1e-12);
+        XCTAssertEqualWithAccuracy(distance(slot[0], slot[1], slot[2]), 0, 1e-12);
+
+        // The outline goes along the second side of the slot and back along the first one, with its ends on the tang
+        // borders, each point half the width away from the segments it follows
+        XCTAssertEqualWithAccuracy(distance(outline[0], table_slot.point1, first_tang), 0, 1e-12);
+        XCTAssertEqualWithAccuracy(distance(outline[1], table_slot.point1, first_tang), 0, 1e-12);
+        XCTAssertEqualWithAccuracy(distance(outline[n], table_slot.point2, last_tang), 0, 1e-12);
+        XCTAssertEqualWithAccuracy(distance(outline[n + 1], table_slot.point2, last_tang), 0, 1e-12);
+        for (size_t k = 0; k < n; k++) {
+            for (size_t segment = k == 0 ? 0 : k - 1; segment <= k && segment + 1 < n; segment++) {
+                double side2 = distance(outline[k + 1], slot[segment], slot[segment + 1]);
+                double side1 = distance(outline[(2 * n - k) % (2 * n)], slot[segment], slot[segment + 1]);
+                XCTAssertEqualWithAccuracy(fabs(side2), half_width, 1e-12);
+                XCTAssertEqualWithAccuracy(fabs(side1), half_width, 1e-12);
+                XCTAssert(side1 * side2 < 0);
+            }
+        }
+    }
+
+    // Rebuilding with another temperament reuses the buffers
+    const Point* points = polylines.points().data();
+    Temperament other;
+    other.set_offsets(2, { 0, -10, 10 });
+    instrument.temperament = &other;
+    XCTAssertEqual(builder.build(instrument).fret_polylines().points().data(), points);
+    XCTAssert(builder.build(instrument).fret_polylines()[2][3] == builder.build(instrument).strings()[2].point_at_fret(2));
+}
+
+- (void)testEqualDivisions {
+    // Negative fractional indices, behind the nut, in any number of divisions of the octave
+    for (double n : { 12.0, 19.0, 24.0, 31.0, 53.0 }) {
+        String string(0, 650, -2.5, 2, 3, false, 0, n);
+        for (double index : { -40.25, -2.5, -1.0, 0.5, 7.0, 17.75 }) {
+            double expected = 650 * pow(2, -index / n);
+            XCTAssertEqualWithAccuracy(string.distance_from_bridge(index), expected, 1e-12 * expected);
+        }
+    }
+
+    Instrument instrument;
+    instrument.number_of_frets_per_octave = 31;
+    instrument.number_of_frets = 62;
+    instrument.perpendicular_fret_index = -3.5;
+    instrument.validate();
+    Fretboard fretboard(instrument);
+    XCTAssert(fretboard.is_valid());
+    XCTAssertEqual(fretboard.octave_fret(), 31);
+    XCTAssertEqual(fretboard.fret_lines().size(), 63);
+    for (const auto& string : fretboard.strings()) {
+        XCTAssertEqualWithAccuracy(string.distance_from_start(31), string.scale_length() / 2, 1e-12 * string.scale_length());
+        XCTAssertEqualWithAccuracy(string.distance_from_start(62), string.scale_length() * 3 / 4, 1e-12 * string.scale_length());
+    }
+    const auto& first = fretboard.strings().front();
+    const auto& last = fretboard.strings().back();
+    XCTAssertEqualWithAccuracy(fretboard.construction_distance_at_octave(), (first.point_at_fret(31).x + last.point_at_fret(31).x) / 2, 1e-12);
+    XCTAssertEqualWithAccuracy(fretboard.construction_distance_at_12th_fret(), (first.point_at_fret(12).x + last.point_at_fret(12).x) / 2, 1e-12);
+    XCTAssertEqual(Fretboard(Instrument()).construction_distance_at_octave(), Fretboard(Instrument()).construction_distance_at_12th_fret());
+
+    // JSON, older files without the key are 12-TET
+    json j = instrument;
+    Instrument loaded = j;
+    XCTAssertEqual(loaded.number_of_frets_per_octave, 31);
+    j.erase("number_of_frets_per_octave");
+    loaded = j;
+    XCTAssertEqual(loaded.number_of_frets_per_octave, 12);
+}
+
+- (void)testBinaryInstrumentFile {
+    std::vector<Instrument> instruments;
+    for (const auto& preset : Preset::presets()) {
+        instruments.push_back(preset.instrument);
+    }
+    for (const char* name : { "breaking.frt", "breaking2.frt" }) {
+        Instrument instrument;
+        XCTAssert(instrument.load(filePath(name)));
+        instruments.push_back(instrument);
+    }
+    Instrument edo;
+    edo.number_of_frets_per_octave = 31;
+    edo.overhang_type = all;
+    edo.overhangs[2] = 0.7;
+    edo.has_zero_fret = false;
+    edo.draw_frets = false;
+    edo.validate();
+    instruments.push_back(edo);
+
+    std::string json_path = temporaryFilePath("testBinaryInstrumentFile.frt");
+    std::string binary_path = temporaryFilePath("testBinaryInstrumentFile.bin.frt");
+    for (const auto& instrument : instruments) {
+        XCTAssert(instrument.save(json_path));
+        XCTAssert(instrument.save(binary_path, InstrumentFileFormat::binary));
+
+        // Both formats are detected by load and give the same instrument
+        Instrument from_json, from_binary;
+        XCTAssert(from_json.load(json_path));
+        XCTAssert(from_binary.load(binary_path));
+        for (const auto& field : instrument_fields()) {
+            for (int element = 0; element < field.count; element++) {
+                XCTAssertEqual(field.get(from_json, element), field.get(from_binary, element), "%s", field.name);
+            }
+        }
+
+        // JSON to binary and back is lossless
+        json j = instrument;
+        json k = from_binary;
+        XCTAssertEqual(j.dump(), k.dump());
+    }
+
+    // The record is read in place
+    XCTAssert(edo.save(binary_path, InstrumentFileFormat::binary));
+    MappedFile file(binary_path);
+    XCTAssert(file.is_open());
+    XCTAssertEqual(file.size(), sizeof(InstrumentFileHeader) + sizeof(InstrumentRecord));
+    XCTAssert(is_binary_instrument(file.data(), file.size()));
+    const InstrumentRecord* record = reinterpret_cast<const InstrumentRecord*>(file.data() + sizeof(InstrumentFileHeader));
+    XCTAssertEqual(record->number_of_frets_per_octave, 31);
+    XCTAssertEqual(record->overhangs[2], 0.7);
+    XCTAssertEqual(record->has_zero_fret, 0);
+
+    // Truncated files and unknown versions aren't loaded
+    std::vector<unsigned char> bytes(file.data(), file.data() + file.size());
+    Instrument instrument;
+    XCTAssertFalse(read_binary_instrument(bytes.data(), bytes.size() - 1, instrument));
+    bytes[4] = 3;
+    XCTAssertFalse(read_binary_instrument(bytes.data(), bytes.size(), instrument));
+    bytes[4] = 2;
+    XCTAssert(read_binary_instrument(bytes.data(), bytes.size(), instrument));
+    XCTAssertEqual(instrument.number_of_frets_per_octave, 31);
+
+    // load() reads the files instead, whatever their size
+    std::vector<unsigned char> data;
+    XCTAssert(read_file(binary_path, data));
+    XCTAssert(data == std::vector<unsigned char>(file.data(), file.data() + file.size()));
+    std::string large_path = temporaryFilePath("testBinaryInstrumentFile.large");
+    {
+        std::ofstream ofs(large_path, std::ofstream::binary);
+        for (int i = 0; i < 100000; i++) {
+            ofs.put(char(i % 251));
+        }
+    }
+    XCTAssert(read_file(large_path, data));
+    XCTAssertEqual(data.size(), 100000);
+    XCTAssertEqual(data[99999], 99999 % 251);
+    remove(large_path.c_str());
+
+    file.close();
+    XCTAssertFalse(read_file(temporaryFilePath("testBinaryInstrumentFile.missing"), data));
+    XCTAssertFalse(MappedFile(temporaryFilePath("testBinaryInstrumentFile.missing")).is_open());
+    XCTAssertFalse(instrument.load(temporaryFilePath("testBinaryInstrumentFile.missing")));
+    remove(json_path.c_str());
+    remove(binary_path.c_str());
+}
+
+- (void)testInstrumentLibrary {
+    // Variations of the presets under unique names
+    std::vector<std::string> names;
+    std::vector<Instrument> instruments;
+    auto presets = Preset::presets();
+    InstrumentLibraryWriter writer;
+    for (int i = 0; i < 3000; i++) {
+        Instrument instrument = presets[i % presets.size()].instrument;
+        instrument.scale_length[0] += i * 0.01;
+        instrument.number_of_frets = 20 + i % 7;
+        instrument.number_of_frets_per_octave = 12 + i % 3;
+        instrument.validate();
+        names.push_back(std::string(presets[i % presets.size()].name) + " #" + std::to_string(i));
+        instruments.push_back(instrument);
+        XCTAssert(writer.add(names.back(), instrument));
+    }
+    XCTAssertFalse(writer.add(names[42], instruments[0]));
+    XCTAssertEqual(writer.size(), instruments.size());
+
+    std::string path = temporaryFilePath("testInstrumentLibrary.frtlib");
+    XCTAssert(writer.save(path));
+
+    InstrumentLibrary library(path);
+    XCTAssert(library.is_open());
+    XCTAssertEqual(library.size(), instruments.size());
+    for (size_t i = 0; i < instruments.size(); i++) {
+        XCTAssert(library.name(i) == names[i]);
+        XCTAssertEqual(library.find(names[i]), i);
+
+        // Same instrument as from its own file
+        Instrument found;
+        XCTAssert(library.find(names[i], found));
+        InstrumentRecord expected, actual;
+        to_record(instruments[i], expected);
+        to_record(found, actual);
+        XCTAssertEqual(memcmp(&expected, &actual, sizeof(InstrumentRecord)), 0);
+    }
+    Instrument instrument;
+    XCTAssertEqual(library.find("Telecaster"), InstrumentLibrary::npos);
+    XCTAssertEqual(library.find(""), InstrumentLibrary::npos);
+    XCTAssertFalse(library.find("Telecaster #3000", instrument));
+    XCTAssertFalse(library.instrument(instruments.size(), instrument));
+
+    // Damaged and foreign files aren't opened
+    library.close();
+    XCTAssertEqual(library.size(), 0);
+    XCTAssertEqual(library.find(names[0]), InstrumentLibrary::npos);
+    std::vector<char> bytes;
+    {
+        std::ifstream ifs(path, std::ifstream::binary);
+        bytes.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+    }
+    std::ofstream(path, std::ofstream::binary).write(bytes.data(), bytes.size() - 1);
+    XCTAssertFalse(library.open(path));
+    XCTAssert(presets[0].instrument.save(path, InstrumentFileFormat::binary));
+    XCTAssertFalse(library.open(path));
+
+    // An empty library is valid
+    XCTAssert(InstrumentLibraryWriter().save(path));
+    XCTAssert(library.open(path));
+    XCTAssertEqual(library.size(), 0);
+    XCTAssertEqual(library.find(names[0]), InstrumentLibrary::npos);
+    library.close();
+    remove(path.c_str());
+}
+
+- (void)testInstrumentJsonParity {
+    // The reference is nlohmann's DOM and from_json()
+    auto reference = [](const std::string& text, Instrument& instrument) {
+        try {
+            instrument = json::parse(text).get<Instrument>();
+            return true;
+        } catch (const json::exception&) {
+            return false;
+        }
+    };
+    auto parse = [](const std::string& text, Instrument& instrument) {
+        return parse_instrument_json(text.data(), text.data() + text.size(), instrument);
+    };
+    auto same = [](const Instrument& a, const Instrument& b) {
+        InstrumentRecord ra, rb;
+        to_record(a, ra);
+        to_record(b, rb);
+        return memcmp(&ra, &rb, sizeof(InstrumentRecord)) == 0;
+    };
+
+    std::vector<std::string> seeds;
+    for (const auto& preset : Preset::presets()) {
+        json j = preset.instrument;
+        seeds.push_back(j.dump());
+        seeds.push_back(j.dump(4));
+    }
+    for (const char* name : { "breaking.frt", "breaking2.frt" }) {
+        std::ifstream ifs(filePath(name));
+        seeds.push_back(std::string(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()));
+    }
+    std::string legacy = seeds[0];
+    legacy.replace(legacy.find("\"overhangs\""), strlen("\"overhangs\""), "\"overhang\":0.5,\"unknown\":{\"a\":[1,{},[]]},\"overhangs\"");
+    seeds.push_back(legacy);
+    std::string old = seeds[0];
+    size_t key = old.find("\"number_of_frets_per_octave\"");
+    old.erase(key, old.find(',', key) + 1 - key);
+    seeds.push_back(old);
+
+    // The files we write, and older ones, are parsed without nlohmann
+    for (const auto& seed : seeds) {
+        Instrument expected, actual;
+        XCTAssert(reference(seed, expected));
+        XCTAssert(parse(seed, actual));
+        XCTAssert(same(expected, actual));
+    }
+    Instrument instrument;
+    XCTAssert(parse(legacy, instrument));
+    XCTAssertEqual(instrument.overhangs[3], 0.5);
+    XCTAssert(parse(old, instrument));
+    XCTAssertEqual(instrument.number_of_frets_per_octave, 12);
+
+    // Random edits of the seeds: whatever the parser accepts, nlohmann must accept and read the same way
+    const char* tokens[] = { "true", "false", "null", "0", "-0", "6", "6.0", "6.7", "-3", "1e400", "-1e-400", "2E1",
+        "4294967302", "18446744073709551616", "-9223372036854775809", "\"x\"", "\"\\u0041\"", "[]", "{}", "[1,2]",
+        "[1,2,3,4,5]", "[true,2]", "{\"a\":[1]}", "0.1", "64.77e-1", "9007199254740993.0", "1e22", "1e23",
+        "123456789.123456789", "1.7976931348623157e308", "5e-324", "-2147483648.5", "2147483647.9" };
+    const char* keys[] = { "number_of_strings", "scale_length", "has_zero_fret", "number_of_frets", "overhang",
+        "overhangs", "overhang_type", "number_of_frets_per_octave", "draw_frets", "unknown" };
+    const char alphabet[] = "{}[],:\"0123456789.-+eE tfn\t\n\\x";
+    std::mt19937 random(20261017);
+    auto pick = [&](size_t n) { return size_t(random() % n); };
+    int accepted = 0;
+    int parsed = 0;
+    for (int i = 0; i < 20000; i++) {
+        std::string text = seeds[pick(seeds.size())];
+        for (size_t edits = 1 + pick(3); edits > 0; edits--) {
+            size_t at = pick(text.size());
+            switch (pick(5)) {
+                case 0: text.erase(at, 1 + pick(4)); break;
+                case 1: text.insert(at, 1, alphabet[pick(sizeof(alphabet) - 1)]); break;
+                case 2: {
+                    // Replace a value
+                    size_t colon = text.find(':', at);
+                    if (colon != std::string::npos) {
+                        size_t next = text.find_first_of(",}", colon);
+                        if (text[colon + 1] == '[') {
+                            next = text.find(']', colon) + 1;
+                        }
+                        text.replace(colon + 1, next - colon - 1, tokens[pick(sizeof(tokens) / sizeof(tokens[0]))]);
+                    }
+                    break;
+                }
+                case 3: {
+                    // Add a key, maybe already there
+                    size_t brace = text.rfind('}');
+                    std::string pair = std::string(",\"") + keys[pick(sizeof(keys) / sizeof(keys[0]))] + "\":" + tokens[pick(sizeof(tokens) / sizeof(tokens[0]))];
+                    if (brace != std::string::npos) {
+                        text.insert(brace, pair);
+                    }
+                    break;
+                }
+                default: text.insert(at, " "); break;
+            }
+        }
+
+        Instrument expected, actual;
+        actual.number_of_strings = -1;
+        bool reference_ok = reference(text, expected);
+        bool parse_ok = parse(text, actual);
+        accepted += reference_ok;
+        parsed += parse_ok;
+        if (parse_ok) {
+            XCTAssert(reference_ok, "%s", text.c_str());
+            XCTAssert(same(expected, actual), "%s", text.c_str());
+        } else {
+            XCTAssertEqual(actual.number_of_strings, -1);
+        }
+    }
+    // Most of what nlohmann accepts doesn't need it
+    XCTAssertGreaterThan(accepted, 2000);
+    XCTAssertGreaterThan(parsed, accepted * 3 / 4);
+    printf("instrument JSON: %d accepted, %d without nlohmann\n", accepted, parsed);
+}
+
+- (void)testNdjsonPipeline {
+    // The presets, with an empty line and one that isn't an instrument in the middle
+    auto presets = Preset::presets();
+    std::string lines;
+    for (size_t i = 0; i < presets.size(); i++) {
+        lines += json(presets[i].instrument).dump() + "\n";
+        if (i == 2) {
+            lines += "\n{\"number_of_strings\": 6, \"scale_length\": [\n";
+        }
+    }
+
+    NdjsonPipelineOptions sequential;
+    sequential.pipelined = false;
+    NdjsonPipelineOptions pipelined;
+    pipelined.batch_size = 2;
+    pipelined.batch_count = 2;
+    std::string outputs[2];
+    NdjsonPipelineStats stats[2];
+    const NdjsonPipelineOptions* options[2] = { &sequential, &pipelined };
+    for (int i = 0; i < 2; i++) {
+        std::istringstream input(lines);
+        std::ostringstream output;
+        XCTAssert(run_ndjson_pipeline(input, output, *options[i], &stats[i]));
+        outputs[i] = output.str();
+        XCTAssertEqual(stats[i].lines, presets.size() + 1);
+        XCTAssertEqual(stats[i].fretboards, presets.size());
+        XCTAssertEqual(stats[i].errors, 1);
+    }
+    XCTAssert(outputs[0] == outputs[1]);
+
+    std::istringstream output(outputs[1]);
+    std::string line;
+    size_t preset = 0;
+    while (std::getline(output, line)) {
+        json result = json::parse(line);
+        if (result.contains("error")) {
+            XCTAssertEqual(result["line"].get<size_t>(), 5);
+            continue;
+        }
+        // Line numbers count the empty line, numbers read back to the same doubles
+        XCTAssertEqual(result["line"].get<size_t>(), preset < 3 ? preset + 1 : preset + 3);
+        Fretboard fretboard(presets[preset].instrument);
+        const FretTable& table = fretboard.fret_table();
+        XCTAssertEqual(result["valid"].get<bool>(), fretboard.is_valid());
+        XCTAssertEqual(result["fret_slots"].size(), table.size());
+        for (size_t i = 0; i < table.size(); i++) {
+            XCTAssertEqual(result["fret_lines"][i][0].get<double>(), table.column(FretTable::line_x1)[i]);
+            XCTAssertEqual(result["fret_slots"][i][3].get<double>(), table.column(FretTable::slot_y2)[i]);
+        }
+        XCTAssertEqual(result["board_shape"][2][1].get<double>(), fretboard.board_shape().points[2].y);
+        XCTAssertEqual(result["construction_distance_at_12th_fret"].get<double>(), fretboard.construction_distance_at_12th_fret());
+        XCTAssertEqual(result["construction_distance_at_octave"].get<double>(), fretboard.construction_distance_at_octave());
+        preset++;
+    }
+    XCTAssertEqual(preset, presets.size());
+
+    // Valid JSON, but no fretboard can be built from them: errors instead of building
+    lines.clear();
+    const char* invalid[][2] = {
+        { "number_of_strings", "0" },
+        { "number_of_strings", "-3" },
+        { "number_of_frets", "-1" },
+        { "number_of_frets", "2000000000" },
+        { "number_of_frets_per_octave", "0" },
+        { "number_of_frets_per_octave", "-12" },
+    };
+    for (const auto& field : invalid) {
+        json instrument = presets[0].instrument;
+        instrument[field[0]] = json::parse(field[1]);
+        lines += instrument.dump() + "\n";
+    }
+    lines += json(presets[0].instrument).dump() + "\n";
+    for (const NdjsonPipelineOptions* o : options) {
+        std::istringstream input(lines);
+        std::ostringstream errors;
+        NdjsonPipelineStats counts;
+        XCTAssert(run_ndjson_pipeline(input, errors, *o, &counts));
+        XCTAssertEqual(counts.errors, sizeof(invalid) / sizeof(invalid[0]));
+        XCTAssertEqual(counts.fretboards, 1);
+        std::istringstream results(errors.str());
+        for (size_t i = 0; std::getline(results, line); i++) {
+            json result = json::parse(line);
+            XCTAssertEqual(result["line"].get<size_t>(), i + 1);
+            XCTAssertEqual(result.contains("error"), i < counts.errors);
+        }
+    }
+}
+
+- (void)testDxfWriter {
+    Instrument instrument = Preset::presets()[0].instrument;
+    Fretboard fretboard(instrument);
+    instrument.carve_nut_slot = false;
+    Fretboard without_nut_slot(instrument);
+    size_t frets = fretboard.fret_lines().size();
+
+    DxfWriter writer;
+    // Smallest buffer: the document is flushed every few groups
+    DxfWriter small(1);
+    for (auto version : { DxfVersion::r12, DxfVersion::r2000 }) {
+        bool r2000 = version == DxfVersion::r2000;
+        DxfOptions options;
+        options.version = version;
+        for (const Fretboard* board : { &fretboard, &without_nut_slot }) {
+            std::ostringstream output, small_output;
+            XCTAssert(writer.write(*board, output, options));
+            XCTAssert(small.write(*board, small_output, options));
+            XCTAssert(output.str() == small_output.str());
+
+            // Group code and value pairs
+            std::istringstream input(output.str());
+            std::string code, value, type, previous;
+            std::map<std::string, int> entities;
+            std::set<std::string> handles;
+            unsigned long handle_seed = 0;
+            std::vector<double> line_x1;
+            while (std::getline(input, code) && std::getline(input, value)) {
+                int group = atoi(code.c_str());
+                if (group == 0) {
+                    type = value;
+                } else if (group == 8 && type != "VERTEX" && type != "SEQEND") {
+                    entities[value + " " + type]++;
+                } else if (group == 5 && previous == "$HANDSEED") {
+                    handle_seed = strtoul(value.c_str(), nullptr, 16);
+                } else if (group == 5 || group == 105) {
+                    XCTAssert(handles.insert(value).second);
+                } else if (group == 10 && type == "LINE") {
+                    line_x1.push_back(strtod(value.c_str(), nullptr));
+                }
+                previous = value;
+            }
+            XCTAssert(type == "EOF");
+            XCTAssertEqual(handles.empty(), !r2000);
+            for (const auto& h : handles) {
+                XCTAssertLessThan(strtoul(h.c_str(), nullptr, 16), handle_seed);
+            }
+
+            const char* polyline = r2000 ? "LWPOLYLINE" : "POLYLINE";
+            XCTAssertEqual(entities[std::string("BOARD ") + polyline], 1);
+            XCTAssertEqual(entities[std::string("FRET_SLOTS ") + polyline], frets);
+            XCTAssertEqual(entities["FRET_LINES LINE"], frets);
+            XCTAssertEqual(entities[std::string("NUT ") + polyline], 1);
+            XCTAssertEqual(entities[std::string("NUT_SLOT ") + polyline], board == &fretboard ? 1 : 0);
+            // In mm, the exact doubles
+            XCTAssertEqual(line_x1.size(), frets);
+            for (size_t i = 0; i < line_x1.size(); i++) {
+                XCTAssertEqual(line_x1[i], board->fret_lines()[i].point1.x * 10);
+            }
+        }
+    }
+}
+
+- (void)testSvgTemplate {
+    auto presets = Preset::presets();
+    Fretboard fretboard(presets[0].instrument);
+    size_t frets = fretboard.fret_lines().size();
+    auto translation = [](std::string_view page) {
+        size_t at = page.find("translate(");
+        std::string numbers(page.substr(at + 10, 40));
+        char* end;
+        double x = strtod(numbers.c_str(), &end);
+        return Point(x, strtod(end + 1, nullptr));
+    };
+    auto count = [](std::string_view text, std::string_view what) {
+        size_t n = 0;
+        for (size_t at = text.find(what); at != std::string_view::npos; at = text.find(what, at + 1)) {
+            n++;
+        }
+        return n;
+    };
+
+    SvgTemplate svg;
+    for (auto paper_size : { PaperSize::a4, PaperSize::letter }) {
+        SvgTemplateOptions options;
+        options.paper_size = paper_size;
+        svg.generate(fretboard, options);
+        // A full scale neck doesn't fit on one page, lengthwise is the fewest pages
+        XCTAssert(svg.is_landscape());
+        XCTAssertEqual(svg.rows(), 1);
+        XCTAssertGreaterThan(svg.columns(), 2);
+        XCTAssertEqual(svg.page_count(), size_t(svg.rows() * svg.columns()));
+
+        double width = paper_size == PaperSize::a4 ? 297 : 279.4;
+        std::string size = paper_size == PaperSize::a4 ? "width=\"297mm\" height=\"210mm\"" : "width=\"279.4mm\" height=\"215.9mm\"";
+        for (size_t i = 0; i < svg.page_count(); i++) {
+            std::string_view page = svg.page(i);
+            XCTAssertEqual(page.find("<?xml"), 0);
+            XCTAssert(page.substr(page.size() - 7) == "</svg>\n");
+            XCTAssertNotEqual(page.find(size), std::string_view::npos);
+            // The whole drawing on every page, and the marks at the four corners
+            XCTAssertEqual(count(page, "<text x="), frets);
+            XCTAssertEqual(count(page, "<circle"), 4);
+            if (i > 0) {
+                // Neighbouring pages are one printable width minus the overlap apart, so that their marks match
+                Point previous = translation(svg.page(i - 1));
+                Point current = translation(page);
+                XCTAssertEqualWithAccuracy(previous.x - current.x, width - 2 * options.margin - options.overlap, 1e-3);
+                XCTAssertEqual(previous.y, current.y);
+            }
+        }
+        XCTAssertNotEqual(svg.page(0).find(">12</text>"), std::string_view::npos);
+    }
+
+    // Reused for a smaller template, same output as a new one
+    Instrument short_neck = presets[0].instrument;
+    short_neck.number_of_frets = 12;
+    short_neck.scale_length[0] = short_neck.scale_length[1] = 30;
+    Fretboard small(short_neck);
+    SvgTemplate fresh;
+    svg.generate(small);
+    fresh.generate(small);
+    XCTAssertEqual(svg.page_count(), fresh.page_count());
+    for (size_t i = 0; i < svg.page_count(); i++) {
+        XCTAssert(svg.page(i) == fresh.page(i));
+    }
+
+    std::string prefix = temporaryFilePath("testSvgTemplate");
+    XCTAssert(svg.save(prefix));
+    std::ifstream saved(prefix + "-1-1.svg", std::ifstream::binary);
+    std::stringstream contents;
+    contents << saved.rdbuf();
+    XCTAssert(contents.str() == svg.page(0));
+
+    // Batches give the same templates
+    std::vector<Instrument> instruments;
+    for (int i = 0; i < 40; i++) {
+        instruments.push_back(presets[i % presets.size()].instrument);
+    }
+    ThreadPool pool(4);
+    FretboardBatch fretboards;
+    generate_batch(instruments, fretboards, pool);
+    SvgTemplateBatch templates;
+    for (int run = 0; run < 2; run++) {
+        generate_svg_templates(fretboards, templates, SvgTemplateOptions(), pool);
+        XCTAssertEqual(templates.size(), instruments.size());
+        for (size_t i = 0; i < instruments.size(); i++) {
+            fresh.generate(fretboards[i]);
+            XCTAssertEqual(templates[i].page_count(), fresh.page_count());
+            XCTAssert(templates[i].page(templates[i].page_count() - 1) == fresh.page(fresh.page_count() - 1));
+        }
+    }
+}
 
 //- (void)testPerformanceExample {
 //    // This is an example of a performance test case.
@@ -0,0 +1,67 @@
+//
+//  Arena.cpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include "Arena.hpp"
+
+namespace fretboarder {
+
+Arena::Arena(size_t block_size) : _block_size(block_size) {
+}
+
+Arena::~Arena() {
+    for (auto& block : _blocks) {
+        ::operator delete(block.data);
+    }
+}
+
+void* Arena::allocate(size_t size, size_t alignment) {
+    assert(alignment && (alignment & (alignment - 1)) == 0);
+    size = std::max<size_t>(size, 1);
+
+    while (_current < _blocks.size()) {
+        const Block& block = _blocks[_current];
+        uintptr_t address = reinterpret_cast<uintptr_t>(block.data) + _offset;
+        size_t offset = _offset + (((address + alignment - 1) & ~uintptr_t(alignment - 1)) - address);
+        if (offset + size <= block.size) {
+            _offset = offset + size;
+            return block.data + offset;
+        }
+        // Doesn't fit, move on to the next block (the end of this one is lost until the next reset)
+        _used_before += block.size;
+        _current++;
+        _offset = 0;
+    }
+
+    // Leave room to align the allocation whatever the alignment of the block.
+    size_t block_size = std::max(_block_size, size + alignment);
+    _blocks.push_back({ static_cast<char*>(::operator new(block_size)), block_size });
+    return allocate(size, alignment);
+}
+
+void Arena::reset() {
+    _current = 0;
+    _offset = 0;
+    _used_before = 0;
+}
+
+size_t Arena::capacity() const {
+    size_t capacity = 0;
+    for (auto& block : _blocks) {
+        capacity += block.size;
+    }
+    return capacity;
+}
+
+size_t Arena::used() const {
+    return _used_before + (_current < _blocks.size() ? _offset : 0);
+}
+
+}
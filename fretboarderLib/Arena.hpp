@@ -0,0 +1,97 @@
+//
+//  Arena.hpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+#ifndef arena_hpp
+#define arena_hpp
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace fretboarder {
+
+// Bump allocator handing out memory from a list of blocks. Nothing is freed until reset(), which keeps the blocks
+// around: once warmed up, building the same kind of objects again in the arena doesn't touch the heap at all.
+// Everything built in an arena must be destroyed (or at least not used anymore) before reset().
+class Arena {
+public:
+    explicit Arena(size_t block_size = 64 * 1024);
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t size, size_t alignment);
+
+    // Makes all the memory of the arena available again.
+    void reset();
+
+    // Total size of the blocks and size used since the last reset().
+    size_t capacity() const;
+    size_t used() const;
+
+private:
+    struct Block {
+        char* data;
+        size_t size;
+    };
+
+    std::vector<Block> _blocks;
+    size_t _block_size;
+    size_t _current = 0; // block being filled
+    size_t _offset = 0; // in the current block
+    size_t _used_before = 0; // in the blocks before the current one
+};
+
+// Standard allocator over an Arena, or over the heap when built without one. Copies of containers using it
+// go back to the heap (like std::pmr::polymorphic_allocator does), so they can outlive the arena.
+template <class T>
+class ArenaAllocator {
+public:
+    typedef T value_type;
+
+    ArenaAllocator() : _arena(nullptr) {}
+    explicit ArenaAllocator(Arena* arena) : _arena(arena) {}
+
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : _arena(other.arena()) {}
+
+    T* allocate(size_t n) {
+        if (_arena) {
+            return static_cast<T*>(_arena->allocate(n * sizeof(T), alignof(T)));
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t) {
+        if (!_arena) {
+            ::operator delete(p);
+        }
+    }
+
+    ArenaAllocator select_on_container_copy_construction() const { return ArenaAllocator(); }
+
+    Arena* arena() const { return _arena; }
+
+private:
+    Arena* _arena;
+};
+
+template <class T, class U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) { return a.arena() == b.arena(); }
+
+template <class T, class U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) { return a.arena() != b.arena(); }
+
+template <class T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+}
+
+#endif /* arena_hpp */
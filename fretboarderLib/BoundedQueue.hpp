@@ -0,0 +1,81 @@
+//
+//  BoundedQueue.hpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+#ifndef bounded_queue_hpp
+#define bounded_queue_hpp
+
+#include <condition_variable>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace fretboarder {
+
+// Blocking queue of at most capacity elements between the threads of two stages of a pipeline: the producer waits
+// when the consumer is behind, so that the memory used doesn't depend on how fast each side is. The elements live
+// in a ring allocated once.
+template <class T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : _ring(capacity ? capacity : 1) {}
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    // Waits while the queue is full. False if the queue is closed, value is dropped.
+    bool push(T value) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _not_full.wait(lock, [this]() { return _size < _ring.size() || _closed; });
+        if (_closed) {
+            return false;
+        }
+        _ring[(_first + _size) % _ring.size()] = std::move(value);
+        _size++;
+        lock.unlock();
+        _not_empty.notify_one();
+        return true;
+    }
+
+    // Waits while the queue is empty. False once the queue is closed and empty.
+    bool pop(T& value) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _not_empty.wait(lock, [this]() { return _size > 0 || _closed; });
+        if (_size == 0) {
+            return false;
+        }
+        value = std::move(_ring[_first]);
+        _first = (_first + 1) % _ring.size();
+        _size--;
+        lock.unlock();
+        _not_full.notify_one();
+        return true;
+    }
+
+    // No more elements: pop() returns what's left then false, push() fails.
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _closed = true;
+        }
+        _not_full.notify_all();
+        _not_empty.notify_all();
+    }
+
+private:
+    std::mutex _mutex;
+    std::condition_variable _not_full;
+    std::condition_variable _not_empty;
+    std::vector<T> _ring;
+    size_t _first = 0;
+    size_t _size = 0;
+    bool _closed = false;
+};
+
+}
+
+#endif /* bounded_queue_hpp */
@@ -0,0 +1,177 @@
+//
+//  Dual.hpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+#ifndef dual_hpp
+#define dual_hpp
+
+#include <cmath>
+#include "Geometry.hpp"
+
+namespace fretboarder {
+
+// Forward mode automatic differentiation: a value along with its derivatives with respect to N variables.
+// Running the geometry templates (BasicPoint, BasicString...) with Dual instead of double gives the exact
+// derivatives of the results with respect to the variables in the same pass. Comparisons only look at the values.
+template <class T, int N>
+class Dual {
+public:
+    T value;
+    T derivatives[N];
+
+    constexpr Dual(T value = T(0)) : value(value), derivatives() {}
+
+    // The variable of index i (derivative 1 with respect to itself, 0 for the others).
+    static constexpr Dual variable(T value, int i) {
+        Dual v(value);
+        v.derivatives[i] = T(1);
+        return v;
+    }
+
+    constexpr T derivative(int i) const { return derivatives[i]; }
+
+    constexpr bool is_constant() const {
+        for (int i = 0; i < N; i++) {
+            if (derivatives[i] != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Value and derivatives of f(x) knowing f(x.value) and f'(x.value)
+    static constexpr Dual chain(const Dual& x, T f, T df) {
+        Dual r(f);
+        for (int i = 0; i < N; i++) {
+            r.derivatives[i] = df * x.derivatives[i];
+        }
+        return r;
+    }
+
+    constexpr Dual operator-() const {
+        return chain(*this, -value, T(-1));
+    }
+
+    constexpr Dual& operator+=(const Dual& b) { return *this = *this + b; }
+    constexpr Dual& operator-=(const Dual& b) { return *this = *this - b; }
+    constexpr Dual& operator*=(const Dual& b) { return *this = *this * b; }
+    constexpr Dual& operator/=(const Dual& b) { return *this = *this / b; }
+
+    friend constexpr Dual operator+(const Dual& a, const Dual& b) {
+        Dual r(a.value + b.value);
+        for (int i = 0; i < N; i++) {
+            r.derivatives[i] = a.derivatives[i] + b.derivatives[i];
+        }
+        return r;
+    }
+
+    friend constexpr Dual operator-(const Dual& a, const Dual& b) {
+        Dual r(a.value - b.value);
+        for (int i = 0; i < N; i++) {
+            r.derivatives[i] = a.derivatives[i] - b.derivatives[i];
+        }
+        return r;
+    }
+
+    friend constexpr Dual operator*(const Dual& a, const Dual& b) {
+        Dual r(a.value * b.value);
+        for (int i = 0; i < N; i++) {
+            r.derivatives[i] = a.derivatives[i] * b.value + a.value * b.derivatives[i];
+        }
+        return r;
+    }
+
+    // (a' - (a / b) * b') / b, one division for all the derivatives
+    friend constexpr Dual operator/(const Dual& a, const Dual& b) {
+        T inverse = T(1) / b.value;
+        Dual r(a.value / b.value);
+        for (int i = 0; i < N; i++) {
+            r.derivatives[i] = (a.derivatives[i] - r.value * b.derivatives[i]) * inverse;
+        }
+        return r;
+    }
+
+    // Cheaper versions with constants
+    friend constexpr Dual operator+(const Dual& a, T b) { return chain(a, a.value + b, T(1)); }
+    friend constexpr Dual operator+(T a, const Dual& b) { return chain(b, a + b.value, T(1)); }
+    friend constexpr Dual operator-(const Dual& a, T b) { return chain(a, a.value - b, T(1)); }
+    friend constexpr Dual operator-(T a, const Dual& b) { return chain(b, a - b.value, T(-1)); }
+    friend constexpr Dual operator*(const Dual& a, T b) { return chain(a, a.value * b, b); }
+    friend constexpr Dual operator*(T a, const Dual& b) { return chain(b, a * b.value, a); }
+    friend constexpr Dual operator/(const Dual& a, T b) { return chain(a, a.value / b, T(1) / b); }
+    friend constexpr Dual operator/(T a, const Dual& b) { return chain(b, a / b.value, -a / (b.value * b.value)); }
+
+    friend constexpr bool operator==(const Dual& a, const Dual& b) { return a.value == b.value; }
+    friend constexpr bool operator!=(const Dual& a, const Dual& b) { return a.value != b.value; }
+    friend constexpr bool operator<(const Dual& a, const Dual& b) { return a.value < b.value; }
+    friend constexpr bool operator<=(const Dual& a, const Dual& b) { return a.value <= b.value; }
+    friend constexpr bool operator>(const Dual& a, const Dual& b) { return a.value > b.value; }
+    friend constexpr bool operator>=(const Dual& a, const Dual& b) { return a.value >= b.value; }
+
+    friend Dual sqrt(const Dual& x) {
+        using std::sqrt;
+        T s = sqrt(x.value);
+        return chain(x, s, T(0.5) / s);
+    }
+
+    friend Dual fabs(const Dual& x) {
+        return x.value < 0 ? -x : x;
+    }
+
+    friend Dual abs(const Dual& x) {
+        return fabs(x);
+    }
+
+    friend Dual exp2(const Dual& x) {
+        using std::exp2;
+        T e = exp2(x.value);
+        return chain(x, e, e * T(0.693147180559945309417232121458176568));
+    }
+
+    friend Dual log2(const Dual& x) {
+        using std::log2;
+        return chain(x, log2(x.value), T(1) / (x.value * T(0.693147180559945309417232121458176568)));
+    }
+
+    friend Dual pow(const Dual& x, T e) {
+        using std::pow;
+        T p = pow(x.value, e);
+        return chain(x, p, e * pow(x.value, e - 1));
+    }
+
+    friend Dual pow(T base, const Dual& e) {
+        using std::pow;
+        using std::log;
+        T p = pow(base, e.value);
+        return chain(e, p, p * log(base));
+    }
+
+    friend Dual pow(const Dual& x, const Dual& e) {
+        using std::log;
+        return exp2(e * log2(x));
+    }
+
+    friend Dual atan2(const Dual& y, const Dual& x) {
+        using std::atan2;
+        T d = x.value * x.value + y.value * y.value;
+        Dual r(atan2(y.value, x.value));
+        for (int i = 0; i < N; i++) {
+            r.derivatives[i] = (x.value * y.derivatives[i] - y.value * x.derivatives[i]) / d;
+        }
+        return r;
+    }
+};
+
+template <class T, int N>
+struct ScalarTraits<Dual<T, N>> {
+    static constexpr double value(const Dual<T, N>& v) { return double(v.value); }
+    static constexpr bool is_constant(const Dual<T, N>& v) { return v.is_constant(); }
+};
+
+}
+
+#endif /* dual_hpp */
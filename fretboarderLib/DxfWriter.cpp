@@ -0,0 +1,441 @@
+//
+//  DxfWriter.cpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include "DxfWriter.hpp"
+
+namespace fretboarder {
+
+namespace {
+
+// Longest group written: a code and a value with their line ends
+const size_t max_group_size = 128;
+
+struct DxfLayer {
+    const char* name;
+    // AutoCAD color index
+    int color;
+};
+
+enum { layer_0, layer_board, layer_fret_slots, layer_fret_lines, layer_nut, layer_nut_slot, layer_count };
+
+const DxfLayer layers[layer_count] = {
+    { "0", 7 },
+    { "BOARD", 7 },
+    { "FRET_SLOTS", 1 },
+    { "FRET_LINES", 5 },
+    { "NUT", 3 },
+    { "NUT_SLOT", 4 },
+};
+
+// Handles of the tables, records and objects every R2000 document has, the entities come after
+enum : unsigned {
+    vport_table = 1,
+    ltype_table,
+    layer_table,
+    style_table,
+    view_table,
+    ucs_table,
+    appid_table,
+    dimstyle_table,
+    block_record_table,
+    root_dictionary,
+    group_dictionary,
+    ltype_byblock,
+    ltype_bylayer,
+    ltype_continuous,
+    style_standard,
+    appid_acad,
+    dimstyle_standard,
+    model_space_record,
+    paper_space_record,
+    model_space_block,
+    model_space_end,
+    paper_space_block,
+    paper_space_end,
+    first_layer,
+    first_entity = first_layer + layer_count
+};
+
+// Right aligned on 3 characters like AutoCAD does, some readers expect it
+char* write_code(char* p, int code) {
+    char digits[12];
+    int n = 0;
+    do {
+        digits[n++] = char('0' + code % 10);
+        code /= 10;
+    } while (code);
+    for (int i = n; i < 3; i++) {
+        *p++ = ' ';
+    }
+    while (n) {
+        *p++ = digits[--n];
+    }
+    *p++ = '\n';
+    return p;
+}
+
+}
+
+DxfWriter::DxfWriter(size_t buffer_size) : _buffer(std::max(buffer_size, max_group_size)) {}
+
+void DxfWriter::reserve(size_t size) {
+    if (size_t(_buffer.data() + _buffer.size() - _p) < size) {
+        flush();
+    }
+}
+
+void DxfWriter::flush() {
+    _output->write(_buffer.data(), _p - _buffer.data());
+    _p = _buffer.data();
+}
+
+void DxfWriter::group(int code, const char* value) {
+    size_t size = strlen(value);
+    reserve(size + 5);
+    _p = write_code(_p, code);
+    memcpy(_p, value, size);
+    _p += size;
+    *_p++ = '\n';
+}
+
+void DxfWriter::group(int code, int value) {
+    reserve(max_group_size);
+    _p = write_code(_p, code);
+    unsigned magnitude = value < 0 ? 0u - unsigned(value) : unsigned(value);
+    if (value < 0) {
+        *_p++ = '-';
+    }
+    char digits[12];
+    int n = 0;
+    do {
+        digits[n++] = char('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude);
+    while (n) {
+        *_p++ = digits[--n];
+    }
+    *_p++ = '\n';
+}
+
+void DxfWriter::group(int code, double value) {
+    reserve(max_group_size);
+    _p = write_code(_p, code);
+    // Fewest digits that read back to the same double (std::to_chars isn't there for doubles on every platform)
+    _p = nlohmann::detail::to_chars(_p, _p + 32, std::isfinite(value) ? value : 0.0);
+    *_p++ = '\n';
+}
+
+void DxfWriter::handle(int code, unsigned value) {
+    static const char hex[] = "0123456789ABCDEF";
+    reserve(max_group_size);
+    _p = write_code(_p, code);
+    char digits[8];
+    int n = 0;
+    do {
+        digits[n++] = hex[value & 15];
+        value >>= 4;
+    } while (value);
+    while (n) {
+        *_p++ = digits[--n];
+    }
+    *_p++ = '\n';
+}
+
+void DxfWriter::point(double x, double y, int code) {
+    group(code, x * _options.scale);
+    group(code + 10, y * _options.scale);
+    group(code + 20, 0.0);
+}
+
+void DxfWriter::header(const Fretboard& fretboard, unsigned entity_count) {
+    bool r2000 = _options.version == DxfVersion::r2000;
+    Point min(HUGE_VAL, HUGE_VAL), max(-HUGE_VAL, -HUGE_VAL);
+    auto extend = [&](const Point& p) {
+        min = Point(std::min(min.x, p.x), std::min(min.y, p.y));
+        max = Point(std::max(max.x, p.x), std::max(max.y, p.y));
+    };
+    for (const Quad* quad : { &fretboard.board_shape(), &fretboard.nut_shape(), &fretboard.nut_slot_shape() }) {
+        for (const Point& p : quad->points) {
+            extend(p);
+        }
+    }
+    if (min.x > max.x) {
+        min = max = Point();
+    }
+
+    group(0, "SECTION");
+    group(2, "HEADER");
+    group(9, "$ACADVER");
+    group(1, r2000 ? "AC1015" : "AC1009");
+    if (r2000) {
+        group(9, "$HANDSEED");
+        handle(5, first_entity + entity_count);
+        group(9, "$INSUNITS");
+        group(70, 4);
+        group(9, "$MEASUREMENT");
+        group(70, 1);
+    }
+    group(9, "$INSBASE");
+    point(0, 0);
+    group(9, "$EXTMIN");
+    point(min.x, min.y);
+    group(9, "$EXTMAX");
+    point(max.x, max.y);
+    group(0, "ENDSEC");
+}
+
+void DxfWriter::tables() {
+    bool r2000 = _options.version == DxfVersion::r2000;
+    auto table = [&](const char* name, unsigned table_handle, int count) {
+        group(0, "TABLE");
+        group(2, name);
+        if (r2000) {
+            handle(5, table_handle);
+            handle(330, 0);
+            group(100, "AcDbSymbolTable");
+        }
+        group(70, count);
+    };
+    auto record = [&](const char* type, unsigned record_handle, unsigned table_handle, const char* subclass,
+                      const char* name) {
+        group(0, type);
+        if (r2000) {
+            handle(strcmp(type, "DIMSTYLE") ? 5 : 105, record_handle);
+            handle(330, table_handle);
+            group(100, "AcDbSymbolTableRecord");
+            group(100, subclass);
+        }
+        group(2, name);
+        group(70, 0);
+    };
+    auto linetype = [&](unsigned record_handle, const char* name, const char* description) {
+        record("LTYPE", record_handle, ltype_table, "AcDbLinetypeTableRecord", name);
+        group(3, description);
+        group(72, 65);
+        group(73, 0);
+        group(40, 0.0);
+    };
+
+    group(0, "SECTION");
+    group(2, "TABLES");
+
+    if (r2000) {
+        table("VPORT", vport_table, 0);
+        group(0, "ENDTAB");
+    }
+
+    table("LTYPE", ltype_table, r2000 ? 3 : 1);
+    if (r2000) {
+        linetype(ltype_byblock, "ByBlock", "");
+        linetype(ltype_bylayer, "ByLayer", "");
+    }
+    linetype(ltype_continuous, r2000 ? "Continuous" : "CONTINUOUS", "Solid line");
+    group(0, "ENDTAB");
+
+    table("LAYER", layer_table, layer_count);
+    for (int i = 0; i < layer_count; i++) {
+        record("LAYER", first_layer + i, layer_table, "AcDbLayerTableRecord", layers[i].name);
+        group(62, layers[i].color);
+        group(6, r2000 ? "Continuous" : "CONTINUOUS");
+    }
+    group(0, "ENDTAB");
+
+    if (r2000) {
+        table("STYLE", style_table, 1);
+        record("STYLE", style_standard, style_table, "AcDbTextStyleTableRecord", "Standard");
+        group(40, 0.0);
+        group(41, 1.0);
+        group(50, 0.0);
+        group(71, 0);
+        group(42, 2.5);
+        group(3, "txt");
+        group(4, "");
+        group(0, "ENDTAB");
+
+        table("VIEW", view_table, 0);
+        group(0, "ENDTAB");
+        table("UCS", ucs_table, 0);
+        group(0, "ENDTAB");
+
+        table("APPID", appid_table, 1);
+        record("APPID", appid_acad, appid_table, "AcDbRegAppTableRecord", "ACAD");
+        group(0, "ENDTAB");
+
+        table("DIMSTYLE", dimstyle_table, 1);
+        group(100, "AcDbDimStyleTable");
+        group(71, 0);
+        record("DIMSTYLE", dimstyle_standard, dimstyle_table, "AcDbDimStyleTableRecord", "Standard");
+        group(0, "ENDTAB");
+
+        table("BLOCK_RECORD", block_record_table, 2);
+        record("BLOCK_RECORD", model_space_record, block_record_table, "AcDbBlockTableRecord", "*Model_Space");
+        record("BLOCK_RECORD", paper_space_record, block_record_table, "AcDbBlockTableRecord", "*Paper_Space");
+        group(0, "ENDTAB");
+    }
+
+    group(0, "ENDSEC");
+
+    if (r2000) {
+        group(0, "SECTION");
+        group(2, "BLOCKS");
+        auto block = [&](unsigned owner, unsigned begin, unsigned end, const char* name, bool paper) {
+            group(0, "BLOCK");
+            handle(5, begin);
+            handle(330, owner);
+            group(100, "AcDbEntity");
+            if (paper) {
+                group(67, 1);
+            }
+            group(8, "0");
+            group(100, "AcDbBlockBegin");
+            group(2, name);
+            group(70, 0);
+            point(0, 0);
+            group(3, name);
+            group(1, "");
+            group(0, "ENDBLK");
+            handle(5, end);
+            handle(330, owner);
+            group(100, "AcDbEntity");
+            if (paper) {
+                group(67, 1);
+            }
+            group(8, "0");
+            group(100, "AcDbBlockEnd");
+        };
+        block(model_space_record, model_space_block, model_space_end, "*Model_Space", false);
+        block(paper_space_record, paper_space_block, paper_space_end, "*Paper_Space", true);
+        group(0, "ENDSEC");
+    }
+}
+
+void DxfWriter::entity(const char* type, const char* layer) {
+    group(0, type);
+    if (_options.version == DxfVersion::r2000) {
+        handle(5, _handle++);
+        handle(330, model_space_record);
+        group(100, "AcDbEntity");
+    }
+    group(8, layer);
+}
+
+void DxfWriter::line(const char* layer, const Vector& line) {
+    entity("LINE", layer);
+    if (_options.version == DxfVersion::r2000) {
+        group(100, "AcDbLine");
+    }
+    point(line.point1.x, line.point1.y, 10);
+    point(line.point2.x, line.point2.y, 11);
+}
+
+void DxfWriter::polyline(const char* layer, const Point* points, size_t count, bool closed) {
+    if (_options.version == DxfVersion::r2000) {
+        entity("LWPOLYLINE", layer);
+        group(100, "AcDbPolyline");
+        group(90, int(count));
+        group(70, closed ? 1 : 0);
+        for (size_t i = 0; i < count; i++) {
+            group(10, points[i].x * _options.scale);
+            group(20, points[i].y * _options.scale);
+        }
+    } else {
+        entity("POLYLINE", layer);
+        group(66, 1);
+        point(0, 0);
+        group(70, closed ? 1 : 0);
+        for (size_t i = 0; i < count; i++) {
+            entity("VERTEX", layer);
+            point(points[i].x, points[i].y);
+        }
+        entity("SEQEND", layer);
+    }
+}
+
+bool DxfWriter::write(const Fretboard& fretboard, std::ostream& output, const DxfOptions& options) {
+    _output = &output;
+    _options = options;
+    _p = _buffer.data();
+    _handle = first_entity;
+
+    bool curved = fretboard.has_curved_frets();
+    bool nut_slot = fretboard.instrument().carve_nut_slot;
+    auto slot_shapes = fretboard.fret_slot_shapes();
+    auto lines = fretboard.fret_lines();
+    unsigned entity_count = unsigned(2 + slot_shapes.size() + lines.size() + (nut_slot ? 1 : 0));
+
+    header(fretboard, entity_count);
+    tables();
+
+    group(0, "SECTION");
+    group(2, "ENTITIES");
+    polyline(layers[layer_board].name, fretboard.board_shape().points, 4, true);
+    if (curved) {
+        const FretPolylines& outlines = fretboard.fret_slot_outlines();
+        for (size_t i = 0; i < outlines.size(); i++) {
+            polyline(layers[layer_fret_slots].name, outlines[i].data(), outlines[i].size(), true);
+        }
+        const FretPolylines& polylines = fretboard.fret_polylines();
+        for (size_t i = 0; i < polylines.size(); i++) {
+            polyline(layers[layer_fret_lines].name, polylines[i].data(), polylines[i].size(), false);
+        }
+    } else {
+        for (size_t i = 0; i < slot_shapes.size(); i++) {
+            Quad shape = slot_shapes[i];
+            polyline(layers[layer_fret_slots].name, shape.points, 4, true);
+        }
+        for (size_t i = 0; i < lines.size(); i++) {
+            line(layers[layer_fret_lines].name, lines[i]);
+        }
+    }
+    polyline(layers[layer_nut].name, fretboard.nut_shape().points, 4, true);
+    if (nut_slot) {
+        polyline(layers[layer_nut_slot].name, fretboard.nut_slot_shape().points, 4, true);
+    }
+    group(0, "ENDSEC");
+
+    if (options.version == DxfVersion::r2000) {
+        group(0, "SECTION");
+        group(2, "OBJECTS");
+        group(0, "DICTIONARY");
+        handle(5, root_dictionary);
+        handle(330, 0);
+        group(100, "AcDbDictionary");
+        group(281, 1);
+        group(3, "ACAD_GROUP");
+        handle(350, group_dictionary);
+        group(0, "DICTIONARY");
+        handle(5, group_dictionary);
+        handle(330, root_dictionary);
+        group(100, "AcDbDictionary");
+        group(281, 1);
+        group(0, "ENDSEC");
+    }
+    group(0, "EOF");
+
+    flush();
+    output.flush();
+    _output = nullptr;
+    return bool(output);
+}
+
+bool DxfWriter::save(const Fretboard& fretboard, const std::string& filename, const DxfOptions& options) {
+    // Unbuffered: the document goes from our buffer to the file
+    std::ofstream ofs;
+    ofs.rdbuf()->pubsetbuf(nullptr, 0);
+    ofs.open(filename, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+    if (!ofs.is_open()) {
+        return false;
+    }
+    return write(fretboard, ofs, options);
+}
+
+}
@@ -0,0 +1,82 @@
+//
+//  DxfWriter.hpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+#ifndef dxf_writer_hpp
+#define dxf_writer_hpp
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include "Fretboard.hpp"
+
+namespace fretboarder {
+
+enum class DxfVersion {
+    // AC1009, read by about everything, CAM software included
+    r12,
+    // AC1015, with handles, the tables and objects AutoCAD expects and lightweight polylines
+    r2000
+};
+
+struct DxfOptions {
+    DxfVersion version = DxfVersion::r12;
+    // Drawings are in millimeters: millimeters per unit of the fretboard, 10 for the fretboards built in cm (the
+    // presets, the add-in), 1 for the ones loaded from .frt files.
+    double scale = 10;
+};
+
+// Writes the outline of fretboards to DXF for CNC machining, on the XY plane, one layer per feature:
+//  - BOARD: board_shape(), closed polyline
+//  - FRET_SLOTS: fret_slot_shapes(), or fret_slot_outlines() when the frets are curved, closed polylines
+//  - FRET_LINES: fret_lines(), or fret_polylines() when the frets are curved
+//  - NUT: nut_shape(), closed polyline
+//  - NUT_SLOT: nut_slot_shape(), closed polyline, only if the instrument has carve_nut_slot
+//
+// Documents are formatted straight into a buffer allocated once, buffer_size bytes at a time, and the buffer goes to
+// the output when it's full: nothing is allocated per entity, or per document once the writer has written one. Reuse
+// the writer to export many fretboards.
+class DxfWriter {
+public:
+    explicit DxfWriter(size_t buffer_size = 64 * 1024);
+
+    DxfWriter(const DxfWriter&) = delete;
+    DxfWriter& operator=(const DxfWriter&) = delete;
+
+    // Writes fretboard as a complete document. False if output failed.
+    bool write(const Fretboard& fretboard, std::ostream& output, const DxfOptions& options = DxfOptions());
+    // Same to a file, without going through the buffer of a stream.
+    bool save(const Fretboard& fretboard, const std::string& filename, const DxfOptions& options = DxfOptions());
+
+private:
+    std::vector<char> _buffer;
+    char* _p = nullptr;
+    std::ostream* _output = nullptr;
+    DxfOptions _options;
+    // Next entity handle (R2000)
+    unsigned _handle = 0;
+
+    // Makes room for size bytes, at most max_group_size.
+    void reserve(size_t size);
+    void flush();
+
+    void group(int code, const char* value);
+    void group(int code, int value);
+    void group(int code, double value);
+    void handle(int code, unsigned value);
+    void point(double x, double y, int code = 10);
+
+    void header(const Fretboard& fretboard, unsigned entity_count);
+    void tables();
+    void entity(const char* type, const char* layer);
+    void line(const char* layer, const Vector& line);
+    void polyline(const char* layer, const Point* points, size_t count, bool closed);
+};
+
+}
+
+#endif /* dxf_writer_hpp */
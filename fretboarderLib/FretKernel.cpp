@@ -0,0 +1,157 @@
+//
+//  FretKernel.cpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+#include <atomic>
+#include "FretKernelPriv.hpp"
+
+#if FRETBOARDER_X86
+#include <emmintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif
+
+namespace fretboarder {
+
+#if FRETBOARDER_X86
+namespace {
+
+// SSE2 is part of x86-64, no need to check for it at runtime.
+struct SSE2Pack {
+    typedef __m128d type;
+    typedef __m128d mask;
+    enum { width = 2 };
+
+    static type load(const double* p) { return _mm_loadu_pd(p); }
+    static void store(double* p, type v) { _mm_storeu_pd(p, v); }
+    static type set1(double v) { return _mm_set1_pd(v); }
+    static type add(type a, type b) { return _mm_add_pd(a, b); }
+    static type sub(type a, type b) { return _mm_sub_pd(a, b); }
+    static type mul(type a, type b) { return _mm_mul_pd(a, b); }
+    static type div(type a, type b) { return _mm_div_pd(a, b); }
+    static type sqrt(type a) { return _mm_sqrt_pd(a); }
+    static type min(type a, type b) { return _mm_min_pd(a, b); }
+    static type max(type a, type b) { return _mm_max_pd(a, b); }
+    // 2^k for whole ks in [-1022, 1023]: k + 1023 lands in the low bits of the mantissa of k + 1023 + 2^52 and is
+    // shifted into the exponent
+    static type pow2i(type k) {
+        __m128i bits = _mm_castpd_si128(_mm_add_pd(k, _mm_set1_pd(4503599627370496.0 + 1023)));
+        return _mm_castsi128_pd(_mm_slli_epi64(bits, 52));
+    }
+    static type abs(type a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a); }
+    static mask eq(type a, type b) { return _mm_cmpeq_pd(a, b); }
+    static mask le(type a, type b) { return _mm_cmple_pd(a, b); }
+    static type select(mask m, type a, type b) { return _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b)); }
+    static int movemask(mask m) { return _mm_movemask_pd(m); }
+};
+
+}
+#endif
+
+static FretKernelIsa detect_isa() {
+#if FRETBOARDER_X86
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] >= 7) {
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        // The OS must also save the YMM registers on context switches
+        if (osxsave && avx && (_xgetbv(0) & 6) == 6) {
+            __cpuidex(info, 7, 0);
+            if (info[1] & (1 << 5)) {
+                return FretKernelIsa::avx2;
+            }
+        }
+    }
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return FretKernelIsa::avx2;
+    }
+#endif
+    return FretKernelIsa::sse2;
+#else
+    return FretKernelIsa::scalar;
+#endif
+}
+
+FretKernelIsa fret_kernel_best_isa() {
+    static const FretKernelIsa best = detect_isa();
+    return best;
+}
+
+static std::atomic<int> selected_isa(-1);
+
+FretKernelIsa fret_kernel_isa() {
+    int isa = selected_isa.load(std::memory_order_relaxed);
+    return isa < 0 ? fret_kernel_best_isa() : FretKernelIsa(isa);
+}
+
+void set_fret_kernel_isa(FretKernelIsa isa) {
+    selected_isa.store(int(std::min(isa, fret_kernel_best_isa())), std::memory_order_relaxed);
+}
+
+const char* fret_kernel_isa_name(FretKernelIsa isa) {
+    switch (isa) {
+        case FretKernelIsa::scalar: return "scalar";
+        case FretKernelIsa::sse2: return "sse2";
+        case FretKernelIsa::avx2: return "avx2";
+    }
+    return "unknown";
+}
+
+void build_frets(const FretKernelInput& input, FretTable& table) {
+    build_frets(input, table, fret_kernel_isa());
+}
+
+void build_frets(const FretKernelInput& input, FretTable& table, FretKernelIsa isa) {
+    size_t count = table.size();
+    assert(input.first_t.size() >= count && input.last_t.size() >= count);
+
+    size_t done = 0;
+    isa = std::min(isa, fret_kernel_best_isa());
+#if FRETBOARDER_X86
+    if (isa == FretKernelIsa::avx2) {
+        done = build_frets_avx2(input, table);
+    }
+    if (isa >= FretKernelIsa::sse2) {
+        done = FretKernel<SSE2Pack>::run(input, table, done, count);
+    }
+#endif
+    // Whatever the SIMD versions couldn't fill a whole register with
+    FretKernel<ScalarPack>::run(input, table, done, count);
+}
+
+void points_at_frets(const FretPointsInput& input, Span<Point> points) {
+    points_at_frets(input, points, fret_kernel_isa());
+}
+
+void points_at_frets(const FretPointsInput& input, Span<Point> points, FretKernelIsa isa) {
+    size_t count = input.indices.size();
+    assert(points.size() >= count);
+
+    size_t done = 0;
+    isa = std::min(isa, fret_kernel_best_isa());
+#if FRETBOARDER_X86
+    if (isa == FretKernelIsa::avx2) {
+        done = points_at_frets_avx2(input, points);
+    }
+    if (isa >= FretKernelIsa::sse2) {
+        done = FretKernel<SSE2Pack>::points(input, points, done, count);
+    }
+#endif
+    FretKernel<ScalarPack>::points(input, points, done, count);
+}
+
+double fret_kernel_exp2(double x) {
+    return FretKernel<ScalarPack>::exp2(x);
+}
+
+}
@@ -0,0 +1,87 @@
+//
+//  FretKernel.hpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+#ifndef fret_kernel_hpp
+#define fret_kernel_hpp
+
+#include "Geometry.hpp"
+#include "FretTable.hpp"
+
+namespace fretboarder {
+
+// Parts of the fret table computed by build_frets().
+enum FretKernelParts {
+    // Fret slots and fret lines
+    fret_kernel_lines = 1 << 0,
+    fret_kernel_slot_shapes = 1 << 1,
+    fret_kernel_all = fret_kernel_lines | fret_kernel_slot_shapes
+};
+
+// Everything needed to compute the frets of a fretboard. The outer strings are described by their start point and
+// the vector from their start to the bridge, so that a fret point is start + t * direction (see String::point_at_fret).
+struct FretKernelInput {
+    Point first_start;
+    Point first_direction;
+    Point last_start;
+    Point last_direction;
+
+    // Position of each fret along the first and last strings, as a ratio of their scale length.
+    Span<const double> first_t;
+    Span<const double> last_t;
+
+    double fret_slots_width = 0;
+
+    Line2D first_border;
+    Line2D last_border;
+    Line2D first_tang_border;
+    Line2D last_tang_border;
+
+    // FretKernelParts to compute, the other columns of the table are left untouched.
+    unsigned parts = fret_kernel_all;
+};
+
+enum class FretKernelIsa {
+    scalar = 0,
+    sse2 = 1,
+    avx2 = 2
+};
+
+// Best instruction set supported by this CPU (detected once, at first call).
+FretKernelIsa fret_kernel_best_isa();
+
+// Instruction set used by build_frets(). Defaults to the best one, can be lowered for testing and benchmarking.
+FretKernelIsa fret_kernel_isa();
+void set_fret_kernel_isa(FretKernelIsa isa);
+const char* fret_kernel_isa_name(FretKernelIsa isa);
+
+// Computes the fret slots, fret lines and/or fret slot shapes of every fret of the input into table, which must already
+// be sized to the number of frets. The SIMD versions give the same results as the scalar one (within 1e-9 mm).
+void build_frets(const FretKernelInput& input, FretTable& table);
+void build_frets(const FretKernelInput& input, FretTable& table, FretKernelIsa isa);
+
+// A string, for points_at_frets(): its point at a fret index is start + (1 - 2^(-index / frets_per_octave)) * direction,
+// like String::point_at_fret(), and the bridge for the index 100.
+struct FretPointsInput {
+    Point start;
+    Point direction;
+    double frets_per_octave = 12;
+    Span<const double> indices;
+};
+
+// Computes the point of the string of the input at each of its fret indices into points, which must be at least as
+// large. The powers of two are approximated (see fret_kernel_exp2()), the points are within 1e-9 relative of the
+// ones of String::point_at_fret() for indices within +/- 1000 octaves.
+void points_at_frets(const FretPointsInput& input, Span<Point> points);
+void points_at_frets(const FretPointsInput& input, Span<Point> points, FretKernelIsa isa);
+
+// The approximation of 2^x used by the SIMD kernels, accurate to 1e-12 relative for |x| < 1000.
+double fret_kernel_exp2(double x);
+
+}
+
+#endif /* fret_kernel_hpp */
@@ -0,0 +1,77 @@
+//
+//  FretKernelAVX2.cpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+// AVX2 version of the fret kernel. Only this file is compiled for AVX2 (with the pragmas below rather than compiler
+// flags so that the project files don't need per file settings), and it's only called once the CPU has been checked.
+// All the headers are included before switching the target so that no shared inline function gets compiled for AVX2.
+
+#include "FretKernel.hpp"
+#include <math.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+#include "FretKernelPriv.hpp"
+
+namespace fretboarder {
+
+namespace {
+
+struct AVX2Pack {
+    typedef __m256d type;
+    typedef __m256d mask;
+    enum { width = 4 };
+
+    static type load(const double* p) { return _mm256_loadu_pd(p); }
+    static void store(double* p, type v) { _mm256_storeu_pd(p, v); }
+    static type set1(double v) { return _mm256_set1_pd(v); }
+    static type add(type a, type b) { return _mm256_add_pd(a, b); }
+    static type sub(type a, type b) { return _mm256_sub_pd(a, b); }
+    static type mul(type a, type b) { return _mm256_mul_pd(a, b); }
+    static type div(type a, type b) { return _mm256_div_pd(a, b); }
+    static type sqrt(type a) { return _mm256_sqrt_pd(a); }
+    static type min(type a, type b) { return _mm256_min_pd(a, b); }
+    static type max(type a, type b) { return _mm256_max_pd(a, b); }
+    // See SSE2Pack::pow2i
+    static type pow2i(type k) {
+        __m256i bits = _mm256_castpd_si256(_mm256_add_pd(k, _mm256_set1_pd(4503599627370496.0 + 1023)));
+        return _mm256_castsi256_pd(_mm256_slli_epi64(bits, 52));
+    }
+    static type abs(type a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+    static mask eq(type a, type b) { return _mm256_cmp_pd(a, b, _CMP_EQ_OQ); }
+    static mask le(type a, type b) { return _mm256_cmp_pd(a, b, _CMP_LE_OQ); }
+    static type select(mask m, type a, type b) { return _mm256_blendv_pd(b, a, m); }
+    static int movemask(mask m) { return _mm256_movemask_pd(m); }
+};
+
+}
+
+size_t build_frets_avx2(const FretKernelInput& input, FretTable& table) {
+    return FretKernel<AVX2Pack>::run(input, table, 0, table.size());
+}
+
+size_t points_at_frets_avx2(const FretPointsInput& input, Span<Point> points) {
+    return FretKernel<AVX2Pack>::points(input, points, 0, input.indices.size());
+}
+
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
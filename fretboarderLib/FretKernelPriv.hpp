@@ -0,0 +1,242 @@
+//
+//  FretKernelPriv.hpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+// Generic body of the fret kernel, shared by every instruction set. It is written against a "Pack" of Pack::width
+// doubles providing the handful of operations we need, and is instantiated once per instruction set:
+// FretKernel.cpp for the scalar and SSE2 versions, FretKernelAVX2.cpp for the AVX2 one (which has to be compiled
+// for AVX2). Everything here has internal linkage so that the differently compiled instances never get merged.
+
+#ifndef fret_kernel_priv_hpp
+#define fret_kernel_priv_hpp
+
+#include "FretKernel.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define FRETBOARDER_X86 1
+#else
+#define FRETBOARDER_X86 0
+#endif
+
+namespace fretboarder {
+
+#if FRETBOARDER_X86
+// Processes as many frets of input as possible 4 by 4 and returns how many were done. Defined in FretKernelAVX2.cpp.
+size_t build_frets_avx2(const FretKernelInput& input, FretTable& table);
+// Same for the fret indices of input.
+size_t points_at_frets_avx2(const FretPointsInput& input, Span<Point> points);
+#endif
+
+namespace {
+
+// Scalar "pack", used for the reference version and for the frets left over by the SIMD versions.
+struct ScalarPack {
+    typedef double type;
+    typedef bool mask;
+    enum { width = 1 };
+
+    static type load(const double* p) { return *p; }
+    static void store(double* p, type v) { *p = v; }
+    static type set1(double v) { return v; }
+    static type add(type a, type b) { return a + b; }
+    static type sub(type a, type b) { return a - b; }
+    static type mul(type a, type b) { return a * b; }
+    static type div(type a, type b) { return a / b; }
+    static type sqrt(type a) { return ::sqrt(a); }
+    static type min(type a, type b) { return a < b ? a : b; }
+    static type max(type a, type b) { return a > b ? a : b; }
+    // 2^k for a whole k in [-1022, 1023]
+    static type pow2i(type k) { return ::ldexp(1.0, int(k)); }
+    static type abs(type a) { return ::fabs(a); }
+    static mask eq(type a, type b) { return a == b; }
+    static mask le(type a, type b) { return a <= b; }
+    static type select(mask m, type a, type b) { return m ? a : b; }
+    // Lane i of m in bit i
+    static int movemask(mask m) { return m ? 1 : 0; }
+};
+
+template <class Pack>
+struct FretKernel {
+    typedef typename Pack::type V;
+
+    // Intersection of the lines (x, y, dx, dy) with border, see Line2D::intersection. Lanes where the line is
+    // parallel to the border are left untouched.
+    static inline void intersect(V x, V y, V dx, V dy, const Line2D& border, double* xs, double* ys) {
+        V bx = Pack::set1(border.x);
+        V by = Pack::set1(border.y);
+        V bdx = Pack::set1(border.dx);
+        V bdy = Pack::set1(border.dy);
+
+        V a = Pack::mul(dx, bdy);
+        V b = Pack::mul(dy, bdx);
+        V det = Pack::sub(a, b);
+        V s = Pack::div(Pack::sub(Pack::mul(Pack::sub(bx, x), bdy), Pack::mul(Pack::sub(by, y), bdx)), det);
+        // Nearly parallel lanes (and parallel ones) are done exactly below
+        V bound = Pack::mul(Pack::set1(intersection_filter_bound), Pack::add(Pack::abs(a), Pack::abs(b)));
+        typename Pack::mask uncertain = Pack::le(Pack::abs(det), bound);
+        Pack::store(xs, Pack::select(uncertain, Pack::load(xs), Pack::add(x, Pack::mul(dx, s))));
+        Pack::store(ys, Pack::select(uncertain, Pack::load(ys), Pack::add(y, Pack::mul(dy, s))));
+        int lanes = Pack::movemask(uncertain);
+        if (lanes != 0) {
+            intersect_exactly(lanes, x, y, dx, dy, border, xs, ys);
+        }
+    }
+
+    // The lanes of intersect() set in lanes (see Pack::movemask), with exact_intersection().
+    static void intersect_exactly(int lanes, V x, V y, V dx, V dy, const Line2D& border, double* xs, double* ys) {
+        double lx[Pack::width], ly[Pack::width], ldx[Pack::width], ldy[Pack::width];
+        Pack::store(lx, x);
+        Pack::store(ly, y);
+        Pack::store(ldx, dx);
+        Pack::store(ldy, dy);
+        for (int j = 0; j < Pack::width; j++) {
+            Point p;
+            if ((lanes & (1 << j)) && exact_intersection(Line2D(lx[j], ly[j], ldx[j], ldy[j]), border, p) == IntersectionResult::found) {
+                xs[j] = p.x;
+                ys[j] = p.y;
+            }
+        }
+    }
+
+    // 2^x for |x| < 1000: 2^round(x) from the exponent bits times a polynomial for the rest, the Taylor series of
+    // 2^f to the 10th degree (relative error below 3e-13 for |f| <= 0.5).
+    static inline V exp2(V x) {
+        static const double coefficients[] = {
+            1.0,
+            0.693147180559945309417232121458176568,
+            0.240226506959100712333551263163332839,
+            0.0555041086648215799531422637686218,
+            0.00961812910762847716197907157365887,
+            0.00133335581464284434234122219879962,
+            0.000154035303933816099544370973327423,
+            1.52527338040598402800254390120096e-05,
+            1.32154867901443094884037582282884e-06,
+            1.01780860092396997274900075168e-07,
+            7.05491162080112087744465319e-09
+        };
+        x = Pack::min(Pack::max(x, Pack::set1(-1000)), Pack::set1(1000));
+        // Round to nearest with the 1.5 * 2^52 trick, f ends up in [-0.5, 0.5]
+        V magic = Pack::set1(6755399441055744.0);
+        V k = Pack::sub(Pack::add(x, magic), magic);
+        V f = Pack::sub(x, k);
+        V p = Pack::set1(coefficients[10]);
+        for (int i = 9; i >= 0; i--) {
+            p = Pack::add(Pack::mul(p, f), Pack::set1(coefficients[i]));
+        }
+        return Pack::mul(p, Pack::pow2i(k));
+    }
+
+    // Points of the string of input at its fret indices [begin, end), Pack::width at a time. Returns the index of
+    // the first one not computed.
+    static size_t points(const FretPointsInput& input, Span<Point> points, size_t begin, size_t end) {
+        V start_x = Pack::set1(input.start.x);
+        V start_y = Pack::set1(input.start.y);
+        V direction_x = Pack::set1(input.direction.x);
+        V direction_y = Pack::set1(input.direction.y);
+        V scale = Pack::set1(-1 / input.frets_per_octave);
+        V one = Pack::set1(1);
+        V bridge = Pack::set1(100);
+
+        size_t i = begin;
+        for (; i + Pack::width <= end; i += Pack::width) {
+            // Position along the string as a ratio of the scale length (see String::distance_from_bridge)
+            V index = Pack::load(input.indices.data() + i);
+            V t = Pack::sub(one, exp2(Pack::mul(index, scale)));
+            t = Pack::select(Pack::eq(index, bridge), one, t);
+
+            double xs[Pack::width];
+            double ys[Pack::width];
+            Pack::store(xs, Pack::add(start_x, Pack::mul(t, direction_x)));
+            Pack::store(ys, Pack::add(start_y, Pack::mul(t, direction_y)));
+            for (int j = 0; j < Pack::width; j++) {
+                points[i + j] = Point(xs[j], ys[j]);
+            }
+        }
+        return i;
+    }
+
+    // Computes the frets [begin, end) Pack::width at a time and returns the index of the first fret not computed.
+    static size_t run(const FretKernelInput& input, FretTable& table, size_t begin, size_t end) {
+        double* slot_x1 = table.column(FretTable::slot_x1).data();
+        double* slot_y1 = table.column(FretTable::slot_y1).data();
+        double* slot_x2 = table.column(FretTable::slot_x2).data();
+        double* slot_y2 = table.column(FretTable::slot_y2).data();
+        double* line_x1 = table.column(FretTable::line_x1).data();
+        double* line_y1 = table.column(FretTable::line_y1).data();
+        double* line_x2 = table.column(FretTable::line_x2).data();
+        double* line_y2 = table.column(FretTable::line_y2).data();
+        double* shape_x0 = table.column(FretTable::shape_x0).data();
+        double* shape_y0 = table.column(FretTable::shape_y0).data();
+        double* shape_x1 = table.column(FretTable::shape_x1).data();
+        double* shape_y1 = table.column(FretTable::shape_y1).data();
+        double* shape_x2 = table.column(FretTable::shape_x2).data();
+        double* shape_y2 = table.column(FretTable::shape_y2).data();
+        double* shape_x3 = table.column(FretTable::shape_x3).data();
+        double* shape_y3 = table.column(FretTable::shape_y3).data();
+
+        V first_x = Pack::set1(input.first_start.x);
+        V first_y = Pack::set1(input.first_start.y);
+        V first_dx = Pack::set1(input.first_direction.x);
+        V first_dy = Pack::set1(input.first_direction.y);
+        V last_x = Pack::set1(input.last_start.x);
+        V last_y = Pack::set1(input.last_start.y);
+        V last_dx = Pack::set1(input.last_direction.x);
+        V last_dy = Pack::set1(input.last_direction.y);
+        V zero = Pack::set1(0);
+        V half_width = Pack::set1(input.fret_slots_width / 2);
+        V minus_half_width = Pack::set1(-input.fret_slots_width / 2);
+        bool lines = (input.parts & fret_kernel_lines) != 0;
+        bool slot_shapes = (input.parts & fret_kernel_slot_shapes) != 0;
+
+        size_t i = begin;
+        for (; i + Pack::width <= end; i += Pack::width) {
+            // Fret points on the outer strings (String::point_at_fret)
+            V t1 = Pack::load(input.first_t.data() + i);
+            V t2 = Pack::load(input.last_t.data() + i);
+            V x1 = Pack::add(first_x, Pack::mul(t1, first_dx));
+            V y1 = Pack::add(first_y, Pack::mul(t1, first_dy));
+            V x2 = Pack::add(last_x, Pack::mul(t2, last_dx));
+            V y2 = Pack::add(last_y, Pack::mul(t2, last_dy));
+
+            // Fret line
+            V dx = Pack::sub(x2, x1);
+            V dy = Pack::sub(y2, y1);
+
+            if (lines) {
+                intersect(x1, y1, dx, dy, input.first_tang_border, slot_x1 + i, slot_y1 + i);
+                intersect(x1, y1, dx, dy, input.last_tang_border, slot_x2 + i, slot_y2 + i);
+                intersect(x1, y1, dx, dy, input.first_border, line_x1 + i, line_y1 + i);
+                intersect(x1, y1, dx, dy, input.last_border, line_x2 + i, line_y2 + i);
+            }
+            if (slot_shapes) {
+                // Both sides of the fret slot (Line2D::offset), the sign keeps them in the same order whatever the
+                // orientation of the fret
+                V sign = Pack::select(Pack::le(x1, x2), Pack::set1(1), Pack::set1(-1));
+                V n = Pack::sqrt(Pack::add(Pack::mul(dx, dx), Pack::mul(dy, dy)));
+                typename Pack::mask degenerated = Pack::eq(n, zero);
+                V off1 = Pack::select(degenerated, zero, Pack::div(Pack::mul(sign, minus_half_width), n));
+                V off2 = Pack::select(degenerated, zero, Pack::div(Pack::mul(sign, half_width), n));
+                V side1_x = Pack::add(x1, Pack::mul(dy, off1));
+                V side1_y = Pack::sub(y1, Pack::mul(dx, off1));
+                V side2_x = Pack::add(x1, Pack::mul(dy, off2));
+                V side2_y = Pack::sub(y1, Pack::mul(dx, off2));
+
+                intersect(side1_x, side1_y, dx, dy, input.first_tang_border, shape_x0 + i, shape_y0 + i);
+                intersect(side2_x, side2_y, dx, dy, input.first_tang_border, shape_x1 + i, shape_y1 + i);
+                intersect(side2_x, side2_y, dx, dy, input.last_tang_border, shape_x2 + i, shape_y2 + i);
+                intersect(side1_x, side1_y, dx, dy, input.last_tang_border, shape_x3 + i, shape_y3 + i);
+            }
+        }
+        return i;
+    }
+};
+
+}
+
+}
+
+#endif /* fret_kernel_priv_hpp */
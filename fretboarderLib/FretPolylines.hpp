@@ -0,0 +1,64 @@
+//
+//  FretPolylines.hpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+#ifndef fret_polylines_hpp
+#define fret_polylines_hpp
+
+#include "Arena.hpp"
+#include "Geometry.hpp"
+
+namespace fretboarder {
+
+// One polyline per fret, for frets that are not straight (see Fretboard::has_curved_frets()). All the points live in
+// a single contiguous buffer and polyline i is points()[offset(i), offset(i + 1)): rebuilding them doesn't allocate
+// once the buffers are large enough, however many frets and strings there are.
+class FretPolylines {
+public:
+    FretPolylines() {}
+    // The buffers are allocated from arena, which must outlive the polylines.
+    explicit FretPolylines(Arena* arena) : _points(ArenaAllocator<Point>(arena)), _offsets(ArenaAllocator<size_t>(arena)) {}
+
+    size_t size() const { return _offsets.empty() ? 0 : _offsets.size() - 1; }
+    bool empty() const { return size() == 0; }
+
+    size_t offset(size_t i) const { return _offsets[i]; }
+    Span<const Point> operator[](size_t i) const { return Span<const Point>(_points.data() + _offsets[i], _offsets[i + 1] - _offsets[i]); }
+
+    // Every point, polyline after polyline.
+    Span<const Point> points() const { return Span<const Point>(_points); }
+
+    // Removes every polyline, keeps the buffers.
+    void clear() {
+        _points.clear();
+        _offsets.clear();
+    }
+
+    void reserve(size_t polylines, size_t points) {
+        _offsets.reserve(polylines + 1);
+        _points.reserve(points);
+    }
+
+    // Appends a polyline of count points and returns them to be filled.
+    Span<Point> add(size_t count) {
+        if (_offsets.empty()) {
+            _offsets.push_back(0);
+        }
+        size_t offset = _points.size();
+        _points.resize(offset + count);
+        _offsets.push_back(_points.size());
+        return Span<Point>(_points.data() + offset, count);
+    }
+
+private:
+    ArenaVector<Point> _points;
+    ArenaVector<size_t> _offsets;
+};
+
+}
+
+#endif /* fret_polylines_hpp */
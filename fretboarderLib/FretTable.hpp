@@ -0,0 +1,135 @@
+//
+//  FretTable.hpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+#ifndef fret_table_hpp
+#define fret_table_hpp
+
+#include "Arena.hpp"
+#include "Geometry.hpp"
+
+namespace fretboarder {
+
+// Per fret geometry of a fretboard stored as a structure of arrays: one contiguous column of doubles per
+// coordinate, all the columns living in the same buffer. Only X and Y are stored, the fretboard is 2D.
+class FretTable {
+public:
+    enum Column {
+        // Fret slots (fret line clipped by the hidden tang borders)
+        slot_x1, slot_y1, slot_x2, slot_y2,
+        // Fret lines (fret line clipped by the fretboard borders)
+        line_x1, line_y1, line_x2, line_y2,
+        // Fret slot shapes corners
+        shape_x0, shape_y0, shape_x1, shape_y1, shape_x2, shape_y2, shape_x3, shape_y3,
+        column_count
+    };
+
+    FretTable() {}
+    // The columns are allocated from arena, which must outlive the table.
+    explicit FretTable(Arena* arena) : _data(ArenaAllocator<double>(arena)) {}
+
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+
+    void resize(size_t size) {
+        _size = size;
+        _data.assign(size * column_count, 0.0);
+    }
+
+    Span<double> column(Column c) { return Span<double>(_data.data() + c * _size, _size); }
+    Span<const double> column(Column c) const { return Span<const double>(_data.data() + c * _size, _size); }
+
+    // The whole table, column after column.
+    Span<const double> data() const { return Span<const double>(_data); }
+
+    Vector slot(size_t i) const { return vector_at(slot_x1, i); }
+    Vector line(size_t i) const { return vector_at(line_x1, i); }
+
+    Quad slot_shape(size_t i) const {
+        return {
+            point_at(shape_x0, i),
+            point_at(shape_x1, i),
+            point_at(shape_x2, i),
+            point_at(shape_x3, i)
+        };
+    }
+
+    void set_slot(size_t i, const Vector& v) { set_vector(slot_x1, i, v); }
+    void set_line(size_t i, const Vector& v) { set_vector(line_x1, i, v); }
+
+    void set_slot_shape(size_t i, const Quad& q) {
+        set_point(shape_x0, i, q.points[0]);
+        set_point(shape_x1, i, q.points[1]);
+        set_point(shape_x2, i, q.points[2]);
+        set_point(shape_x3, i, q.points[3]);
+    }
+
+    // Read only, random access view presenting one kind of element of the table (Vector or Quad) as if it
+    // was stored in an array of structures. Elements are built on the fly and returned by value.
+    template <class T, T (FretTable::*Get)(size_t) const>
+    class View {
+    public:
+        class iterator {
+        public:
+            iterator(const FretTable* table, size_t i) : _table(table), _i(i) {}
+            T operator*() const { return (_table->*Get)(_i); }
+            iterator& operator++() { _i++; return *this; }
+            bool operator==(const iterator& other) const { return _i == other._i; }
+            bool operator!=(const iterator& other) const { return _i != other._i; }
+        private:
+            const FretTable* _table;
+            size_t _i;
+        };
+
+        explicit View(const FretTable* table) : _table(table) {}
+
+        size_t size() const { return _table->size(); }
+        bool empty() const { return _table->empty(); }
+        T operator[](size_t i) const { return (_table->*Get)(i); }
+        T front() const { return (*this)[0]; }
+        T back() const { return (*this)[size() - 1]; }
+        iterator begin() const { return iterator(_table, 0); }
+        iterator end() const { return iterator(_table, size()); }
+
+    private:
+        const FretTable* _table;
+    };
+
+    typedef View<Vector, &FretTable::slot> SlotView;
+    typedef View<Vector, &FretTable::line> LineView;
+    typedef View<Quad, &FretTable::slot_shape> SlotShapeView;
+
+    SlotView slots() const { return SlotView(this); }
+    LineView lines() const { return LineView(this); }
+    SlotShapeView slot_shapes() const { return SlotShapeView(this); }
+
+private:
+    Point point_at(Column x, size_t i) const {
+        return Point(_data[x * _size + i], _data[(x + 1) * _size + i]);
+    }
+
+    Vector vector_at(Column x1, size_t i) const {
+        return Vector(point_at(x1, i), point_at(Column(x1 + 2), i));
+    }
+
+    void set_point(Column x, size_t i, const Point& p) {
+        _data[x * _size + i] = p.x;
+        _data[(x + 1) * _size + i] = p.y;
+    }
+
+    void set_vector(Column x1, size_t i, const Vector& v) {
+        set_point(x1, i, v.point1);
+        set_point(Column(x1 + 2), i, v.point2);
+    }
+
+    size_t _size = 0;
+    ArenaVector<double> _data;
+};
+
+}
+
+#endif /* fret_table_hpp */
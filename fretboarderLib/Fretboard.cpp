@@ -6,10 +6,15 @@
 //  Copyright © 2020 Autodesk. All rights reserved.
 //
 
+#include <cassert>
+#include <cmath>
+#include <cstddef>
 #include "Fretboard.hpp"
+#include "FretboardLayoutPriv.hpp"
+#include "InstrumentFile.hpp"
+#include "InstrumentJson.hpp"
 
 namespace fretboarder {
-std::vector<Preset> Preset::_presets;
 
 void to_json(json& j, const Instrument& i) {
     j = json{
@@ -21,6 +26,7 @@ void to_json(json& j, const Instrument& i) {
         { "has_zero_fret", i.has_zero_fret },
         { "nut_to_zero_fret_offset", i.nut_to_zero_fret_offset },
         { "number_of_frets", i.number_of_frets },
+        { "number_of_frets_per_octave", i.number_of_frets_per_octave },
         { "overhangs", i.overhangs },
         { "overhang_type", i.overhang_type },
         { "hidden_tang_length", i.hidden_tang_length },
@@ -50,6 +56,11 @@ void from_json(const json& j, Instrument& i) {
     j.at("has_zero_fret").get_to(i.has_zero_fret);
     j.at("nut_to_zero_fret_offset").get_to(i.nut_to_zero_fret_offset);
     j.at("number_of_frets").get_to(i.number_of_frets);
+    // Older files are all 12-TET
+    i.number_of_frets_per_octave = 12;
+    if (j.contains("number_of_frets_per_octave")) {
+        j.at("number_of_frets_per_octave").get_to(i.number_of_frets_per_octave);
+    }
     if (j.contains("overhang"))
     {
         double o = 3;
@@ -79,47 +90,464 @@ void from_json(const json& j, Instrument& i) {
     j.at("radius_at_nut").get_to(i.radius_at_nut);
     j.at("radius_at_last_fret").get_to(i.radius_at_last_fret);
     j.at("fretboard_thickness").get_to(i.fretboard_thickness);
-    j.at("number_of_strings").get_to(i.number_of_strings);
     
     i.validate();
     
 }
 
+// Larger boards aren't instruments, and would take more memory than anything built from them
+static const int max_strings = 100;
+static const int max_frets = 1000;
+
+const char* Instrument::build_error() const {
+    if (number_of_strings < 1 || number_of_strings > max_strings) {
+        return "number_of_strings must be between 1 and 100";
+    }
+    if (number_of_frets < 0 || number_of_frets > max_frets) {
+        return "number_of_frets must be between 0 and 1000";
+    }
+    if (!(number_of_frets_per_octave >= 1)) {
+        return "number_of_frets_per_octave must be at least 1";
+    }
+    return nullptr;
+}
+
 bool Instrument::load(const std::string& filename)
 {
-    std::ifstream ifs;
-    ifs.open(filename, std::ifstream::in);
-    if (!ifs.is_open())
+    std::vector<unsigned char> data;
+    if (!read_file(filename, data))
     {
         return false;
     }
-    
-    json j;
-    ifs >> j;
-    ifs.close();
-    
-    *this = j.get<fretboarder::Instrument>();
+
+    Instrument instrument;
+    if (is_binary_instrument(data.data(), data.size()))
+    {
+        if (!read_binary_instrument(data.data(), data.size(), instrument))
+        {
+            return false;
+        }
+    }
+    else if (!parse_instrument_json(reinterpret_cast<const char*>(data.data()), reinterpret_cast<const char*>(data.data()) + data.size(), instrument))
+    {
+        // Left to nlohmann, which knows all of JSON and throws the errors
+        json j = json::parse(data.data(), data.data() + data.size());
+        instrument = j.get<fretboarder::Instrument>();
+    }
+
+    *this = instrument;
     validate();
 
     return true;
 }
 
-bool Instrument::save(const std::string& filename) const
+bool Instrument::save(const std::string& filename, InstrumentFileFormat format) const
 {
     std::ofstream ofs;
-    ofs.open(filename, std::ofstream::out);
+    ofs.open(filename, format == InstrumentFileFormat::binary ? std::ofstream::out | std::ofstream::binary : std::ofstream::out);
     if (!ofs.is_open())
     {
         return false;
     }
     
-    json j;
-    j = *this;
-    ofs << j;
+    if (format == InstrumentFileFormat::binary)
+    {
+        write_binary_instrument(ofs, *this);
+    }
+    else
+    {
+        json j;
+        j = *this;
+        ofs << j;
+    }
 
     ofs.close();
     
-    return true;
+    return bool(ofs);
+}
+
+
+size_t InstrumentField::size() const {
+    switch (type) {
+        case InstrumentFieldType::boolean: return sizeof(bool) * count;
+        case InstrumentFieldType::integer: return sizeof(int) * count;
+        case InstrumentFieldType::real: return sizeof(double) * count;
+        case InstrumentFieldType::overhang_type: return sizeof(OverhangType) * count;
+        case InstrumentFieldType::temperament: return sizeof(const Temperament*) * count;
+    }
+    return 0;
+}
+
+#define FIELD(name, type, stages) { #name, InstrumentFieldType::type, offsetof(Instrument, name), 1, stages }
+#define ARRAY_FIELD(name, type, stages) { #name, InstrumentFieldType::type, offsetof(Instrument, name), int(sizeof(Instrument::name) / sizeof(Instrument::name[0])), stages }
+
+// Anything changing the strings changes everything else. The derived fields (string spacings and y_at_*) are
+// recomputed by Instrument::validate() and are only listed for completeness.
+static const InstrumentField _instrument_fields[] = {
+    FIELD(right_handed, boolean, stage_strings),
+    FIELD(number_of_strings, integer, stage_strings),
+    ARRAY_FIELD(scale_length, real, stage_strings),
+    FIELD(perpendicular_fret_index, real, stage_strings),
+    FIELD(inter_string_spacing_at_nut, real, stage_strings),
+    FIELD(inter_string_spacing_at_bridge, real, stage_strings),
+    FIELD(string_spacing_at_nut, real, stage_strings),
+    FIELD(string_spacing_at_bridge, real, stage_strings),
+    FIELD(y_at_start, real, stage_strings),
+    FIELD(y_at_bridge, real, stage_strings),
+    FIELD(has_zero_fret, boolean, stage_strings),
+    FIELD(nut_to_zero_fret_offset, real, stage_strings),
+    FIELD(number_of_frets_per_octave, real, stage_strings),
+    FIELD(temperament, temperament, stage_strings),
+    FIELD(number_of_frets, integer, stage_borders),
+    FIELD(overhang_type, overhang_type, 0),
+    ARRAY_FIELD(overhangs, real, stage_borders),
+    FIELD(hidden_tang_length, real, stage_tang_borders),
+    FIELD(draw_strings, boolean, 0),
+    FIELD(draw_frets, boolean, 0),
+    FIELD(fret_slots_width, real, stage_fret_slot_shapes),
+    FIELD(fret_slots_height, real, 0),
+    FIELD(fret_crown_width, real, 0),
+    FIELD(fret_crown_height, real, 0),
+    FIELD(carve_fret_slots, boolean, 0),
+    FIELD(last_fret_cut_offset, real, stage_shapes),
+    FIELD(carve_nut_slot, boolean, 0),
+    FIELD(space_before_nut, real, stage_shapes),
+    FIELD(nut_thickness, real, stage_shapes),
+    FIELD(nut_height_under, real, 0),
+    FIELD(radius_at_nut, real, 0),
+    FIELD(radius_at_last_fret, real, 0),
+    FIELD(fretboard_thickness, real, 0),
+};
+
+#undef FIELD
+#undef ARRAY_FIELD
+
+Span<const InstrumentField> instrument_fields() {
+    return Span<const InstrumentField>(_instrument_fields, sizeof(_instrument_fields) / sizeof(_instrument_fields[0]));
+}
+
+const InstrumentField* find_instrument_field(const std::string& name) {
+    for (const auto& field : instrument_fields()) {
+        if (name == field.name) {
+            return &field;
+        }
+    }
+    return nullptr;
+}
+
+double InstrumentField::get(const Instrument& instrument, int element) const {
+    assert(element >= 0 && element < count);
+    const void* p = in(instrument);
+    switch (type) {
+        case InstrumentFieldType::boolean: return static_cast<const bool*>(p)[element] ? 1 : 0;
+        case InstrumentFieldType::integer: return static_cast<const int*>(p)[element];
+        case InstrumentFieldType::real: return static_cast<const double*>(p)[element];
+        case InstrumentFieldType::overhang_type: return static_cast<const OverhangType*>(p)[element];
+        case InstrumentFieldType::temperament: return 0;
+    }
+    return 0;
+}
+
+void InstrumentField::set(Instrument& instrument, double value, int element) const {
+    assert(element >= 0 && element < count);
+    void* p = in(instrument);
+    switch (type) {
+        case InstrumentFieldType::boolean: static_cast<bool*>(p)[element] = value != 0; break;
+        case InstrumentFieldType::integer: static_cast<int*>(p)[element] = int(lround(value)); break;
+        case InstrumentFieldType::real: static_cast<double*>(p)[element] = value; break;
+        case InstrumentFieldType::overhang_type: static_cast<OverhangType*>(p)[element] = OverhangType(lround(value)); break;
+        case InstrumentFieldType::temperament: break;
+    }
+}
+
+void Fretboard::build(const Instrument& instrument, unsigned stages) {
+    _instrument = instrument;
+    if (!instrument.is_buildable()) {
+        clear();
+        return;
+    }
+    if (stages & stage_strings) {
+        build_strings(instrument);
+    }
+    if (stages & stage_borders) {
+        build_borders(instrument);
+    }
+    if (stages & stage_tang_borders) {
+        build_tang_borders(instrument);
+    }
+    if (stages & (stage_fret_lines | stage_fret_slot_shapes)) {
+        build_frets(instrument, stages);
+    }
+    if (stages & stage_shapes) {
+        build_shapes(instrument);
+    }
+    if (stages & stage_construction_distances) {
+        build_construction_distances();
+    }
+}
+
+void Fretboard::clear() {
+    _strings.clear();
+    _fake_strings.clear();
+    _frets.resize(0);
+    _fret_positions.clear();
+    _curved_frets = false;
+    _fret_polylines.clear();
+    _fret_slot_polylines.clear();
+    _fret_slot_outlines.clear();
+    number_of_frets = 0;
+    first_fret = 0;
+    last_fret = 0;
+    _construction_distance_at_nut_side = 0;
+    _construction_distance_at_heel = 0;
+    _construction_distance_at_nut = 0;
+    _construction_distance_at_last_fret = 0;
+    _construction_distance_at_12th_fret = 0;
+    _construction_distance_at_octave = 0;
+    _board_shape = Quad();
+    _nut_shape = Quad();
+    _nut_slot_shape = Quad();
+    _strings_shape = Quad();
+    _valid = false;
+}
+
+void Fretboard::build_strings(const Instrument& instrument) {
+    layout_strings(instrument, StringLayout<double>::from(instrument), _strings);
+
+    has_zero_fret = instrument.has_zero_fret;
+    nut_to_zero_fret_offset = instrument.nut_to_zero_fret_offset;
+}
+
+void Fretboard::build_borders(const Instrument& instrument) {
+    number_of_frets = instrument.number_of_frets;
+
+    layout_fake_strings(instrument, StringLayout<double>::from(instrument), _strings[0], _fake_strings);
+    layout_borders(instrument, first_string(), last_string(), first_border, last_border);
+}
+
+void Fretboard::build_tang_borders(const Instrument& instrument) {
+    first_tang_border = first_border.offset2D(instrument.hidden_tang_length);
+    last_tang_border = last_border.offset2D(-instrument.hidden_tang_length);
+}
+
+void Fretboard::build_frets(const Instrument& instrument, unsigned stages) {
+    const String& first_string = this->first_string();
+    const String& last_string = this->last_string();
+
+    // Make frets slots:
+    first_fret = 1;
+    if (has_zero_fret) {
+        first_fret = 0;
+    }
+    
+    last_fret = instrument.number_of_frets + 1;
+    size_t count = std::max(0, last_fret - first_fret);
+
+    // The fret positions only change with the strings, which also invalidates the fret lines.
+    if (stages & stage_fret_lines) {
+        if (_frets.size() != count) {
+            _frets.resize(count);
+        }
+        _fret_positions.resize(count * 2);
+        for (size_t i = 0; i < count; i++) {
+            int fret_index = first_fret + int(i);
+            _fret_positions[i] = first_string.distance_from_start(fret_index) / first_string.scale_length();
+            _fret_positions[count + i] = last_string.distance_from_start(fret_index) / last_string.scale_length();
+        }
+    }
+    assert(_frets.size() == count && _fret_positions.size() == count * 2);
+
+    // Everything else is computed by the fret kernel
+    FretKernelInput input;
+    input.first_t = Span<const double>(_fret_positions.data(), count);
+    input.last_t = Span<const double>(_fret_positions.data() + count, count);
+    input.first_start = first_string.point_at_nut();
+    input.first_direction = first_string.point_at_bridge() - first_string.point_at_nut();
+    input.last_start = last_string.point_at_nut();
+    input.last_direction = last_string.point_at_bridge() - last_string.point_at_nut();
+    input.fret_slots_width = instrument.fret_slots_width;
+    input.first_border = Line2D(first_border);
+    input.last_border = Line2D(last_border);
+    input.first_tang_border = Line2D(first_tang_border);
+    input.last_tang_border = Line2D(last_tang_border);
+    input.parts = 0;
+    if (stages & stage_fret_lines) {
+        input.parts |= fret_kernel_lines;
+    }
+    if (stages & stage_fret_slot_shapes) {
+        input.parts |= fret_kernel_slot_shapes;
+    }
+    fretboarder::build_frets(input, _frets);
+
+    build_fret_polylines(instrument);
+}
+
+void Fretboard::build_fret_polylines(const Instrument& instrument) {
+    _fret_polylines.clear();
+    _fret_slot_polylines.clear();
+    _fret_slot_outlines.clear();
+    _curved_frets = instrument.temperament && instrument.temperament->has_offsets();
+    if (!_curved_frets) {
+        return;
+    }
+
+    // The strings the frets go through, from the first border to the last one
+    const String* strings[3] = { &first_string(), _strings.data(), &last_string() };
+    bool fake = !_fake_strings.empty();
+    size_t string_count = fake ? 3 : _strings.size();
+    auto string = [&](size_t i) -> const String& { return fake ? *strings[i] : _strings[i]; };
+
+    // One block per kind of polyline: no allocation once the fretboard has been built with as many frets and strings
+    size_t count = _frets.size();
+    _fret_polylines.reserve(count, count * (string_count + 2));
+    _fret_slot_polylines.reserve(count, count * (string_count + 2));
+    _fret_slot_outlines.reserve(count, count * (string_count + 2) * 2);
+
+    // End of a polyline on a border, along its last segment like the fret lines of the table
+    auto clip = [](const Point& end, const Point& before, const Vector& border) {
+        Point p;
+        return Line2D(before, end).intersection(Line2D(border), p) ? p : end;
+    };
+
+    double half_width = instrument.fret_slots_width / 2;
+    for (size_t i = 0; i < count; i++) {
+        int fret_index = first_fret + int(i);
+        Span<Point> line = _fret_polylines.add(string_count + 2);
+        for (size_t s = 0; s < string_count; s++) {
+            line[s + 1] = string(s).point_at_fret(fret_index);
+        }
+        Point first = line[1];
+        Point last = line[string_count];
+        line[0] = clip(first, line[2], first_border);
+        line[string_count + 1] = clip(last, line[string_count - 1], last_border);
+
+        Span<Point> slot = _fret_slot_polylines.add(string_count + 2);
+        std::copy(line.begin() + 1, line.end() - 1, slot.begin() + 1);
+        slot[0] = clip(first, slot[2], first_tang_border);
+        slot[string_count + 1] = clip(last, slot[string_count - 1], last_tang_border);
+
+        // Both sides of the slot, offset like in the fret kernel with mitered joints at the strings. The outline goes
+        // along the second side from the first tang border to the last one and comes back along the first side:
+        // outline[k + 1] is vertex k of the slot on the second side, outline[size - k] on the first one.
+        Span<Point> outline = _fret_slot_outlines.add(string_count * 2 + 4);
+        size_t n = string_count + 2;
+        double offset = (first.x <= last.x ? 1 : -1) * half_width;
+        for (int side = 0; side < 2; side++) {
+            double side_offset = side == 0 ? -offset : offset;
+            Line2D first_segment = Line2D(slot[1], slot[2]).offset(side_offset);
+            Line2D last_segment = Line2D(slot[n - 3], slot[n - 2]).offset(side_offset);
+            Point& start = side == 0 ? outline[0] : outline[1];
+            Point& end = side == 0 ? outline[n + 1] : outline[n];
+            if (!first_segment.intersection(Line2D(first_tang_border), start)) {
+                start = Point(first_segment.x, first_segment.y);
+            }
+            if (!last_segment.intersection(Line2D(last_tang_border), end)) {
+                end = Point(last_segment.x + last_segment.dx, last_segment.y + last_segment.dy);
+            }
+        }
+
+        // The miter is the bisector of the unit normals of the segments (Line2D::offset), scaled to stay at the offset
+        // distance from both of them, each normal is computed once
+        auto normal = [](const Point& from, const Point& to) {
+            Point d = to - from;
+            double length = sqrt(d.x * d.x + d.y * d.y);
+            double inverse = length == 0 ? 0 : 1 / length;
+            return Point(d.y * inverse, -d.x * inverse);
+        };
+        Point before = normal(slot[0], slot[1]);
+        for (size_t k = 1; k + 1 < n; k++) {
+            Point after = normal(slot[k], slot[k + 1]);
+            Point miter = (before + after) * (offset / (1 + dot(before, after)));
+            outline[k + 1] = slot[k] + miter;
+            outline[2 * n - k] = slot[k] - miter;
+            before = after;
+        }
+    }
+}
+
+void Fretboard::build_shapes(const Instrument& instrument) {
+    const String& first_string = this->first_string();
+    const String& last_string = this->last_string();
+
+    // last fret cut is like a last+1th fret. If you have 22 frets, the cut is at a virtual 23th fret.
+    // you can use last_fret_cut_offset to add an X offset to the cut.
+    auto p0 = first_string.point_at_fret(instrument.number_of_frets + 1);
+    auto p1 = last_string.point_at_fret(instrument.number_of_frets + 1);
+    auto last_fret_line = Vector(p0, p1);
+    double sign = (first_string.x_at_bridge() <= last_string.x_at_bridge()) ? 1 : -1;
+    Vector last_fret_cut = last_fret_line.offset2D(sign * instrument.last_fret_cut_offset);
+
+    Vector nut_line = Vector(Point(first_string.x_at_nut(), first_string.y_at_start()), Point(last_string.x_at_nut(), last_string.y_at_start()));
+    
+    // Degenerated instruments (parallel strings and borders...) leave the corners without a single intersection
+    bool valid = true;
+    auto intersection = [&valid](const Vector& a, const Vector& b) {
+        Point p;
+        valid = a.intersect(b, p) == IntersectionResult::found && valid;
+        return p;
+    };
+
+    // board shape
+    Vector board_cut_at_nut = nut_line.offset2D(instrument.space_before_nut);
+    _board_shape = {
+        intersection(board_cut_at_nut, first_border),
+        intersection(last_fret_cut, first_border),
+        intersection(last_fret_cut, last_border),
+        intersection(board_cut_at_nut, last_border)
+    };
+
+    // nut shape
+    auto nut_line_2 = nut_line.offset2D(instrument.nut_thickness);
+    _nut_shape = {
+        intersection(nut_line_2, first_border),
+        intersection(nut_line, first_border),
+        intersection(nut_line, last_border),
+        intersection(nut_line_2, last_border)
+    };
+
+    auto external_line_1 = first_border.offset2D(-5);
+    auto external_line_2 = last_border.offset2D(5);
+    _nut_slot_shape = {
+        intersection(nut_line_2, external_line_1),
+        intersection(nut_line, external_line_1),
+        intersection(nut_line, external_line_2),
+        intersection(nut_line_2, external_line_2)
+    };
+    _valid = valid;
+
+    _strings_shape = {
+        first_string.point_at_nut(),
+        first_string.point_at_bridge(),
+        last_string.point_at_bridge(),
+        last_string.point_at_nut(),
+    };
+}
+
+void Fretboard::points_at_frets(Span<const double> indices, Span<Point> points) const {
+    assert(points.size() >= _strings.size() * indices.size());
+    for (size_t s = 0; s < _strings.size(); s++) {
+        _strings[s].points_at_frets(indices, Span<Point>(points.data() + s * indices.size(), indices.size()));
+    }
+}
+
+void Fretboard::build_construction_distances() {
+    const String& first_string = this->first_string();
+    const String& last_string = this->last_string();
+
+    _construction_distance_at_nut_side = std::min(_board_shape.points[0].x, _board_shape.points[3].x);
+    _construction_distance_at_heel = std::max(_board_shape.points[1].x, _board_shape.points[2].x);
+    _construction_distance_at_nut = (first_string.x_at_nut() + last_string.x_at_nut()) / 2;
+    _construction_distance_at_last_fret = (first_string.point_at_fret(number_of_frets).x + last_string.point_at_fret(number_of_frets).x) / 2;
+
+    _construction_distance_at_12th_fret = 0;
+    if (number_of_frets > 12) {
+        _construction_distance_at_12th_fret = (first_string.point_at_fret(12).x + last_string.point_at_fret(12).x) / 2;
+    }
+    _construction_distance_at_octave = 0;
+    int octave = octave_fret();
+    if (number_of_frets > octave) {
+        _construction_distance_at_octave = (first_string.point_at_fret(octave).x + last_string.point_at_fret(octave).x) / 2;
+    }
 }
 
 }
@@ -13,7 +13,13 @@
 #include <string>
 #include <algorithm>
 #include "String.hpp"
+#include "Temperament.hpp"
 #include "Geometry.hpp"
+#include "Arena.hpp"
+#include "FretTable.hpp"
+#include "FretPolylines.hpp"
+#include "FretKernel.hpp"
+#include "FretboardJacobian.hpp"
 
 #include "json.hpp"
 
@@ -37,8 +43,14 @@ enum OverhangType {
     all = 2
 };
 
+// Format of the files written by Instrument::save(), Instrument::load() reads both.
+enum class InstrumentFileFormat {
+    json,
+    binary // see InstrumentFile.hpp
+};
+
 struct Instrument {
-    Instrument(bool right_handed = true,
+    constexpr Instrument(bool right_handed = true,
     int number_of_strings = 6,
     double scale_length_bass = 64.77,
     double scale_length_treble = 63.50,
@@ -121,6 +133,9 @@ struct Instrument {
     double nut_to_zero_fret_offset = 0.30;
 
     double number_of_frets_per_octave = 12;
+    // Optional, equal temperament when null. Not owned and not saved: it must outlive the instrument and the
+    // fretboards built from it, and be replaced rather than modified for FretboardBuilder to see the change.
+    const Temperament* temperament = nullptr;
     int number_of_frets = 24;
     OverhangType overhang_type = single;
     double overhangs[4] = {0.3, 0.3, 0.3, 0.3};
@@ -147,7 +162,7 @@ struct Instrument {
     
     double fretboard_thickness = 0.7;
     
-    void scale(double K) {
+    constexpr void scale(double K) {
         scale_length[0] *= K;
         scale_length[1] *= K;
 
@@ -185,7 +200,7 @@ struct Instrument {
         validate();
     }
     
-    void validate() {
+    constexpr void validate() {
         string_spacing_at_nut = inter_string_spacing_at_nut * (std::max(2, number_of_strings) - 1);
         string_spacing_at_bridge = inter_string_spacing_at_bridge * (std::max(2, number_of_strings) - 1);
 
@@ -194,103 +209,170 @@ struct Instrument {
         if (!has_zero_fret) {
             nut_to_zero_fret_offset = 0;
         }
+        if (temperament) {
+            number_of_frets_per_octave = temperament->frets_per_octave();
+        }
     }
     
+    // Why no fretboard can be built from the instrument (no strings, more than 1000 frets, less than 1 fret per
+    // octave...), nullptr if one can. Fretboards built from other instruments are empty and not valid.
+    const char* build_error() const;
+    bool is_buildable() const { return build_error() == nullptr; }
+
     bool load(const std::string& filename);
-    bool save(const std::string& filename) const;
+    bool save(const std::string& filename, InstrumentFileFormat format = InstrumentFileFormat::json) const;
 };
 
 void to_json(json& j, const Instrument& i);
 void from_json(const json& j, Instrument& i);
 
 
-static double mmFromInch(double v) { return v * 25.4; }
-static double cmFromInch(double v) { return mmFromInch(v) * 0.1; }
+constexpr double mmFromInch(double v) { return v * 25.4; }
+constexpr double cmFromInch(double v) { return mmFromInch(v) * 0.1; }
 
 struct Preset {
 public:
-    std::string name;
+    const char* name;
     Instrument instrument;
 
-    
-    static std::vector<Preset> presets() {
-        if (_presets.empty()) {
-
-            bool rh = true;
-            double bass = 64.77;
-            double treble = 64.77;
-
-            double spacing_at_nut = 0.72;
-            double spacing_at_bridge = 1.1;
-            
-            double bass_spacing_at_nut = 1.2;
-            double bass_spacing_at_bridge = 1.8;
-
-            double nut_to_zero_fret = 0.30;
-
-            int frets = 24;
-            double overhang = 0.3;
-
-            bool drawStrings = true;
-            bool drawFrets = true;
-            double hidden_tang = 0.2;
-            double slots_width = 0.06;
-            double slots_height = 0.15;
-            double crown_width = 0.3;
-            double crown_height = 0.3;
-
-            double last_fret_offset = 0.0;
-
-            bool nut_slot = true;
-            double space_before_nut = 1.2;
-            double nut_thickness = 0.4;
-            double nut_height = 0.3;
-
-            double thickness = 0.7;
-
-            _presets.push_back({"Telecaster", Instrument(rh, 6, bass, treble, 0, spacing_at_nut, spacing_at_bridge, false, nut_to_zero_fret, 22, overhang, hidden_tang, drawStrings, drawFrets, slots_width, slots_height, crown_width, crown_height, last_fret_offset, nut_slot, space_before_nut, nut_thickness, nut_height, cmFromInch(9.5), cmFromInch(9.5), thickness)});
-            _presets.push_back({"Stratocaster", Instrument(rh, 6, bass, treble, 0, spacing_at_nut, spacing_at_bridge, false, nut_to_zero_fret, 22, overhang, hidden_tang, drawStrings, drawFrets, slots_width, slots_height, crown_width, crown_height, last_fret_offset, nut_slot, space_before_nut, nut_thickness, nut_height, cmFromInch(10), cmFromInch(10), thickness)});
-            _presets.push_back({"Les paul", Instrument(rh, 6, cmFromInch(24.7), cmFromInch(24.7), 0, spacing_at_nut, spacing_at_bridge, false, nut_to_zero_fret, 22, overhang, hidden_tang, drawStrings, drawFrets, slots_width, slots_height, crown_width, crown_height, last_fret_offset, nut_slot, 0, nut_thickness, thickness, cmFromInch(12), cmFromInch(12), thickness)});
-            _presets.push_back({"Jazz bass", Instrument(rh, 4, cmFromInch(34), cmFromInch(34), 0, bass_spacing_at_nut, bass_spacing_at_bridge, false, nut_to_zero_fret, frets, overhang, hidden_tang, drawStrings, drawFrets, slots_width, slots_height, crown_width, crown_height, last_fret_offset, nut_slot, space_before_nut, nut_thickness, nut_height, cmFromInch(12), cmFromInch(12), thickness)});
-            _presets.push_back({"Precision bass", Instrument(rh, 4, cmFromInch(34), cmFromInch(34), 0, bass_spacing_at_nut, bass_spacing_at_bridge, false, nut_to_zero_fret, frets, overhang, hidden_tang, drawStrings, drawFrets, slots_width, slots_height, crown_width, crown_height, last_fret_offset, nut_slot, space_before_nut, nut_thickness, nut_height, cmFromInch(12), cmFromInch(12), thickness)});
-            _presets.push_back({"Boden 6", Instrument(rh, 6, cmFromInch(25.5), cmFromInch(25.0), 0, spacing_at_nut, spacing_at_bridge, true, nut_to_zero_fret, frets, overhang, hidden_tang, drawStrings, drawFrets, slots_width, slots_height, crown_width, crown_height, last_fret_offset, nut_slot, space_before_nut, nut_thickness, nut_height, cmFromInch(12), cmFromInch(20), thickness)});
-            _presets.push_back({"Boden 7", Instrument(rh, 7, cmFromInch(25.5), cmFromInch(25.0),  0, spacing_at_nut, spacing_at_bridge, true, nut_to_zero_fret, frets, overhang, hidden_tang, drawStrings, drawFrets, slots_width, slots_height, crown_width, crown_height, last_fret_offset, nut_slot, space_before_nut, nut_thickness, nut_height, cmFromInch(12), cmFromInch(20), thickness)});
-            _presets.push_back({"Boden bass", Instrument(rh, 4, cmFromInch(34), cmFromInch(32), /*perp_fret_index*/ 7, bass_spacing_at_nut, bass_spacing_at_bridge, true, nut_to_zero_fret, frets, overhang, hidden_tang, drawStrings, drawFrets, slots_width, slots_height, crown_width, crown_height, last_fret_offset, nut_slot, space_before_nut, nut_thickness, nut_height, cmFromInch(16), cmFromInch(20), thickness)});
-            _presets.push_back({"Boden bass 5 strings", Instrument(rh, 5, cmFromInch(34), cmFromInch(32), /*perp_fret_index*/ 7, bass_spacing_at_nut, bass_spacing_at_bridge, true, nut_to_zero_fret, frets, overhang, hidden_tang, drawStrings, drawFrets, slots_width, slots_height, crown_width, crown_height, last_fret_offset, nut_slot, space_before_nut, nut_thickness, nut_height, cmFromInch(16), cmFromInch(20), thickness)});
-        }
-        
-        return _presets;
-    }
-
-private:
-    static std::vector<Preset> _presets;
+    // The built-in presets are computed at compile time.
+    static Span<const Preset> presets();
 };
 
+constexpr Preset make_preset(const char* name, const Instrument& instrument) {
+    return { name, instrument };
+}
+
+constexpr int builtin_preset_count = 9;
+
+constexpr std::array<Preset, builtin_preset_count> make_builtin_presets() {
+    constexpr bool rh = true;
+    constexpr double bass = 64.77;
+    constexpr double treble = 64.77;
 
+    constexpr double spacing_at_nut = 0.72;
+    constexpr double spacing_at_bridge = 1.1;
+    
+    constexpr double bass_spacing_at_nut = 1.2;
+    constexpr double bass_spacing_at_bridge = 1.8;
+
+    constexpr double nut_to_zero_fret = 0.30;
+
+    constexpr int frets = 24;
+    constexpr double overhang = 0.3;
+
+    constexpr bool drawStrings = true;
+    constexpr bool drawFrets = true;
+    constexpr double hidden_tang = 0.2;
+    constexpr double slots_width = 0.06;
+    constexpr double slots_height = 0.15;
+    constexpr double crown_width = 0.3;
+    constexpr double crown_height = 0.3;
+
+    constexpr double last_fret_offset = 0.0;
+
+    constexpr bool nut_slot = true;
+    constexpr double space_before_nut = 1.2;
+    constexpr double nut_thickness = 0.4;
+    constexpr double nut_height = 0.3;
+
+    constexpr double thickness = 0.7;
+
+    return {{
+        make_preset("Telecaster", Instrument(rh, 6, bass, treble, 0, spacing_at_nut, spacing_at_bridge, false, nut_to_zero_fret, 22, overhang, hidden_tang, drawStrings, drawFrets, slots_width, slots_height, crown_width, crown_height, last_fret_offset, nut_slot, space_before_nut, nut_thickness, nut_height, cmFromInch(9.5), cmFromInch(9.5), thickness)),
+        make_preset("Stratocaster", Instrument(rh, 6, bass, treble, 0, spacing_at_nut, spacing_at_bridge, false, nut_to_zero_fret, 22, overhang, hidden_tang, drawStrings, drawFrets, slots_width, slots_height, crown_width, crown_height, last_fret_offset, nut_slot, space_before_nut, nut_thickness, nut_height, cmFromInch(10), cmFromInch(10), thickness)),
+        make_preset("Les paul", Instrument(rh, 6, cmFromInch(24.7), cmFromInch(24.7), 0, spacing_at_nut, spacing_at_bridge, false, nut_to_zero_fret, 22, overhang, hidden_tang, drawStrings, drawFrets, slots_width, slots_height, crown_width, crown_height, last_fret_offset, nut_slot, 0, nut_thickness, thickness, cmFromInch(12), cmFromInch(12), thickness)),
+        make_preset("Jazz bass", Instrument(rh, 4, cmFromInch(34), cmFromInch(34), 0, bass_spacing_at_nut, bass_spacing_at_bridge, false, nut_to_zero_fret, frets, overhang, hidden_tang, drawStrings, drawFrets, slots_width, slots_height, crown_width, crown_height, last_fret_offset, nut_slot, space_before_nut, nut_thickness, nut_height, cmFromInch(12), cmFromInch(12), thickness)),
+        make_preset("Precision bass", Instrument(rh, 4, cmFromInch(34), cmFromInch(34), 0, bass_spacing_at_nut, bass_spacing_at_bridge, false, nut_to_zero_fret, frets, overhang, hidden_tang, drawStrings, drawFrets, slots_width, slots_height, crown_width, crown_height, last_fret_offset, nut_slot, space_before_nut, nut_thickness, nut_height, cmFromInch(12), cmFromInch(12), thickness)),
+        make_preset("Boden 6", Instrument(rh, 6, cmFromInch(25.5), cmFromInch(25.0), 0, spacing_at_nut, spacing_at_bridge, true, nut_to_zero_fret, frets, overhang, hidden_tang, drawStrings, drawFrets, slots_width, slots_height, crown_width, crown_height, last_fret_offset, nut_slot, space_before_nut, nut_thickness, nut_height, cmFromInch(12), cmFromInch(20), thickness)),
+        make_preset("Boden 7", Instrument(rh, 7, cmFromInch(25.5), cmFromInch(25.0),  0, spacing_at_nut, spacing_at_bridge, true, nut_to_zero_fret, frets, overhang, hidden_tang, drawStrings, drawFrets, slots_width, slots_height, crown_width, crown_height, last_fret_offset, nut_slot, space_before_nut, nut_thickness, nut_height, cmFromInch(12), cmFromInch(20), thickness)),
+        make_preset("Boden bass", Instrument(rh, 4, cmFromInch(34), cmFromInch(32), /*perp_fret_index*/ 7, bass_spacing_at_nut, bass_spacing_at_bridge, true, nut_to_zero_fret, frets, overhang, hidden_tang, drawStrings, drawFrets, slots_width, slots_height, crown_width, crown_height, last_fret_offset, nut_slot, space_before_nut, nut_thickness, nut_height, cmFromInch(16), cmFromInch(20), thickness)),
+        make_preset("Boden bass 5 strings", Instrument(rh, 5, cmFromInch(34), cmFromInch(32), /*perp_fret_index*/ 7, bass_spacing_at_nut, bass_spacing_at_bridge, true, nut_to_zero_fret, frets, overhang, hidden_tang, drawStrings, drawFrets, slots_width, slots_height, crown_width, crown_height, last_fret_offset, nut_slot, space_before_nut, nut_thickness, nut_height, cmFromInch(16), cmFromInch(20), thickness))
+    }};
+}
 
+inline constexpr std::array<Preset, builtin_preset_count> builtin_presets = make_builtin_presets();
 
+inline Span<const Preset> Preset::presets() {
+    return Span<const Preset>(builtin_presets);
+}
 
+// Stages of the construction of a Fretboard. Each stage only depends on some fields of the Instrument and on the
+// stages before it, FretboardBuilder uses this to only recompute what changed.
+enum FretboardStage {
+    stage_strings = 1 << 0,
+    stage_borders = 1 << 1,
+    stage_tang_borders = 1 << 2,
+    stage_fret_lines = 1 << 3,
+    stage_fret_slot_shapes = 1 << 4,
+    stage_shapes = 1 << 5,
+    stage_construction_distances = 1 << 6,
+    stage_all = (1 << 7) - 1
+};
 
-struct Quad {
-    Point points[4];
+enum class InstrumentFieldType {
+    boolean,
+    integer,
+    real,
+    overhang_type,
+    temperament // not a number, get() is 0 and set() does nothing
 };
 
+// Description of a field of Instrument, to go through them without naming each one.
+struct InstrumentField {
+    const char* name;
+    InstrumentFieldType type;
+    size_t offset;
+    int count; // number of elements for arrays, 1 otherwise
+    unsigned stages; // FretboardStages directly using this field
+
+    size_t size() const;
+
+    // Value of an element of the field as a double (booleans are 0 or 1, integers are rounded when set).
+    double get(const Instrument& instrument, int element = 0) const;
+    void set(Instrument& instrument, double value, int element = 0) const;
+    const void* in(const Instrument& instrument) const { return reinterpret_cast<const char*>(&instrument) + offset; }
+    void* in(Instrument& instrument) const { return reinterpret_cast<char*>(&instrument) + offset; }
+};
+
+// Every field of Instrument, in declaration order.
+Span<const InstrumentField> instrument_fields();
+
+// nullptr if Instrument has no field with this name.
+const InstrumentField* find_instrument_field(const std::string& name);
+
+class FretboardBuilder;
+
 class Fretboard {
 private:
-    std::vector<String> _strings;
+    friend class FretboardBuilder;
+
+    // What the fretboard was last built from
+    Instrument _instrument;
+
+    ArenaVector<String> _strings;
     int number_of_frets;
     bool has_zero_fret;
     double nut_to_zero_fret_offset;
 
+    // Fake outer strings built from the overhangs when the instrument has only one string.
+    ArenaVector<String> _fake_strings;
+
     Vector first_border;
     Vector last_border;
 
     Vector first_tang_border;
     Vector last_tang_border;
 
-    std::vector<Vector> _fret_slots;
-    std::vector<Vector> _fret_lines;
-    std::vector<Quad> _fret_slot_shapes;
+    FretTable _frets;
+    // Position of the frets along the outer strings, as a ratio of their scale length (see FretKernelInput).
+    ArenaVector<double> _fret_positions;
+
+    // Only built when the frets go through a different point on each string, see has_curved_frets()
+    bool _curved_frets = false;
+    FretPolylines _fret_polylines;
+    FretPolylines _fret_slot_polylines;
+    FretPolylines _fret_slot_outlines;
     
     int first_fret;
     int last_fret;
@@ -300,195 +382,97 @@ private:
     double _construction_distance_at_nut = 0;
     double _construction_distance_at_last_fret = 0;
     double _construction_distance_at_12th_fret = 0;
+    double _construction_distance_at_octave = 0;
     
     Quad _board_shape;
     Quad _nut_shape;
     Quad _nut_slot_shape;
     Quad _strings_shape;
-    
-public:
-    Fretboard(const Instrument& instrument) {
-        double first = instrument.scale_length[instrument.right_handed? 1 : 0];
-        double last = instrument.scale_length[instrument.right_handed? 0 : 1];
-
-        double max = instrument.number_of_strings - 1;
-        double diff = (last - first);
-        double ydiff_start = -instrument.y_at_start * 2;
-        double ydiff_bridge = -instrument.y_at_bridge * 2;
-
-        for (int i = 0; i < instrument.number_of_strings; i++) {
-            double ratio;
-            
-            if (max == 0) {
-                ratio = 0.5;
-            } else {
-                ratio = (double)i / max;
-            }
-            double length = first + ratio * diff;
-            double ystart = instrument.y_at_start + ratio * ydiff_start;
-            double ybridge = instrument.y_at_bridge + ratio * ydiff_bridge;
-            _strings.push_back(fretboarder::String(i,
-                                     length,
-                                     instrument.perpendicular_fret_index,
-                                     ystart,
-                                     ybridge,
-                                     instrument.has_zero_fret,
-                                     instrument.nut_to_zero_fret_offset,
-                                     instrument.number_of_frets_per_octave));
-        }
-
-        // Compute global X offset (average of the X offsets of each string)
-        double offsetSum = 0;
-        for (int i = 0; i < instrument.number_of_strings; i++) {
-            offsetSum += _strings[i].x_at_start();
-        }
-        double offset = offsetSum / (double)instrument.number_of_strings;
-        for (int i = 0; i < instrument.number_of_strings; i++) {
-            _strings[i].set_x_offset(-offset);
-        }
 
+    bool _valid = true;
 
-        number_of_frets = instrument.number_of_frets;
-        has_zero_fret = instrument.has_zero_fret;
-        nut_to_zero_fret_offset = instrument.nut_to_zero_fret_offset;
+    // Recomputes the given FretboardStages, the stages they depend on must be up to date.
+    void build(const Instrument& instrument, unsigned stages);
+    // Empty and not valid, for instruments that aren't buildable
+    void clear();
 
-        String first_string(_strings.front());
-        String last_string(_strings.back());
-        
-        if (instrument.number_of_strings == 1) {
-            // Create false first and last string
-            first_string = fretboarder::String(0,
-                                               _strings[0].scale_length(),
-                                               instrument.perpendicular_fret_index,
-                                               instrument.overhangs[0],
-                                               instrument.overhangs[1],
-                                               instrument.has_zero_fret,
-                                               instrument.nut_to_zero_fret_offset,
-                                               instrument.number_of_frets_per_octave);
-
-            last_string = fretboarder::String(0,
-                                               _strings[0].scale_length(),
-                                               instrument.perpendicular_fret_index,
-                                               -instrument.overhangs[2],
-                                               -instrument.overhangs[3],
-                                               instrument.has_zero_fret,
-                                               instrument.nut_to_zero_fret_offset,
-                                               instrument.number_of_frets_per_octave);
-        }
-
-        {
-            // Compute fretboard area by extending the strings with the overhangs at first and last frets
-            Vector first_fret = Vector(first_string.point_at_fret(0), last_string.point_at_fret(0));
-            Vector last_fret = Vector(first_string.point_at_fret(instrument.number_of_frets), last_string.point_at_fret(instrument.number_of_frets));
-
-            first_border = first_string.line().offset2D(instrument.overhangs[0], first_fret, instrument.overhangs[1], last_fret);
-            last_border = last_string.line().offset2D(-instrument.overhangs[2], first_fret, -instrument.overhangs[3], last_fret);
-        }
-        
-        first_tang_border = first_border.offset2D(instrument.hidden_tang_length);
-        last_tang_border = last_border.offset2D(-instrument.hidden_tang_length);
-        
-        // Make frets slots:
-        first_fret = 1;
-        if (has_zero_fret) {
-            first_fret = 0;
-        }
-        
-        last_fret = instrument.number_of_frets + 1;
-        for (int fret_index = first_fret; fret_index < last_fret; fret_index++) {
-            Vector fret_line = Vector(first_string.point_at_fret(fret_index), last_string.point_at_fret(fret_index));
-            _fret_slots.push_back(Vector(fret_line.intersection(first_tang_border), fret_line.intersection(last_tang_border)));
-            _fret_lines.push_back(Vector(fret_line.intersection(first_border), fret_line.intersection(last_border)));
-        }
+    void build_strings(const Instrument& instrument);
+    void build_borders(const Instrument& instrument);
+    void build_tang_borders(const Instrument& instrument);
+    void build_frets(const Instrument& instrument, unsigned stages);
+    void build_fret_polylines(const Instrument& instrument);
+    void build_shapes(const Instrument& instrument);
+    void build_construction_distances();
 
-        for (int fret_index = first_fret; fret_index < last_fret; fret_index++) {
-            auto point1 = first_string.point_at_fret(fret_index);
-            auto point2 = last_string.point_at_fret(fret_index);
-            auto fret_line = Vector(point1, point2);
-            double sign = point1.x <= point2.x ? 1 : -1;
-            Vector offset_line1 = fret_line.offset2D(sign * -instrument.fret_slots_width / 2);
-            Vector offset_line2 = fret_line.offset2D(sign * instrument.fret_slots_width / 2);
-
-            _fret_slot_shapes.push_back(
-                {
-                    offset_line1.intersection(first_tang_border),
-                    offset_line2.intersection(first_tang_border),
-                    offset_line2.intersection(last_tang_border),
-                    offset_line1.intersection(last_tang_border)
-                }
-            );
-        }
-        
-        // last fret cut is like a last+1th fret. If you have 22 frets, the cut is at a virtual 23th fret.
-        // you can use last_fret_cut_offset to add an X offset to the cut.
-        auto p0 = first_string.point_at_fret(last_fret);
-        auto p1 = last_string.point_at_fret(last_fret);
-        auto last_fret_line = Vector(p0, p1);
-        double sign = (first_string.x_at_bridge() <= last_string.x_at_bridge()) ? 1 : -1;
-        Vector last_fret_cut = last_fret_line.offset2D(sign * instrument.last_fret_cut_offset);
-
-        Vector nut_line = Vector(Point(first_string.x_at_nut(), first_string.y_at_start()), Point(last_string.x_at_nut(), last_string.y_at_start()));
-        
-        // board shape
-        Vector board_cut_at_nut = nut_line.offset2D(instrument.space_before_nut);
-        _board_shape = {
-            board_cut_at_nut.intersection(first_border),
-            last_fret_cut.intersection(first_border),
-            last_fret_cut.intersection(last_border),
-            board_cut_at_nut.intersection(last_border)
-        };
-
-        _construction_distance_at_nut_side = std::min(_board_shape.points[0].x, _board_shape.points[3].x);
-        _construction_distance_at_heel = std::max(_board_shape.points[1].x, _board_shape.points[2].x);
-        _construction_distance_at_nut = (first_string.x_at_nut() + last_string.x_at_nut()) / 2;
-        _construction_distance_at_last_fret = (first_string.point_at_fret(number_of_frets).x + last_string.point_at_fret(number_of_frets).x) / 2;
-
-        if (number_of_frets > 12) {
-            _construction_distance_at_12th_fret = (first_string.point_at_fret(12).x + last_string.point_at_fret(12).x) / 2;
-        }
+    const String& first_string() const { return _fake_strings.empty() ? _strings.front() : _fake_strings.front(); }
+    const String& last_string() const { return _fake_strings.empty() ? _strings.back() : _fake_strings.back(); }
+    
+public:
+    Fretboard(const Instrument& instrument) {
+        build(instrument, stage_all);
+    }
 
-        // nut shape
-        auto nut_line_2 = nut_line.offset2D(instrument.nut_thickness);
-        _nut_shape = {
-            nut_line_2.intersection(first_border),
-            nut_line.intersection(first_border),
-            nut_line.intersection(last_border),
-            nut_line_2.intersection(last_border)
-        };
-
-        auto external_line_1 = first_border.offset2D(-5);
-        auto external_line_2 = last_border.offset2D(5);
-        _nut_slot_shape = {
-            nut_line_2.intersection(external_line_1),
-            nut_line.intersection(external_line_1),
-            nut_line.intersection(external_line_2),
-            nut_line_2.intersection(external_line_2)
-        };
-
-        _strings_shape = {
-            first_string.point_at_nut(),
-            first_string.point_at_bridge(),
-            last_string.point_at_bridge(),
-            last_string.point_at_nut(),
-        };
-        
+    // Same but all the memory of the fretboard comes from arena, which must outlive it. Everything is sized up front
+    // from the number of strings and frets: when the arena is reused, construction doesn't allocate at all.
+    Fretboard(const Instrument& instrument, Arena& arena) :
+        _strings(ArenaAllocator<String>(&arena)),
+        _fake_strings(ArenaAllocator<String>(&arena)),
+        _frets(&arena),
+        _fret_positions(ArenaAllocator<double>(&arena)),
+        _fret_polylines(&arena),
+        _fret_slot_polylines(&arena),
+        _fret_slot_outlines(&arena) {
+        build(instrument, stage_all);
     }
     
-    const std::vector<Vector>& fret_slots() const { return _fret_slots; }
-    const std::vector<Vector>& fret_lines() const { return _fret_lines; }
-    const std::vector<Quad>& fret_slot_shapes() const { return _fret_slot_shapes; }
-    const std::vector<String>& strings() const { return _strings; }
-
-    double construction_distance_at_nut_side() { return _construction_distance_at_nut_side; }
-    double construction_distance_at_heel() { return _construction_distance_at_heel; }
-    double construction_distance_at_nut() { return _construction_distance_at_nut; }
-    double construction_distance_at_last_fret() { return _construction_distance_at_last_fret; }
-    double construction_distance_at_12th_fret() { return _construction_distance_at_12th_fret; }
-
-    const Quad& board_shape() { return _board_shape; }
-    const Quad& nut_shape() { return _nut_shape; }
-    const Quad& nut_slot_shape() { return _nut_slot_shape; }
-    const Quad& strings_shape() { return _strings_shape; }
+    // Views over the fret table, elements are built on the fly from its columns.
+    FretTable::SlotView fret_slots() const { return _frets.slots(); }
+    FretTable::LineView fret_lines() const { return _frets.lines(); }
+    FretTable::SlotShapeView fret_slot_shapes() const { return _frets.slot_shapes(); }
+    const FretTable& fret_table() const { return _frets; }
+
+    // True when the strings are tempered differently (see Temperament::set_offsets()): the frets aren't straight and
+    // the fret lines and slots of the table only join their ends on the outer strings. The polylines below then go
+    // through the point of each string at the fret, from the first border to the last one, and the slot outlines are
+    // the closed outlines of the slots around them, in the same order as the corners of the slot shapes. They are
+    // empty when the frets are straight.
+    bool has_curved_frets() const { return _curved_frets; }
+    const FretPolylines& fret_polylines() const { return _fret_polylines; }
+    const FretPolylines& fret_slot_polylines() const { return _fret_slot_polylines; }
+    const FretPolylines& fret_slot_outlines() const { return _fret_slot_outlines; }
+    const Instrument& instrument() const { return _instrument; }
+    const ArenaVector<String>& strings() const { return _strings; }
+
+    double construction_distance_at_nut_side() const { return _construction_distance_at_nut_side; }
+    double construction_distance_at_heel() const { return _construction_distance_at_heel; }
+    double construction_distance_at_nut() const { return _construction_distance_at_nut; }
+    double construction_distance_at_last_fret() const { return _construction_distance_at_last_fret; }
+    // At the 12th fret, whatever the number of frets per octave, 0 if the fretboard is shorter.
+    double construction_distance_at_12th_fret() const { return _construction_distance_at_12th_fret; }
+    // At the octave, see octave_fret(), 0 if the fretboard is shorter.
+    double construction_distance_at_octave() const { return _construction_distance_at_octave; }
+    // The fret an octave above the open strings: the 12th in 12-TET, the 31st in 31-EDO...
+    int octave_fret() const { return int(lround(_instrument.number_of_frets_per_octave)); }
+
+    const Quad& board_shape() const { return _board_shape; }
+    const Quad& nut_shape() const { return _nut_shape; }
+    const Quad& nut_slot_shape() const { return _nut_slot_shape; }
+    const Quad& strings_shape() const { return _strings_shape; }
+
+    // False when the instrument is degenerated (strings parallel to the nut...): some corners of the shapes have no
+    // single intersection to be built from and are left at the origin. Also false, with no strings and no frets, when
+    // the instrument isn't buildable (see Instrument::is_buildable()).
+    bool is_valid() const { return _valid; }
+
+    // Points of every string at every fret index, string after string: points[s * indices.size() + i] is
+    // strings()[s].point_at_fret(indices[i]). points must be at least strings().size() * indices.size() large.
+    void points_at_frets(Span<const double> indices, Span<Point> points) const;
+
+    // Derivatives of the positions of the frets with respect to the scale lengths, the perpendicular fret and the
+    // string spacings of the instrument. Much cheaper than finite differences: no fretboard is built.
+    FretboardJacobian jacobian() const;
+    // Same in place: once its buffers have grown large enough, computing another jacobian doesn't allocate.
+    void jacobian(FretboardJacobian& jacobian) const;
 
 };
 
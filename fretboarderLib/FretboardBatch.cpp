@@ -0,0 +1,54 @@
+//
+//  FretboardBatch.cpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+#include <algorithm>
+#include <new>
+#include "FretboardBatch.hpp"
+
+namespace fretboarder {
+
+FretboardBatch::~FretboardBatch() {
+    clear();
+}
+
+void FretboardBatch::clear() {
+    for (Fretboard* fretboard : _fretboards) {
+        if (fretboard) {
+            fretboard->~Fretboard();
+        }
+    }
+    _fretboards.clear();
+    for (auto& arena : _arenas) {
+        arena->reset();
+    }
+}
+
+void generate_batch(Span<const Instrument> instruments, FretboardBatch& output, ThreadPool& pool) {
+    output.clear();
+    while (output._arenas.size() < pool.thread_count()) {
+        output._arenas.emplace_back(new Arena());
+    }
+    output._fretboards.resize(instruments.size(), nullptr);
+
+    // Small chunks so that stealing can balance the load, big enough to not fight over the queues.
+    size_t grain = std::min<size_t>(64, std::max<size_t>(1, instruments.size() / (pool.thread_count() * 8)));
+
+    pool.parallel_for(instruments.size(), grain, [&](size_t begin, size_t end, size_t worker) {
+        Arena& arena = *output._arenas[worker];
+        for (size_t i = begin; i < end; i++) {
+            void* memory = arena.allocate(sizeof(Fretboard), alignof(Fretboard));
+            output._fretboards[i] = new (memory) Fretboard(instruments[i], arena);
+        }
+    });
+}
+
+void generate_batch(Span<const Instrument> instruments, FretboardBatch& output) {
+    generate_batch(instruments, output, ThreadPool::shared());
+}
+
+}
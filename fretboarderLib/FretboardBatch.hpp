@@ -0,0 +1,54 @@
+//
+//  FretboardBatch.hpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+#ifndef fretboard_batch_hpp
+#define fretboard_batch_hpp
+
+#include <memory>
+#include <vector>
+#include "Arena.hpp"
+#include "Fretboard.hpp"
+#include "ThreadPool.hpp"
+
+namespace fretboarder {
+
+// Fretboards built by generate_batch(), in the order of the instruments they were built from. They live in
+// arenas owned by the batch (one per worker) and stay valid until the batch is cleared, reused or destroyed.
+// Reusing a batch reuses its memory: once warmed up, generating a batch doesn't allocate anything.
+class FretboardBatch {
+public:
+    FretboardBatch() {}
+    ~FretboardBatch();
+
+    FretboardBatch(const FretboardBatch&) = delete;
+    FretboardBatch& operator=(const FretboardBatch&) = delete;
+
+    size_t size() const { return _fretboards.size(); }
+    bool empty() const { return _fretboards.empty(); }
+    const Fretboard& operator[](size_t i) const { return *_fretboards[i]; }
+
+    // Destroys the fretboards, keeping the memory for the next batch.
+    void clear();
+
+private:
+    friend void generate_batch(Span<const Instrument> instruments, FretboardBatch& output, ThreadPool& pool);
+
+    std::vector<std::unique_ptr<Arena>> _arenas;
+    std::vector<Fretboard*> _fretboards;
+};
+
+// Builds the fretboard of every instrument in parallel on pool, output[i] being the fretboard of instruments[i].
+// The fretboards of instruments that aren't buildable (see Instrument::is_buildable()) are empty and not valid.
+void generate_batch(Span<const Instrument> instruments, FretboardBatch& output, ThreadPool& pool);
+
+// Same, on the shared pool.
+void generate_batch(Span<const Instrument> instruments, FretboardBatch& output);
+
+}
+
+#endif /* fretboard_batch_hpp */
@@ -0,0 +1,69 @@
+//
+//  FretboardBuilder.cpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+#include <cstring>
+#include "FretboardBuilder.hpp"
+
+namespace fretboarder {
+
+// Stages directly depending on the result of each stage, see Fretboard::build().
+static const struct {
+    unsigned stage;
+    unsigned dependents;
+} stage_dependencies[] = {
+    { stage_strings, stage_borders },
+    { stage_borders, stage_tang_borders | stage_fret_lines | stage_shapes },
+    { stage_tang_borders, stage_fret_lines | stage_fret_slot_shapes },
+    { stage_fret_lines, 0 },
+    { stage_fret_slot_shapes, 0 },
+    { stage_shapes, stage_construction_distances },
+    { stage_construction_distances, 0 },
+};
+
+unsigned FretboardBuilder::dependent_stages(unsigned stages) {
+    // Stages are listed in build order, so a single pass propagates everything.
+    for (const auto& dependency : stage_dependencies) {
+        if (stages & dependency.stage) {
+            stages |= dependency.dependents;
+        }
+    }
+    return stages;
+}
+
+unsigned FretboardBuilder::stages_to_update(const Instrument& previous, const Instrument& next) {
+    unsigned stages = 0;
+    for (const auto& field : instrument_fields()) {
+        // Compare the bytes: this is conservative (-0 != 0) but never misses a change.
+        if ((field.stages & ~stages) && memcmp(field.in(previous), field.in(next), field.size()) != 0) {
+            stages |= field.stages;
+        }
+    }
+    return dependent_stages(stages);
+}
+
+const Fretboard& FretboardBuilder::build(const Instrument& instrument) {
+    if (!_fretboard) {
+        _fretboard.emplace(instrument);
+        _last_stages = stage_all;
+    } else {
+        // Nothing was built from an instrument that isn't buildable
+        _last_stages = _instrument.is_buildable() ? stages_to_update(_instrument, instrument) : unsigned(stage_all);
+        // Even with nothing to recompute, the fretboard takes the instrument: carve_nut_slot, draw_frets... are
+        // read from it.
+        _fretboard->build(instrument, _last_stages);
+    }
+    _instrument = instrument;
+    return *_fretboard;
+}
+
+void FretboardBuilder::reset() {
+    _fretboard.reset();
+    _last_stages = 0;
+}
+
+}
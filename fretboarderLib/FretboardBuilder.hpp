@@ -0,0 +1,49 @@
+//
+//  FretboardBuilder.hpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+#ifndef fretboard_builder_hpp
+#define fretboard_builder_hpp
+
+#include <optional>
+#include "Fretboard.hpp"
+
+namespace fretboarder {
+
+// Keeps the last Fretboard built, and the Instrument it was built from, so that rebuilding it after a change of
+// the instrument only recomputes the FretboardStages depending on the fields that actually changed.
+// Changing fret_slots_width only recomputes the fret slot shapes, changing nut_thickness only the shapes, etc.
+class FretboardBuilder {
+public:
+    // The first call builds everything, the next ones update the previous fretboard in place.
+    const Fretboard& build(const Instrument& instrument);
+
+    bool has_fretboard() const { return _fretboard.has_value(); }
+    const Fretboard& fretboard() const { return *_fretboard; }
+    const Instrument& instrument() const { return _instrument; }
+
+    // FretboardStages recomputed by the last call to build().
+    unsigned last_stages() const { return _last_stages; }
+
+    // Forget the previous fretboard, the next build() recomputes everything.
+    void reset();
+
+    // FretboardStages to recompute when going from previous to next, including the stages depending on them.
+    static unsigned stages_to_update(const Instrument& previous, const Instrument& next);
+
+    // stages and every stage that depends on them.
+    static unsigned dependent_stages(unsigned stages);
+
+private:
+    std::optional<Fretboard> _fretboard;
+    Instrument _instrument;
+    unsigned _last_stages = 0;
+};
+
+}
+
+#endif /* fretboard_builder_hpp */
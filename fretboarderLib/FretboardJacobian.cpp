@@ -0,0 +1,243 @@
+//
+//  FretboardJacobian.cpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+#include "Dual.hpp"
+#include "FretboardJacobian.hpp"
+#include "FretboardLayoutPriv.hpp"
+
+namespace fretboarder {
+
+typedef Dual<double, FretboardJacobian::parameter_count> JacobianScalar;
+typedef BasicPoint<JacobianScalar> JacobianPoint;
+
+// The position of a fret along a string, as a ratio t of its scale length, only depends on the fret index and on the
+// temperament of the string. The points at frets are then linear in t and only the ends of the strings need to be
+// differentiated.
+struct StringEnds {
+    JacobianPoint start;
+    JacobianPoint direction; // start to bridge
+
+    JacobianPoint at(double t) const { return JacobianPoint(start.x + direction.x * t, start.y + direction.y * t); }
+};
+
+// Ratios of the perpendicular fret on a string with the ratio table of the string (see BasicString): rho, the ratio of
+// the perpendicular fret, and nut, rho - 1 or, behind the nut where BasicString goes through a virtual string
+// starting at the perpendicular fret, rho * (1 - the ratio of -index), which is also rho - 1 in equal temperament.
+struct PerpendicularRatios {
+    JacobianScalar rho;
+    JacobianScalar nut;
+};
+
+static PerpendicularRatios perpendicular_ratios(const FretRatioTable* table, const JacobianScalar& index,
+                                                double frets_per_octave, bool behind_nut) {
+    auto ratio = [table, frets_per_octave](const JacobianScalar& i) {
+        return table ? table->ratio(i) : exp2(i / -frets_per_octave);
+    };
+    JacobianScalar rho = ratio(index);
+    return { rho, behind_nut ? rho * (1.0 - ratio(-index)) : rho - 1.0 };
+}
+
+// Ends of a string as BasicString lays it out, before the x offset of layout_strings(), in closed form. With S =
+// sqrt(scale_length^2 - (y_at_bridge - y_at_start)^2) the length of the string along x, x_at_start is nut * S and
+// x_at_bridge rho * S. Behind the nut, x_at_start is nut * scale_length. Unlike BasicString's square roots, this is
+// differentiable with the perpendicular fret at the nut.
+static StringEnds string_ends(const JacobianScalar& scale_length, const PerpendicularRatios& ratios, bool behind_nut,
+                              const JacobianScalar& y_at_start, const JacobianScalar& y_at_bridge) {
+    JacobianScalar height = y_at_bridge - y_at_start;
+    JacobianScalar length = sqrt(scale_length * scale_length - height * height);
+    JacobianScalar x_at_start = ratios.nut * (behind_nut ? scale_length : length);
+    return { JacobianPoint(x_at_start, y_at_start), JacobianPoint(ratios.rho * length - x_at_start, height) };
+}
+
+// Intersection of the fret lines with a border. With the ends of a fret being first.start + t1 * first.direction and
+// last.start + t2 * last.direction, the intersection is at (a - b * t1) / (c + e * t2 - b * t1) along the fret (see
+// BasicLine2D::intersection), a, b, c and e being the same for every fret.
+struct BorderClip {
+    JacobianScalar a, b, c, e;
+
+    BorderClip(const StringEnds& first, const StringEnds& last, const BasicVector<JacobianScalar>& border) {
+        BasicLine2D<JacobianScalar> line(border);
+        auto cross = [&line](const JacobianScalar& x, const JacobianScalar& y) { return x * line.dy - y * line.dx; };
+        a = cross(line.x - first.start.x, line.y - first.start.y);
+        b = cross(first.direction.x, first.direction.y);
+        c = cross(last.start.x - first.start.x, last.start.y - first.start.y);
+        e = cross(last.direction.x, last.direction.y);
+    }
+};
+
+FretboardJacobian Fretboard::jacobian() const {
+    FretboardJacobian jacobian;
+    this->jacobian(jacobian);
+    return jacobian;
+}
+
+void Fretboard::jacobian(FretboardJacobian& jacobian) const {
+    typedef JacobianScalar D;
+    const Instrument& instrument = _instrument;
+    jacobian._string_count = _strings.size();
+    jacobian._fret_count = _frets.size();
+    if (_strings.empty()) {
+        // Not buildable
+        jacobian._string_points.clear();
+        jacobian._fret_lines.clear();
+        return;
+    }
+
+    // The parameters as variables, laid out like layout_strings() does: scale lengths and y interpolated from the
+    // first string to the last one, then centered on the average x at start. The values come from the same formulas
+    // as the strings of the fretboard, only the ends of the strings are differentiated.
+    D scale_length[2] = {
+        D::variable(instrument.scale_length[0], FretboardJacobian::scale_length_treble),
+        D::variable(instrument.scale_length[1], FretboardJacobian::scale_length_bass)
+    };
+    D first_length = scale_length[instrument.right_handed ? 1 : 0];
+    D length_diff = scale_length[instrument.right_handed ? 0 : 1] - first_length;
+    D perpendicular_fret_index = D::variable(instrument.perpendicular_fret_index, FretboardJacobian::perpendicular_fret_index);
+    // See Instrument::validate()
+    double spacings = (std::max(2, instrument.number_of_strings) - 1) / 2.0;
+    D y_at_start = D::variable(instrument.inter_string_spacing_at_nut, FretboardJacobian::inter_string_spacing_at_nut) * spacings;
+    D y_at_bridge = D::variable(instrument.inter_string_spacing_at_bridge, FretboardJacobian::inter_string_spacing_at_bridge) * spacings;
+    bool behind_nut = instrument.perpendicular_fret_index < 0;
+    double frets_per_octave = instrument.number_of_frets_per_octave;
+
+    // Only the outer strings are differentiated as dual numbers. The scale length and y of the other strings are
+    // linear in their ratio, interpolated from the outer ones, and only their length along x goes through the chain
+    // rule. Their derivatives are kept in the order of the output for the points at frets.
+    const int size = FretboardJacobian::parameter_count * 2;
+    jacobian._ends.resize(_strings.size() * size * 2);
+    double max = double(_strings.size()) - 1;
+    D height = y_at_bridge - y_at_start;
+    D x_offset;
+    PerpendicularRatios ratios;
+    for (size_t s = 0; s < _strings.size(); s++) {
+        // Strings sharing a table have the same ratios
+        if (s == 0 || _strings[s].ratios() != _strings[s - 1].ratios()) {
+            ratios = perpendicular_ratios(_strings[s].ratios(), perpendicular_fret_index, frets_per_octave, behind_nut);
+        }
+        double ratio = max == 0 ? 0.5 : s / max;
+        double y_ratio = 1 - 2 * ratio;
+        double length = first_length.value + length_diff.value * ratio;
+        double h = height.value * y_ratio;
+        double x_length = sqrt(length * length - h * h);
+        double inverse = 1 / x_length;
+        double* start = &jacobian._ends[s * size * 2];
+        double* direction = start + size;
+        for (int parameter = 0; parameter < FretboardJacobian::parameter_count; parameter++) {
+            double dlength = first_length.derivatives[parameter] + length_diff.derivatives[parameter] * ratio;
+            double dh = height.derivatives[parameter] * y_ratio;
+            double dx_length = (length * dlength - h * dh) * inverse;
+            double dx_at_start = ratios.nut.derivatives[parameter] * (behind_nut ? length : x_length)
+                               + ratios.nut.value * (behind_nut ? dlength : dx_length);
+            start[parameter * 2] = dx_at_start;
+            start[parameter * 2 + 1] = y_at_start.derivatives[parameter] * y_ratio;
+            direction[parameter * 2] = ratios.rho.derivatives[parameter] * x_length + ratios.rho.value * dx_length - dx_at_start;
+            direction[parameter * 2 + 1] = dh;
+            x_offset.derivatives[parameter] += dx_at_start;
+        }
+        x_offset.value += ratios.nut.value * (behind_nut ? length : x_length);
+    }
+    x_offset = x_offset / double(_strings.size());
+
+    // Outer strings, or fake ones around a single string, see layout_fake_strings(), without the x offset
+    StringEnds first, last;
+    PerpendicularRatios first_ratios = perpendicular_ratios(_strings.front().ratios(), perpendicular_fret_index, frets_per_octave, behind_nut);
+    PerpendicularRatios last_ratios = perpendicular_ratios(_strings.back().ratios(), perpendicular_fret_index, frets_per_octave, behind_nut);
+    if (_fake_strings.empty()) {
+        first = string_ends(first_length, first_ratios, behind_nut, y_at_start, y_at_bridge);
+        last = string_ends(first_length + length_diff, last_ratios, behind_nut, -y_at_start, -y_at_bridge);
+        first.start.x -= x_offset;
+        last.start.x -= x_offset;
+    } else {
+        D length = first_length + length_diff * 0.5;
+        first = string_ends(length, first_ratios, behind_nut, D(instrument.overhangs[0]), D(instrument.overhangs[1]));
+        last = string_ends(length, last_ratios, behind_nut, D(-instrument.overhangs[2]), D(-instrument.overhangs[3]));
+    }
+
+    // Same borders as build_borders(), at the same fret positions
+    auto ratio = [this](const String& string, int fret) {
+        return string.distance_from_start(fret) / string.scale_length();
+    };
+    JacobianPoint first_ends[2] = { first.at(ratio(first_string(), 0)), first.at(ratio(first_string(), instrument.number_of_frets)) };
+    JacobianPoint last_ends[2] = { last.at(ratio(last_string(), 0)), last.at(ratio(last_string(), instrument.number_of_frets)) };
+    BasicVector<D> first_border, last_border;
+    layout_borders(instrument, first_ends, last_ends, first_border, last_border);
+
+    jacobian._string_points.resize(jacobian._string_count * jacobian._fret_count * FretboardJacobian::parameter_count * 2);
+    jacobian._fret_lines.resize(jacobian._fret_count * FretboardJacobian::parameter_count * 4);
+
+    // Strings sharing a ratio table have the same fret positions, the ones of the outer strings are the fretboard's
+    std::vector<double>& positions = jacobian._positions;
+    const FretRatioTable* positions_table = nullptr;
+    bool has_positions = false;
+    double* d = jacobian._string_points.data();
+    for (size_t s = 0; s < _strings.size(); s++) {
+        const FretRatioTable* table = _strings[s].ratios();
+        const double* t = _fret_positions.data();
+        if (table == last_string().ratios() && table != first_string().ratios()) {
+            t += jacobian._fret_count;
+        } else if (table != first_string().ratios()) {
+            if (!has_positions || table != positions_table) {
+                positions_table = table;
+                has_positions = true;
+                positions.resize(jacobian._fret_count);
+                for (size_t i = 0; i < jacobian._fret_count; i++) {
+                    positions[i] = ratio(_strings[s], first_fret + int(i));
+                }
+            }
+            t = positions.data();
+        }
+        // Every point is start + direction * t, in the order of the output. Copied so that nothing aliases the output.
+        double start[size], direction[size];
+        const double* ends = &jacobian._ends[s * size * 2];
+        for (int j = 0; j < size; j++) {
+            start[j] = ends[j] - (j % 2 ? 0 : x_offset.derivatives[j / 2]);
+            direction[j] = ends[size + j];
+        }
+        for (size_t i = 0; i < jacobian._fret_count; i++) {
+            double position = t[i];
+            for (int j = 0; j < size; j++) {
+                d[j] = start[j] + direction[j] * position;
+            }
+            d += size;
+        }
+    }
+
+    // Fret lines are clipped by the borders, like in the fret kernel. Written out parameter after parameter: the
+    // derivatives of a clip share a single division.
+    BorderClip clips[2] = { BorderClip(first, last, first_border), BorderClip(first, last, last_border) };
+    d = jacobian._fret_lines.data();
+    for (size_t i = 0; i < jacobian._fret_count; i++) {
+        // Same positions as Fretboard::build_frets()
+        double t1 = _fret_positions[i];
+        double t2 = _fret_positions[jacobian._fret_count + i];
+        double start_x = first.start.x.value + first.direction.x.value * t1;
+        double start_y = first.start.y.value + first.direction.y.value * t1;
+        double fret_x = last.start.x.value + last.direction.x.value * t2 - start_x;
+        double fret_y = last.start.y.value + last.direction.y.value * t2 - start_y;
+        double s[2], inverse[2];
+        for (int k = 0; k < 2; k++) {
+            inverse[k] = 1 / (clips[k].c.value + clips[k].e.value * t2 - clips[k].b.value * t1);
+            s[k] = (clips[k].a.value - clips[k].b.value * t1) * inverse[k];
+        }
+        for (int parameter = 0; parameter < FretboardJacobian::parameter_count; parameter++) {
+            double dstart_x = first.start.x.derivatives[parameter] + first.direction.x.derivatives[parameter] * t1;
+            double dstart_y = first.start.y.derivatives[parameter] + first.direction.y.derivatives[parameter] * t1;
+            double dfret_x = last.start.x.derivatives[parameter] + last.direction.x.derivatives[parameter] * t2 - dstart_x;
+            double dfret_y = last.start.y.derivatives[parameter] + last.direction.y.derivatives[parameter] * t2 - dstart_y;
+            for (int k = 0; k < 2; k++) {
+                const BorderClip& clip = clips[k];
+                double db = clip.b.derivatives[parameter] * t1;
+                double ds = (clip.a.derivatives[parameter] - db - s[k] * (clip.c.derivatives[parameter] + clip.e.derivatives[parameter] * t2 - db)) * inverse[k];
+                *d++ = dstart_x + dfret_x * s[k] + fret_x * ds;
+                *d++ = dstart_y + dfret_y * s[k] + fret_y * ds;
+            }
+        }
+    }
+}
+
+}
@@ -0,0 +1,61 @@
+//
+//  FretboardJacobian.hpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+#ifndef fretboard_jacobian_hpp
+#define fretboard_jacobian_hpp
+
+#include <vector>
+#include "Geometry.hpp"
+
+namespace fretboarder {
+
+// Derivatives of the fret positions of a fretboard with respect to the parameters of its instrument that define the
+// layout, see Fretboard::jacobian(). They are exact (forward mode automatic differentiation, see Dual.hpp, with the
+// chain rule written out where it's cheaper) and all computed in a single pass. Frets are numbered like the rows of
+// the FretTable.
+class FretboardJacobian {
+public:
+    enum Parameter {
+        scale_length_treble,            // Instrument::scale_length[0]
+        scale_length_bass,              // Instrument::scale_length[1]
+        perpendicular_fret_index,
+        inter_string_spacing_at_nut,
+        inter_string_spacing_at_bridge,
+        parameter_count
+    };
+
+    size_t string_count() const { return _string_count; }
+    size_t fret_count() const { return _fret_count; }
+
+    // Derivative of the point where a string crosses a fret (String::point_at_fret).
+    Point string_point(size_t string, size_t fret, Parameter parameter) const {
+        const double* d = &_string_points[((string * _fret_count + fret) * parameter_count + parameter) * 2];
+        return Point(d[0], d[1]);
+    }
+
+    // Derivative of the ends of a fret line (Fretboard::fret_lines()).
+    Vector fret_line(size_t fret, Parameter parameter) const {
+        const double* d = &_fret_lines[(fret * parameter_count + parameter) * 4];
+        return Vector(Point(d[0], d[1]), Point(d[2], d[3]));
+    }
+
+private:
+    friend class Fretboard;
+
+    size_t _string_count = 0;
+    size_t _fret_count = 0;
+    std::vector<double> _string_points;
+    std::vector<double> _fret_lines;
+    // Derivatives of the ends of the strings and fret positions of a string along it, while computing
+    std::vector<double> _ends;
+    std::vector<double> _positions;
+};
+
+}
+
+#endif /* fretboard_jacobian_hpp */
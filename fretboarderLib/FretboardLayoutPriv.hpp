@@ -0,0 +1,148 @@
+//
+//  FretboardLayoutPriv.hpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+#ifndef fretboard_layout_priv_hpp
+#define fretboard_layout_priv_hpp
+
+#include "Fretboard.hpp"
+
+namespace fretboarder {
+
+// Layout of the strings and borders of a fretboard for any scalar type. Fretboard runs it with doubles,
+// FretboardJacobian runs layout_borders() with dual numbers, on the ends of the outer strings in closed form.
+
+// The parameters of the instrument the strings depend on, kept apart so that they can carry derivatives.
+template <class T>
+struct StringLayout {
+    T scale_length[2];
+    T perpendicular_fret_index;
+    T y_at_start;
+    T y_at_bridge;
+    T nut_to_zero_fret_offset;
+
+    static StringLayout from(const Instrument& instrument) {
+        return {
+            { instrument.scale_length[0], instrument.scale_length[1] },
+            instrument.perpendicular_fret_index,
+            instrument.y_at_start,
+            instrument.y_at_bridge,
+            instrument.nut_to_zero_fret_offset
+        };
+    }
+};
+
+template <class T, class Strings>
+void layout_strings(const Instrument& instrument, const StringLayout<T>& layout, Strings& strings) {
+    T first = layout.scale_length[instrument.right_handed? 1 : 0];
+    T last = layout.scale_length[instrument.right_handed? 0 : 1];
+
+    double max = instrument.number_of_strings - 1;
+    T diff = (last - first);
+    T ydiff_start = -layout.y_at_start * 2;
+    T ydiff_bridge = -layout.y_at_bridge * 2;
+
+    strings.clear();
+    strings.reserve(instrument.number_of_strings);
+    for (int i = 0; i < instrument.number_of_strings; i++) {
+        double ratio;
+        
+        if (max == 0) {
+            ratio = 0.5;
+        } else {
+            ratio = (double)i / max;
+        }
+        T length = first + ratio * diff;
+        T ystart = layout.y_at_start + ratio * ydiff_start;
+        T ybridge = layout.y_at_bridge + ratio * ydiff_bridge;
+        strings.push_back(BasicString<T>(i,
+                                         length,
+                                         layout.perpendicular_fret_index,
+                                         ystart,
+                                         ybridge,
+                                         instrument.has_zero_fret,
+                                         layout.nut_to_zero_fret_offset,
+                                         instrument.number_of_frets_per_octave,
+                                         instrument.temperament ? instrument.temperament->table(i) : nullptr));
+    }
+
+    // Compute global X offset (average of the X offsets of each string)
+    T offsetSum = T(0);
+    for (int i = 0; i < instrument.number_of_strings; i++) {
+        offsetSum += strings[i].x_at_start();
+    }
+    T offset = offsetSum / (double)instrument.number_of_strings;
+    for (int i = 0; i < instrument.number_of_strings; i++) {
+        strings[i].set_x_offset(-offset);
+    }
+}
+
+// With a single string, the outer strings are fake ones along the sides of the fretboard, fretted like the string.
+template <class T, class Strings>
+void layout_fake_strings(const Instrument& instrument, const StringLayout<T>& layout, const BasicString<T>& string, Strings& fake_strings) {
+    fake_strings.clear();
+    if (instrument.number_of_strings != 1) {
+        return;
+    }
+
+    // Create false first and last string
+    fake_strings.reserve(2);
+    fake_strings.push_back(BasicString<T>(0,
+                                          string.scale_length(),
+                                          layout.perpendicular_fret_index,
+                                          instrument.overhangs[0],
+                                          instrument.overhangs[1],
+                                          instrument.has_zero_fret,
+                                          layout.nut_to_zero_fret_offset,
+                                          instrument.number_of_frets_per_octave,
+                                          string.is_tempered() ? string.ratios() : nullptr));
+
+    fake_strings.push_back(BasicString<T>(0,
+                                          string.scale_length(),
+                                          layout.perpendicular_fret_index,
+                                          -instrument.overhangs[2],
+                                          -instrument.overhangs[3],
+                                          instrument.has_zero_fret,
+                                          layout.nut_to_zero_fret_offset,
+                                          instrument.number_of_frets_per_octave,
+                                          string.is_tempered() ? string.ratios() : nullptr));
+}
+
+// The borders go through the ends of the first and last frets on the outer strings, pushed out by the overhangs
+// along the frets (same as String::line().offset2D() with the first and last frets, without the 3D intersections).
+// The ends are the points of the outer strings at fret 0 and at the last fret.
+template <class T>
+void layout_borders(const Instrument& instrument, const BasicPoint<T> (&first_ends)[2], const BasicPoint<T> (&last_ends)[2],
+                    BasicVector<T>& first_border, BasicVector<T>& last_border) {
+    typedef BasicPoint<T> Point;
+    using std::sqrt;
+
+    // Unit vectors along the frets, from the last string to the first one
+    Point outwards[2];
+    for (int i = 0; i < 2; i++) {
+        Point d = first_ends[i] - last_ends[i];
+        T n = sqrt(d.x * d.x + d.y * d.y);
+        outwards[i] = n == 0 ? Point() : Point(d.x / n, d.y / n);
+    }
+
+    first_border = BasicVector<T>(first_ends[0] + outwards[0] * T(instrument.overhangs[0]),
+                                  first_ends[1] + outwards[1] * T(instrument.overhangs[1]));
+    last_border = BasicVector<T>(last_ends[0] - outwards[0] * T(instrument.overhangs[2]),
+                                 last_ends[1] - outwards[1] * T(instrument.overhangs[3]));
+}
+
+template <class T>
+void layout_borders(const Instrument& instrument, const BasicString<T>& first_string, const BasicString<T>& last_string,
+                    BasicVector<T>& first_border, BasicVector<T>& last_border) {
+    BasicPoint<T> first_ends[2] = { first_string.point_at_fret(0), first_string.point_at_fret(instrument.number_of_frets) };
+    BasicPoint<T> last_ends[2] = { last_string.point_at_fret(0), last_string.point_at_fret(instrument.number_of_frets) };
+    layout_borders(instrument, first_ends, last_ends, first_border, last_border);
+}
+
+}
+
+#endif /* fretboard_layout_priv_hpp */
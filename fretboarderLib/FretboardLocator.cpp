@@ -0,0 +1,145 @@
+//
+//  FretboardLocator.cpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+#include <algorithm>
+#include "FretboardLocator.hpp"
+
+namespace fretboarder {
+
+FretboardLocator::FretboardLocator(const Fretboard& fretboard) {
+    const auto& strings = fretboard.strings();
+    if (strings.empty()) {
+        // Not buildable, nothing is inside
+        return;
+    }
+    const String& first = strings.front();
+    const String& last = strings.back();
+
+    // Everything is oriented from the nut to the bridge and from the first string to the last one
+    Point along = first.point_at_bridge() - first.point_at_nut();
+    Point across = Point(-along.y, along.x);
+    if (strings.size() > 1) {
+        Point nuts = last.point_at_nut() - first.point_at_nut();
+        if (dot(across, nuts) < 0) {
+            across = across * -1;
+        }
+    }
+
+    auto side_line = [](const Point& p1, const Point& p2, const Point& positive) {
+        double a = -(p2.y - p1.y);
+        double b = p2.x - p1.x;
+        double n = sqrt(a * a + b * b);
+        if (n == 0) {
+            return SideLine { 0, 0, 0 };
+        }
+        if (a * positive.x + b * positive.y < 0) {
+            a = -a;
+            b = -b;
+        }
+        a /= n;
+        b /= n;
+        return SideLine { a, b, -(a * p1.x + b * p1.y) };
+    };
+
+    for (const Vector& line : fretboard.fret_lines()) {
+        _frets.push_back(side_line(line.point1, line.point2, along));
+    }
+    for (const String& string : strings) {
+        _strings.push_back(side_line(string.point_at_nut(), string.point_at_bridge(), across));
+    }
+    if (fretboard.has_curved_frets() && strings.size() > 1) {
+        // The points of the polylines on the strings are 1 to strings.size(), between the ends on the borders
+        const FretPolylines& polylines = fretboard.fret_polylines();
+        for (size_t gap = 0; gap + 1 < strings.size(); gap++) {
+            for (size_t i = 0; i < polylines.size(); i++) {
+                auto line = polylines[i];
+                _gap_frets.push_back(side_line(line[gap + 1], line[gap + 2], along));
+            }
+        }
+    }
+
+    int first_fret = fretboard.instrument().has_zero_fret ? 0 : 1;
+    for (const String& string : strings) {
+        for (size_t i = 0; i < _frets.size(); i++) {
+            _corners.push_back(string.point_at_fret(first_fret + int(i)));
+        }
+    }
+}
+
+// Inverse of p = a + u (b - a) + v (d - a) + u v (a - b + c - d), a b c d being the corners of the cell in order.
+static void inverse_bilinear(const Point& a, const Point& b, const Point& c, const Point& d, const Point& p, double& u, double& v) {
+    auto cross = [](const Point& l, const Point& r) { return l.x * r.y - l.y * r.x; };
+    Point e = b - a;
+    Point f = d - a;
+    Point g = a - b + c - d;
+    Point h = p - a;
+
+    // k2 v^2 + k1 v + k0 = 0
+    double k2 = cross(g, f);
+    double k1 = cross(e, f) + cross(h, g);
+    double k0 = cross(h, e);
+    if (fabs(k2) <= 1e-12 * fabs(k1)) {
+        // Opposite sides parallel, linear
+        v = -k0 / k1;
+    } else {
+        double w = sqrt(std::max(0.0, k1 * k1 - 4 * k0 * k2));
+        double v1 = (-k1 - w) / (2 * k2);
+        double v2 = (-k1 + w) / (2 * k2);
+        // The root in the cell, or the closest to it
+        v = fabs(v1 - 0.5) <= fabs(v2 - 0.5) ? v1 : v2;
+    }
+
+    Point side = e + g * v;
+    u = fabs(side.x) >= fabs(side.y) ? (h.x - f.x * v) / side.x : (h.y - f.y * v) / side.y;
+}
+
+int FretboardLocator::count_before(Span<const SideLine> lines, const Point& p) {
+    // lines[0, low) have the point on their positive side, lines[high, size) don't
+    int low = 0;
+    int high = int(lines.size());
+    while (low < high) {
+        int middle = (low + high) / 2;
+        if (lines[middle].distance(p) >= 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+FretboardLocation FretboardLocator::locate(const Point& point) const {
+    FretboardLocation location;
+    int strings = count_before(_strings, point);
+    Span<const SideLine> fret_lines = _frets;
+    if (!_gap_frets.empty()) {
+        // Beyond the outer strings, the segments of the closest gap carry on
+        int gap = std::min(std::max(strings - 1, 0), int(_strings.size()) - 2);
+        fret_lines = Span<const SideLine>(_gap_frets.data() + gap * _frets.size(), _frets.size());
+    }
+    int frets = count_before(fret_lines, point);
+    location.fret = frets - 1;
+    location.string_gap = strings - 1;
+    location.inside = frets > 0 && frets < int(_frets.size()) && strings > 0 && strings < int(_strings.size());
+
+    if (location.inside) {
+        const Point* first = &_corners[(strings - 1) * _frets.size() + frets - 1];
+        const Point* second = first + _frets.size();
+        inverse_bilinear(first[0], first[1], second[1], second[0], point, location.u, location.v);
+    }
+    return location;
+}
+
+void FretboardLocator::locate(Span<const Point> points, Span<FretboardLocation> locations) const {
+    assert(locations.size() >= points.size());
+    for (size_t i = 0; i < points.size(); i++) {
+        locations[i] = locate(points[i]);
+    }
+}
+
+}
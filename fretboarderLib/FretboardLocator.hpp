@@ -0,0 +1,71 @@
+//
+//  FretboardLocator.hpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+#ifndef fretboard_locator_hpp
+#define fretboard_locator_hpp
+
+#include <vector>
+#include "Fretboard.hpp"
+
+namespace fretboarder {
+
+// Where a point of the fretboard is: in which fret cell and string gap, and where in that cell.
+struct FretboardLocation {
+    // Between the fret lines fret and fret + 1 (rows of the FretTable), -1 before the first one and
+    // fret_count - 1 past the last one.
+    int fret = -1;
+    // Between the strings string_gap and string_gap + 1, -1 beyond the first string and string_count - 1
+    // beyond the last one.
+    int string_gap = -1;
+    // Bilinear coordinates in the cell, whose corners are the points of the strings at the frets: u from 0 on fret
+    // to 1 on the next one and v from 0 on string_gap to 1 on the next string. Only set when inside.
+    double u = 0;
+    double v = 0;
+    // True if the point is in a cell, between two frets and two strings.
+    bool inside = false;
+};
+
+// Answers "which fret cell and string gap contains this point?" in O(log(frets) + log(strings)): the fret lines
+// and the strings don't cross on the fretboard, the side of the point relative to them is monotonic and found by
+// bisection. Curved frets (see Fretboard::has_curved_frets()) are straight between two strings: the string gap is
+// found first, then the fret among the segments of the fret polylines in that gap. The locator copies what it needs
+// and doesn't reference the fretboard it was built from.
+class FretboardLocator {
+public:
+    explicit FretboardLocator(const Fretboard& fretboard);
+
+    size_t fret_count() const { return _frets.size(); }
+    size_t string_count() const { return _strings.size(); }
+
+    FretboardLocation locate(const Point& point) const;
+
+    // Locates every point, locations must be at least as large as points.
+    void locate(Span<const Point> points, Span<FretboardLocation> locations) const;
+
+private:
+    // Line as a*x + b*y + c = 0 with (a, b) unit length: a*x + b*y + c is the signed distance to the line.
+    struct SideLine {
+        double a, b, c;
+        double distance(const Point& p) const { return a * p.x + b * p.y + c; }
+    };
+
+    // Number of lines the point is on the positive side of.
+    static int count_before(Span<const SideLine> lines, const Point& p);
+
+    // Fret lines, positive towards the bridge, and strings, positive towards the last string.
+    std::vector<SideLine> _frets;
+    std::vector<SideLine> _strings;
+    // Curved frets only: the frets between each pair of strings, fret_count() per string gap.
+    std::vector<SideLine> _gap_frets;
+    // Points of the strings at the frets, string after string.
+    std::vector<Point> _corners;
+};
+
+}
+
+#endif /* fretboard_locator_hpp */
@@ -10,112 +10,171 @@
 
 using namespace fretboarder;
 
-static inline double dot(const Point& u, const Point& v)
-{
-    return u.x * v.x + u.y * v.y + u.z * v.z;
+namespace fretboarder {
+
+template class BasicVector<float>;
+template class BasicVector<double>;
+template class BasicVector<long double>;
+
 }
 
-static inline double norm2( const Point& v )
-{
-    return v.x * v.x + v.y * v.y + v.z * v.z;
+namespace {
+
+// Exact floating point arithmetic after Shewchuk, "Adaptive Precision Floating-Point Arithmetic and Fast Robust
+// Geometric Predicates": values are represented exactly as the sum of non overlapping doubles (expansions).
+
+// a + b = x + y exactly
+inline void two_sum(double a, double b, double& x, double& y) {
+    x = a + b;
+    double bv = x - a;
+    double av = x - bv;
+    y = (a - av) + (b - bv);
 }
 
-static inline double norm( const Point& v )
-{
-    return sqrt(norm2(v));
+// a - b = x + y exactly
+inline void two_diff(double a, double b, double& x, double& y) {
+    two_sum(a, -b, x, y);
 }
 
-static inline Point cross( const Point& b, const Point& c) // cross product
-{
-    return Point(b.y * c.z - c.y * b.z,
-                 b.z * c.x - c.z * b.x,
-                 b.x *  c.y - c.x * b.y);
+// Splits a into two halves of 26 bits, hi + lo = a
+inline void split(double a, double& hi, double& lo) {
+    double c = 134217729.0 * a; // 2^27 + 1
+    double big = c - a;
+    hi = c - big;
+    lo = a - hi;
 }
 
-Point Point::operator*(const Point& p) const {
-    return cross(*this, p);
+// a * b = x + y exactly
+inline void two_product(double a, double b, double& x, double& y) {
+    x = a * b;
+    double ahi, alo, bhi, blo;
+    split(a, ahi, alo);
+    split(b, bhi, blo);
+    y = alo * blo - (((x - ahi * bhi) - alo * bhi) - ahi * blo);
 }
 
+class Expansion {
+public:
+    // Adds b, keeping the components sorted by increasing magnitude and non overlapping (zeros are dropped).
+    void add(double b) {
+        int size = 0;
+        double q = b;
+        for (int i = 0; i < _size; i++) {
+            double h;
+            two_sum(q, _terms[i], q, h);
+            if (h != 0) {
+                _terms[size++] = h;
+            }
+        }
+        if (q != 0) {
+            _terms[size++] = q;
+        }
+        _size = size;
+        assert(_size < capacity);
+    }
 
-static double _intersection(const Vector& a, const Vector& b, Point& ip)
-// http://mathworld.wolfram.com/Line-LineIntersection.html
-// in 3d; will also work in 2d if z components are 0
-{
-    Point da = a.point2 - a.point1;
-    Point db = b.point2 - b.point1;
-    Point dc = b.point1 - a.point1;
-    
-    if (dot(dc, cross(da,db)) != 0.0) // lines are not coplanar
-        return false;
-    
-    double s = dot(cross(dc,db),cross(da,db)) / norm2(cross(da,db));
-    ip = a.point1 + da * s;
-    
-    return true;
-}
+    void add_product(double a, double b) {
+        double x, y;
+        two_product(a, b, x, y);
+        add(y);
+        add(x);
+    }
 
-bool Vector::intersection(const Vector& other, Point& result) const {
-    return _intersection(*this, other, result);
-}
+    // The largest component has the sign of the whole sum
+    int sign() const { return _size == 0 ? 0 : (_terms[_size - 1] > 0 ? 1 : -1); }
 
-Point Vector::intersection(const Vector& other) const {
-    Point result;
-    bool res = _intersection(*this, other, result);
-    assert(res);
-    return result;
-}
+    double estimate() const {
+        double sum = 0;
+        for (int i = 0; i < _size; i++) {
+            sum += _terms[i];
+        }
+        return sum;
+    }
 
-Vector Vector::offset2D(double offset) const {
-    //        Returns a new line parallel to the current one.
-    //        The orthogonal distance between the lines will be abs(offset).
-    //        If offset > 0, the new line will be above, otherwise it will be below.
-
-    //        The lines have the same slope, and we need to add offset * sqrt(1 + pow(slope, 2)) to the y_intersect.
-    double x = point2.x - point1.x;
-    double y = point2.y - point1.y;
-    double X = y;
-    double Y = -x;
-    Point perp = Point(X, Y, 0);
-    double n = norm(perp);
-
-    if (n == 0) {
-        return Vector(*this);
+private:
+    enum { capacity = 32 };
+    double _terms[capacity];
+    int _size = 0;
+};
+
+// (ax + ax') * (by + by') - (ay + ay') * (bx + bx'), all the differences being exact
+Expansion exact_cross(const double a[4], const double b[4]) {
+    Expansion e;
+    for (int i = 0; i < 2; i++) {
+        for (int j = 0; j < 2; j++) {
+            e.add_product(a[i], b[2 + j]);
+            e.add_product(-a[2 + i], b[j]);
+        }
     }
-    
-    double off = offset / n;
-    perp.x *= off;
-    perp.y *= off;
-    
-    return Vector(point1 + perp, point2 + perp);
+    return e;
 }
 
-Vector Vector::offset2D(double offset0, const Vector& vector0, double offset1, const Vector& vector1) const {
-    Point p0 = intersection(vector0);
-    Point p1 = intersection(vector1);
-    
-    auto e0 = vector0.sizedVector(offset0);
-    auto e1 = vector1.sizedVector(offset1);
-
-    return Vector(p0 + e0.point2, p1 + e1.point2);
 }
 
-Vector Vector::unitVector() const
+IntersectionResult fretboarder::exact_intersection(const BasicPoint<double>& p1, const BasicPoint<double>& p2,
+                                                   const BasicPoint<double>& q1, const BasicPoint<double>& q2, BasicPoint<double>& result)
 {
-    return sizedVector(1.0);
+    // x, x' then y, y' of each difference
+    double da[4], db[4], dc[4];
+    two_diff(p2.x, p1.x, da[0], da[1]);
+    two_diff(p2.y, p1.y, da[2], da[3]);
+    two_diff(q2.x, q1.x, db[0], db[1]);
+    two_diff(q2.y, q1.y, db[2], db[3]);
+    two_diff(q1.x, p1.x, dc[0], dc[1]);
+    two_diff(q1.y, p1.y, dc[2], dc[3]);
+
+    Expansion det = exact_cross(da, db);
+    if (det.sign() == 0) {
+        return IntersectionResult::parallel;
+    }
+
+    // result = p1 + da * s with s = (dc x db) / (da x db), the only roundings are the ones of s and of the result
+    double s = exact_cross(dc, db).estimate() / det.estimate();
+    result = BasicPoint<double>(p1.x + (da[0] + da[1]) * s, p1.y + (da[2] + da[3]) * s);
+    return IntersectionResult::found;
 }
 
-Vector Vector::sizedVector(double size) const
+IntersectionResult fretboarder::exact_intersection(const BasicLine2D<double>& a, const BasicLine2D<double>& b, BasicPoint<double>& result)
 {
-    auto d = point1.distanceFrom(point2);
-    if (d == 0) {
-        return Vector(point1, point1);
+    double da[4] = { a.dx, 0, a.dy, 0 };
+    double db[4] = { b.dx, 0, b.dy, 0 };
+    double dc[4];
+    two_diff(b.x, a.x, dc[0], dc[1]);
+    two_diff(b.y, a.y, dc[2], dc[3]);
+
+    Expansion det = exact_cross(da, db);
+    if (det.sign() == 0) {
+        return IntersectionResult::parallel;
     }
 
-    auto n = size / d;
+    double s = exact_cross(dc, db).estimate() / det.estimate();
+    result = BasicPoint<double>(a.x + a.dx * s, a.y + a.dy * s);
+    return IntersectionResult::found;
+}
 
-    auto x = n * (point1.x - point2.x);
-    auto y = n * (point1.y - point2.y);
-    auto z = n * (point1.z - point2.z);
-    
-    return Vector(Point(), Point(x, y, z));
+bool fretboarder::intersect(Span<const Line2D> lines, const Line2D& border, Span<double> xs, Span<double> ys)
+{
+    assert(xs.size() >= lines.size() && ys.size() >= lines.size());
+
+    bool result = true;
+    for (size_t i = 0; i < lines.size(); i++) {
+        const Line2D& line = lines[i];
+        double a = line.dx * border.dy;
+        double b = line.dy * border.dx;
+        double det = a - b;
+        if (!(fabs(det) > intersection_filter_bound * (fabs(a) + fabs(b)))) {
+            Point p;
+            if (exact_intersection(line, border, p) == IntersectionResult::found) {
+                xs[i] = p.x;
+                ys[i] = p.y;
+            } else {
+                result = false;
+            }
+            continue;
+        }
+        double s = ((border.x - line.x) * border.dy - (border.y - line.y) * border.dx) / det;
+        xs[i] = line.x + line.dx * s;
+        ys[i] = line.y + line.dy * s;
+    }
+    return result;
 }
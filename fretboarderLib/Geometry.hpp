@@ -10,83 +10,341 @@
 #define Geometry_hpp
 
 #include <math.h>
+#include <cmath>
+#include <stddef.h>
 #include <cassert>
 #include <algorithm>
+#include <type_traits>
 
 namespace fretboarder {
 
-class Vector;
+// Geometry is templated on the scalar type: double everywhere by default (Point, Vector...), float for fast
+// previews, long double for audits and Dual (see Dual.hpp) to get derivatives along with the values.
 
-class Point {
+// What the templates need to know about a scalar type besides its arithmetic, specialized by Dual.
+template <class T>
+struct ScalarTraits {
+    // Plain value, without derivatives
+    static constexpr double value(const T& v) { return double(v); }
+    // True if the scalar has no derivative at all, and can be used as a constant (table lookups...)
+    static constexpr bool is_constant(const T&) { return true; }
+};
+
+template <class T>
+class BasicVector;
+
+template <class T>
+class BasicPoint {
 public:
-    double x;
-    double y;
-    double z;
-
-    Point(double x = 0, double y = 0, double z = 0) {
-        this->x = x;
-        this->y = y;
-        this->z = z;
-    }
-    
-    Point(const Point& p) {
-        x = p.x;
-        y = p.y;
-        z = p.z;
-    }
+    T x;
+    T y;
+    T z;
+
+    constexpr BasicPoint(T x = T(0), T y = T(0), T z = T(0)) : x(x), y(y), z(z) {}
     
-    double distanceFrom(const Point& p) const {
-        double X = x - p.x;
-        double Y = y - p.y;
-        double Z = z - p.z;
+    T distanceFrom(const BasicPoint& p) const {
+        using std::sqrt;
+        T X = x - p.x;
+        T Y = y - p.y;
+        T Z = z - p.z;
         return sqrt(X * X + Y * Y + Z * Z);
     }
     
-    Point operator+(const Point& p) const {
-        return Point(x + p.x, y + p.y, z + p.z);
+    constexpr BasicPoint operator+(const BasicPoint& p) const {
+        return BasicPoint(x + p.x, y + p.y, z + p.z);
     }
 
-    Point operator-(const Point& p) const {
-        return Point(x - p.x, y - p.y, z - p.z);
+    constexpr BasicPoint operator-(const BasicPoint& p) const {
+        return BasicPoint(x - p.x, y - p.y, z - p.z);
     }
 
-    Point operator*(const Point& p) const;
+    // Cross product
+    constexpr BasicPoint operator*(const BasicPoint& p) const {
+        return BasicPoint(y * p.z - p.y * z,
+                          z * p.x - p.z * x,
+                          x * p.y - p.x * y);
+    }
 
-    Point operator*(double v) const {
-        return Point(x * v, y * v, z * v);
+    constexpr BasicPoint operator*(T v) const {
+        return BasicPoint(x * v, y * v, z * v);
     }
     
 
-    bool operator==(const Point& p) const {
+    constexpr bool operator==(const BasicPoint& p) const {
         return x == p.x && y == p.y && z == p.z;
     }
 };
 
-class Vector {
+template <class T>
+constexpr T dot(const BasicPoint<T>& u, const BasicPoint<T>& v) {
+    return u.x * v.x + u.y * v.y + u.z * v.z;
+}
+
+template <class T>
+constexpr T norm2(const BasicPoint<T>& v) {
+    return v.x * v.x + v.y * v.y + v.z * v.z;
+}
+
+template <class T>
+T norm(const BasicPoint<T>& v) {
+    using std::sqrt;
+    return sqrt(norm2(v));
+}
+
+// Outcome of the intersection of two lines.
+enum class IntersectionResult {
+    found,
+    parallel, // or degenerated, there is no single intersection
+    not_coplanar
+};
+
+// Intersection of the lines (p1, p2) and (q1, q2) of the XY plane with exact arithmetic: the determinants are exact,
+// only the final division and the point are rounded. Much slower than the double version, see BasicVector::intersect() for when it's needed.
+IntersectionResult exact_intersection(const BasicPoint<double>& p1, const BasicPoint<double>& p2,
+                                      const BasicPoint<double>& q1, const BasicPoint<double>& q2, BasicPoint<double>& result);
+
+// Bound of the rounding error of a 2D determinant ax * by - ay * bx of differences computed in double precision,
+// relative to |ax * by| + |ay * bx| (Shewchuk's orient2d bound), times 2^26 so that the determinants passing the
+// filter are known to at least half the bits of a double.
+constexpr double intersection_filter_bound = (3.0 + 16.0 * 0x1p-53) * 0x1p-53 * 0x1p26;
+
+template <class T>
+class BasicVector {
 public:
+    typedef BasicPoint<T> Point;
+
     Point point1;
     Point point2;
     
-    Vector(const Point& p1 = Point(), const Point& p2 = Point()) {
-        point1 = p1;
-        point2 = p2;
+    constexpr BasicVector(const Point& p1 = Point(), const Point& p2 = Point()) : point1(p1), point2(p2) {}
+    
+    // Returns found and the intersection in result, or why there isn't a single one. With doubles, lines of the XY
+    // plane go through a floating point filter: the common case costs the same as the plain formula, nearly
+    // parallel lines (where it would return garbage) are handled with exact_intersection().
+    IntersectionResult intersect(const BasicVector& other, Point& result) const;
+    bool intersection(const BasicVector& other, Point& result) const { return intersect(other, result) == IntersectionResult::found; }
+    // Asserts that there is an intersection, use intersect() when there might be none.
+    Point intersection(const BasicVector& other) const;
+
+    BasicVector offset2D(T offset) const;
+    BasicVector offset2D(T offset0, const BasicVector& vector0, T offset1, const BasicVector& vector1) const;
+    
+    BasicVector unitVector() const;
+    BasicVector sizedVector(T size) const;
+};
+
+// http://mathworld.wolfram.com/Line-LineIntersection.html
+// in 3d; will also work in 2d if z components are 0
+template <class T>
+IntersectionResult BasicVector<T>::intersect(const BasicVector& other, Point& result) const {
+    Point da = point2 - point1;
+    Point db = other.point2 - other.point1;
+    Point dc = other.point1 - point1;
+    Point n = da * db;
+    
+    if (dot(dc, n) != 0.0) // lines are not coplanar
+        return IntersectionResult::not_coplanar;
+
+    if constexpr (std::is_same<T, double>::value) {
+        // In the XY plane n.z is the determinant of the system, only trust it when its error bound is small enough
+        if (point1.z == 0 && point2.z == 0 && other.point1.z == 0 && other.point2.z == 0
+            && !(fabs(n.z) > intersection_filter_bound * (fabs(da.x * db.y) + fabs(da.y * db.x)))) {
+            return exact_intersection(point1, point2, other.point1, other.point2, result);
+        }
     }
+
+    T d = norm2(n);
+    if (d == 0)
+        return IntersectionResult::parallel;
+    
+    T s = dot(dc * db, n) / d;
+    result = point1 + da * s;
     
-    Vector(const Vector& v) {
-        point1 = v.point1;
-        point2 = v.point2;
+    return IntersectionResult::found;
+}
+
+template <class T>
+BasicPoint<T> BasicVector<T>::intersection(const BasicVector& other) const {
+    Point result;
+    bool res = intersection(other, result);
+    assert(res);
+    (void)res;
+    return result;
+}
+
+template <class T>
+BasicVector<T> BasicVector<T>::offset2D(T offset) const {
+    //        Returns a new line parallel to the current one.
+    //        The orthogonal distance between the lines will be abs(offset).
+    //        If offset > 0, the new line will be above, otherwise it will be below.
+
+    //        The lines have the same slope, and we need to add offset * sqrt(1 + pow(slope, 2)) to the y_intersect.
+    T x = point2.x - point1.x;
+    T y = point2.y - point1.y;
+    T X = y;
+    T Y = -x;
+    Point perp = Point(X, Y, T(0));
+    T n = norm(perp);
+
+    if (n == 0) {
+        return BasicVector(*this);
     }
     
-    bool intersection(const Vector& other, Point& result) const;
-    Point intersection(const Vector& other) const;
+    T off = offset / n;
+    perp.x *= off;
+    perp.y *= off;
+    
+    return BasicVector(point1 + perp, point2 + perp);
+}
 
-    Vector offset2D(double offset) const;
-    Vector offset2D(double offset0, const Vector& vector0, double offset1, const Vector& vector1) const;
+template <class T>
+BasicVector<T> BasicVector<T>::offset2D(T offset0, const BasicVector& vector0, T offset1, const BasicVector& vector1) const {
+    Point p0 = intersection(vector0);
+    Point p1 = intersection(vector1);
     
-    Vector unitVector() const;
-    Vector sizedVector(double size) const;
+    auto e0 = vector0.sizedVector(offset0);
+    auto e1 = vector1.sizedVector(offset1);
+
+    return BasicVector(p0 + e0.point2, p1 + e1.point2);
+}
+
+template <class T>
+BasicVector<T> BasicVector<T>::unitVector() const
+{
+    return sizedVector(T(1.0));
+}
+
+template <class T>
+BasicVector<T> BasicVector<T>::sizedVector(T size) const
+{
+    auto d = point1.distanceFrom(point2);
+    if (d == 0) {
+        return BasicVector(point1, point1);
+    }
+
+    auto n = size / d;
+
+    auto x = n * (point1.x - point2.x);
+    auto y = n * (point1.y - point2.y);
+    auto z = n * (point1.z - point2.z);
+    
+    return BasicVector(Point(), Point(x, y, z));
+}
+
+typedef BasicPoint<double> Point;
+typedef BasicVector<double> Vector;
+
+// Compiled once in Geometry.cpp
+extern template class BasicVector<float>;
+extern template class BasicVector<double>;
+extern template class BasicVector<long double>;
+
+// Non owning view over a contiguous array.
+template <class T>
+class Span {
+public:
+    constexpr Span() : _data(nullptr), _size(0) {}
+    constexpr Span(T* data, size_t size) : _data(data), _size(size) {}
+
+    template <class U, class = typename std::enable_if<std::is_convertible<U*, T*>::value>::type>
+    constexpr Span(const Span<U>& other) : _data(other.data()), _size(other.size()) {}
+
+    template <class Container, class = decltype(std::declval<Container&>().data())>
+    constexpr Span(Container& container) : _data(container.data()), _size(container.size()) {}
+
+    constexpr T* data() const { return _data; }
+    constexpr size_t size() const { return _size; }
+    constexpr bool empty() const { return _size == 0; }
+
+    constexpr T& operator[](size_t i) const { return _data[i]; }
+    constexpr T* begin() const { return _data; }
+    constexpr T* end() const { return _data + _size; }
+
+private:
+    T* _data;
+    size_t _size;
 };
 
+template <class T>
+struct BasicQuad {
+    BasicPoint<T> points[4];
+};
+
+typedef BasicQuad<double> Quad;
+
+template <class T>
+struct BasicLine2D;
+
+// Same as exact_intersection() above for lines given by a point and a direction, the directions being used as is.
+IntersectionResult exact_intersection(const BasicLine2D<double>& a, const BasicLine2D<double>& b, BasicPoint<double>& result);
+
+// Infinite line of the XY plane going through (x, y) with the direction (dx, dy).
+// Cheaper than Vector when we know we are working in 2D: intersections are solved with a single 2x2 determinant.
+template <class T>
+struct BasicLine2D {
+    typedef BasicPoint<T> Point;
+
+    T x;
+    T y;
+    T dx;
+    T dy;
+
+    constexpr BasicLine2D(T x = T(0), T y = T(0), T dx = T(0), T dy = T(0)) : x(x), y(y), dx(dx), dy(dy) {}
+    constexpr BasicLine2D(const Point& p1, const Point& p2) : x(p1.x), y(p1.y), dx(p2.x - p1.x), dy(p2.y - p1.y) {}
+    constexpr explicit BasicLine2D(const BasicVector<T>& v) : BasicLine2D(v.point1, v.point2) {}
+
+    // Returns false if the lines are parallel (or one of them is degenerated). With doubles, nearly parallel lines
+    // go through exact_intersection() like in BasicVector::intersect().
+    constexpr bool intersection(const BasicLine2D& other, Point& result) const {
+        T det = dx * other.dy - dy * other.dx;
+        if constexpr (std::is_same<T, double>::value) {
+            T a = dx * other.dy;
+            T b = dy * other.dx;
+            T bound = intersection_filter_bound * ((a < 0 ? -a : a) + (b < 0 ? -b : b));
+            if (!((det < 0 ? -det : det) > bound)) {
+                return exact_intersection(*this, other, result) == IntersectionResult::found;
+            }
+        }
+        if (det == 0) {
+            return false;
+        }
+        T s = ((other.x - x) * other.dy - (other.y - y) * other.dx) / det;
+        result = Point(x + dx * s, y + dy * s);
+        return true;
+    }
+
+    constexpr Point intersection(const BasicLine2D& other) const {
+        Point result;
+        bool res = intersection(other, result);
+        assert(res);
+        (void)res;
+        return result;
+    }
+
+    // Same as Vector::offset2D: the new line is parallel and abs(offset) away, above if offset > 0.
+    BasicLine2D offset(T offset) const {
+        using std::sqrt;
+        T n = sqrt(dx * dx + dy * dy);
+        if (n == 0) {
+            return *this;
+        }
+        T off = offset / n;
+        return BasicLine2D(x + dy * off, y - dx * off, dx, dy);
+    }
+};
+
+typedef BasicLine2D<double> Line2D;
+
+// Intersects every line of `lines` with `border` and writes the coordinates of the intersections in xs and ys.
+// Returns false if any of the lines is parallel to the border, its intersection is then left untouched. Nearly
+// parallel lines go through exact_intersection(), see BasicLine2D::intersection().
+bool intersect(Span<const Line2D> lines, const Line2D& border, Span<double> xs, Span<double> ys);
+
+// Points, vectors and quads are bulk copied (memcpy, SoA tables...), keep them trivially copyable.
+static_assert(std::is_trivially_copyable<Point>::value, "Point must be trivially copyable");
+static_assert(std::is_trivially_copyable<Vector>::value, "Vector must be trivially copyable");
+static_assert(std::is_trivially_copyable<Quad>::value, "Quad must be trivially copyable");
+
 
 }
 
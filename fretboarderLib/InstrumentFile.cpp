@@ -0,0 +1,256 @@
+//
+//  InstrumentFile.cpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+#include <algorithm>
+#include <cstring>
+#include "InstrumentFile.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Records are read and written as they are in memory
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "Binary .frt files are little endian"
+#endif
+
+namespace fretboarder {
+
+void to_record(const Instrument& i, InstrumentRecord& r) {
+    r = InstrumentRecord();
+    r.scale_length[0] = i.scale_length[0];
+    r.scale_length[1] = i.scale_length[1];
+    r.perpendicular_fret_index = i.perpendicular_fret_index;
+    r.inter_string_spacing_at_nut = i.inter_string_spacing_at_nut;
+    r.inter_string_spacing_at_bridge = i.inter_string_spacing_at_bridge;
+    r.nut_to_zero_fret_offset = i.nut_to_zero_fret_offset;
+    r.number_of_frets_per_octave = i.number_of_frets_per_octave;
+    for (int n = 0; n < 4; n++) {
+        r.overhangs[n] = i.overhangs[n];
+    }
+    r.hidden_tang_length = i.hidden_tang_length;
+    r.fret_slots_width = i.fret_slots_width;
+    r.fret_slots_height = i.fret_slots_height;
+    r.fret_crown_width = i.fret_crown_width;
+    r.fret_crown_height = i.fret_crown_height;
+    r.last_fret_cut_offset = i.last_fret_cut_offset;
+    r.space_before_nut = i.space_before_nut;
+    r.nut_thickness = i.nut_thickness;
+    r.nut_height_under = i.nut_height_under;
+    r.radius_at_nut = i.radius_at_nut;
+    r.radius_at_last_fret = i.radius_at_last_fret;
+    r.fretboard_thickness = i.fretboard_thickness;
+    r.number_of_strings = i.number_of_strings;
+    r.number_of_frets = i.number_of_frets;
+    r.overhang_type = i.overhang_type;
+    r.has_zero_fret = i.has_zero_fret;
+    r.draw_strings = i.draw_strings;
+    r.draw_frets = i.draw_frets;
+    r.carve_nut_slot = i.carve_nut_slot;
+}
+
+void from_record(const InstrumentRecord& r, Instrument& i) {
+    i.scale_length[0] = r.scale_length[0];
+    i.scale_length[1] = r.scale_length[1];
+    i.perpendicular_fret_index = r.perpendicular_fret_index;
+    i.inter_string_spacing_at_nut = r.inter_string_spacing_at_nut;
+    i.inter_string_spacing_at_bridge = r.inter_string_spacing_at_bridge;
+    i.nut_to_zero_fret_offset = r.nut_to_zero_fret_offset;
+    i.number_of_frets_per_octave = r.number_of_frets_per_octave;
+    for (int n = 0; n < 4; n++) {
+        i.overhangs[n] = r.overhangs[n];
+    }
+    i.hidden_tang_length = r.hidden_tang_length;
+    i.fret_slots_width = r.fret_slots_width;
+    i.fret_slots_height = r.fret_slots_height;
+    i.fret_crown_width = r.fret_crown_width;
+    i.fret_crown_height = r.fret_crown_height;
+    i.last_fret_cut_offset = r.last_fret_cut_offset;
+    i.space_before_nut = r.space_before_nut;
+    i.nut_thickness = r.nut_thickness;
+    i.nut_height_under = r.nut_height_under;
+    i.radius_at_nut = r.radius_at_nut;
+    i.radius_at_last_fret = r.radius_at_last_fret;
+    i.fretboard_thickness = r.fretboard_thickness;
+    i.number_of_strings = r.number_of_strings;
+    i.number_of_frets = r.number_of_frets;
+    i.overhang_type = OverhangType(r.overhang_type);
+    i.has_zero_fret = r.has_zero_fret != 0;
+    i.draw_strings = r.draw_strings != 0;
+    i.draw_frets = r.draw_frets != 0;
+    i.carve_nut_slot = r.carve_nut_slot != 0;
+
+    i.validate();
+}
+
+bool is_binary_instrument(const void* data, size_t size) {
+    return size >= sizeof(InstrumentFileHeader) && memcmp(data, instrument_file_magic, sizeof(instrument_file_magic)) == 0;
+}
+
+bool read_binary_instrument(const void* data, size_t size, Instrument& instrument) {
+    if (!is_binary_instrument(data, size)) {
+        return false;
+    }
+    InstrumentFileHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (header.version != instrument_file_version || header.record_size < sizeof(InstrumentRecord) ||
+        size - sizeof(header) < header.record_size) {
+        return false;
+    }
+
+    // The header keeps the record aligned, mapped files and allocations are at least 8 bytes aligned
+    const void* record = static_cast<const unsigned char*>(data) + sizeof(header);
+    if (reinterpret_cast<uintptr_t>(record) % alignof(InstrumentRecord) == 0) {
+        from_record(*static_cast<const InstrumentRecord*>(record), instrument);
+    } else {
+        InstrumentRecord copy;
+        memcpy(&copy, record, sizeof(copy));
+        from_record(copy, instrument);
+    }
+    return true;
+}
+
+bool write_binary_instrument(std::ostream& stream, const Instrument& instrument) {
+    InstrumentFileHeader header = {};
+    memcpy(header.magic, instrument_file_magic, sizeof(header.magic));
+    header.version = instrument_file_version;
+    header.record_size = sizeof(InstrumentRecord);
+
+    InstrumentRecord record;
+    to_record(instrument, record);
+
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    return bool(stream);
+}
+
+bool read_file(const std::string& filename, std::vector<unsigned char>& data) {
+    // .frt files fit in the first read
+    size_t size = 0;
+    data.resize(std::max(data.capacity(), size_t(16 * 1024)));
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    DWORD count = 0;
+    bool ok = true;
+    while ((ok = ReadFile(file, data.data() + size, DWORD(std::min(data.size() - size, size_t(1) << 30)), &count, nullptr) != FALSE) && count > 0) {
+        size += count;
+        if (size == data.size()) {
+            data.resize(data.size() * 2);
+        }
+    }
+    CloseHandle(file);
+#else
+    int file = ::open(filename.c_str(), O_RDONLY);
+    if (file < 0) {
+        return false;
+    }
+    ssize_t count = 0;
+    while ((count = ::read(file, data.data() + size, data.size() - size)) > 0) {
+        size += size_t(count);
+        if (size == data.size()) {
+            data.resize(data.size() * 2);
+        }
+    }
+    bool ok = count == 0;
+    ::close(file);
+#endif
+    data.resize(size);
+    return ok;
+}
+
+MappedFile::MappedFile(const std::string& filename) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return;
+    }
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(file, &size)) {
+        _open = true;
+        _size = size_t(size.QuadPart);
+        if (_size > 0) {
+            _mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            _data = _mapping ? static_cast<const unsigned char*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+            _open = _data != nullptr;
+        }
+    }
+    CloseHandle(file);
+#else
+    int file = ::open(filename.c_str(), O_RDONLY);
+    if (file < 0) {
+        return;
+    }
+    struct stat status;
+    if (fstat(file, &status) == 0) {
+        _open = true;
+        _size = size_t(status.st_size);
+        if (_size > 0) {
+            void* data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, file, 0);
+            _data = data != MAP_FAILED ? static_cast<const unsigned char*>(data) : nullptr;
+            _open = _data != nullptr;
+        }
+    }
+    // The mapping keeps the file alive
+    ::close(file);
+#endif
+    if (!_open) {
+        close();
+    }
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator =(MappedFile&& other) {
+    if (this != &other) {
+        close();
+        std::swap(_open, other._open);
+        std::swap(_data, other._data);
+        std::swap(_size, other._size);
+#ifdef _WIN32
+        std::swap(_mapping, other._mapping);
+#endif
+    }
+    return *this;
+}
+
+void MappedFile::close() {
+#ifdef _WIN32
+    if (_data) {
+        UnmapViewOfFile(_data);
+    }
+    if (_mapping) {
+        CloseHandle(_mapping);
+    }
+    _mapping = nullptr;
+#else
+    if (_data) {
+        munmap(const_cast<unsigned char*>(_data), _size);
+    }
+#endif
+    _open = false;
+    _data = nullptr;
+    _size = 0;
+}
+
+}
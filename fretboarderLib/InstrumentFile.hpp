@@ -0,0 +1,111 @@
+//
+//  InstrumentFile.hpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+#ifndef instrument_file_hpp
+#define instrument_file_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "Fretboard.hpp"
+
+namespace fretboarder {
+
+// Binary .frt, version 2: an InstrumentFileHeader followed by an InstrumentRecord, both little endian with a fixed
+// layout. The record is read in place, there is nothing to parse. It holds exactly what
+// the JSON form holds (see to_json()), going from one to the other is lossless.
+struct InstrumentFileHeader {
+    char magic[4];
+    uint32_t version;
+    // Size of the records that follow, later versions may append fields
+    uint32_t record_size;
+    uint32_t reserved;
+};
+
+constexpr char instrument_file_magic[4] = { 'F', 'R', 'T', 'B' };
+constexpr uint32_t instrument_file_version = 2;
+
+// The fields of Instrument saved in a file, doubles first so that there is no padding.
+struct InstrumentRecord {
+    double scale_length[2];
+    double perpendicular_fret_index;
+    double inter_string_spacing_at_nut;
+    double inter_string_spacing_at_bridge;
+    double nut_to_zero_fret_offset;
+    double number_of_frets_per_octave;
+    double overhangs[4];
+    double hidden_tang_length;
+    double fret_slots_width;
+    double fret_slots_height;
+    double fret_crown_width;
+    double fret_crown_height;
+    double last_fret_cut_offset;
+    double space_before_nut;
+    double nut_thickness;
+    double nut_height_under;
+    double radius_at_nut;
+    double radius_at_last_fret;
+    double fretboard_thickness;
+    int32_t number_of_strings;
+    int32_t number_of_frets;
+    int32_t overhang_type;
+    uint8_t has_zero_fret;
+    uint8_t draw_strings;
+    uint8_t draw_frets;
+    uint8_t carve_nut_slot;
+};
+
+static_assert(sizeof(InstrumentFileHeader) == 16, "The records must stay 8 bytes aligned in the file");
+static_assert(sizeof(InstrumentRecord) == 200, "The layout of InstrumentRecord is part of the file format");
+
+void to_record(const Instrument& instrument, InstrumentRecord& record);
+void from_record(const InstrumentRecord& record, Instrument& instrument);
+
+// True if data starts like a binary .frt, of any version.
+bool is_binary_instrument(const void* data, size_t size);
+
+// Reads the instrument of a binary .frt held in data, false if it isn't one or has an unknown version.
+bool read_binary_instrument(const void* data, size_t size, Instrument& instrument);
+bool write_binary_instrument(std::ostream& stream, const Instrument& instrument);
+
+// Reads the whole file into data, reusing its capacity, false if it couldn't be read. For small files, .frt ones: the
+// few syscalls are much cheaper than setting up and tearing down a mapping.
+bool read_file(const std::string& filename, std::vector<unsigned char>& data);
+
+// Read only view of a whole file mapped in memory, empty if the file couldn't be opened.
+class MappedFile {
+public:
+    MappedFile() {}
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other);
+    MappedFile& operator =(MappedFile&& other);
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator =(const MappedFile&) = delete;
+
+    bool is_open() const { return _open; }
+    const unsigned char* data() const { return _data; }
+    size_t size() const { return _size; }
+
+    void close();
+
+private:
+    bool _open = false;
+    const unsigned char* _data = nullptr;
+    size_t _size = 0;
+#ifdef _WIN32
+    void* _mapping = nullptr;
+#endif
+};
+
+}
+
+#endif /* instrument_file_hpp */
@@ -0,0 +1,514 @@
+//
+//  InstrumentJson.cpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+#include <clocale>
+#include <cstddef>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include "InstrumentJson.hpp"
+
+namespace fretboarder {
+
+namespace {
+
+// A JSON number the way nlohmann stores it: positive integers are unsigned, negative ones signed, and the others, or
+// those out of range, are doubles.
+struct Number {
+    enum Kind { unsigned_integer, signed_integer, real };
+    Kind kind = unsigned_integer;
+    uint64_t u = 0;
+    int64_t i = 0;
+    double d = 0;
+};
+
+// Same conversions as nlohmann's from_json() for arithmetic types, false where they would be undefined.
+template <typename T>
+bool convert(const Number& number, T& value) {
+    switch (number.kind) {
+        case Number::unsigned_integer: value = static_cast<T>(number.u); return true;
+        case Number::signed_integer: value = static_cast<T>(number.i); return true;
+        case Number::real:
+            if (!std::is_floating_point<T>::value &&
+                !(number.d > double(std::numeric_limits<T>::lowest()) - 1 && number.d < double(std::numeric_limits<T>::max()) + 1)) {
+                return false;
+            }
+            value = static_cast<T>(number.d);
+            return true;
+    }
+    return false;
+}
+
+// Deeper values are left to nlohmann
+constexpr int max_depth = 32;
+
+enum class Kind {
+    real,
+    integer, // numbers and booleans, like nlohmann does for int
+    overhang_type,
+    boolean,
+    reals // array of count reals, the elements past them are ignored
+};
+
+// What from_json() reads: the instrument, with the overhangs apart until we know whether the legacy "overhang" key
+// is there
+struct Parsed {
+    Instrument instrument;
+    double overhang = 3;
+    OverhangType overhang_type = single;
+    double overhangs[4] = {};
+};
+
+struct Field {
+    const char* name;
+    size_t size;
+    Kind kind;
+    size_t offset; // in Parsed
+    int count;
+};
+
+#define INSTRUMENT_FIELD(name, kind, count) { #name, sizeof(#name) - 1, Kind::kind, offsetof(Parsed, instrument) + offsetof(Instrument, name), count }
+#define PARSED_FIELD(name, kind, count) { #name, sizeof(#name) - 1, Kind::kind, offsetof(Parsed, name), count }
+
+// In the order nlohmann writes them, sorted by name
+const Field fields[] = {
+    INSTRUMENT_FIELD(carve_nut_slot, boolean, 1),
+    INSTRUMENT_FIELD(draw_frets, boolean, 1),
+    INSTRUMENT_FIELD(draw_strings, boolean, 1),
+    INSTRUMENT_FIELD(fret_crown_height, real, 1),
+    INSTRUMENT_FIELD(fret_crown_width, real, 1),
+    INSTRUMENT_FIELD(fret_slots_height, real, 1),
+    INSTRUMENT_FIELD(fret_slots_width, real, 1),
+    INSTRUMENT_FIELD(fretboard_thickness, real, 1),
+    INSTRUMENT_FIELD(has_zero_fret, boolean, 1),
+    INSTRUMENT_FIELD(hidden_tang_length, real, 1),
+    INSTRUMENT_FIELD(inter_string_spacing_at_bridge, real, 1),
+    INSTRUMENT_FIELD(inter_string_spacing_at_nut, real, 1),
+    INSTRUMENT_FIELD(last_fret_cut_offset, real, 1),
+    INSTRUMENT_FIELD(number_of_frets, integer, 1),
+    INSTRUMENT_FIELD(number_of_frets_per_octave, real, 1),
+    INSTRUMENT_FIELD(number_of_strings, integer, 1),
+    INSTRUMENT_FIELD(nut_height_under, real, 1),
+    INSTRUMENT_FIELD(nut_thickness, real, 1),
+    INSTRUMENT_FIELD(nut_to_zero_fret_offset, real, 1),
+    PARSED_FIELD(overhang, real, 1),
+    PARSED_FIELD(overhang_type, overhang_type, 1),
+    PARSED_FIELD(overhangs, reals, 4),
+    INSTRUMENT_FIELD(perpendicular_fret_index, real, 1),
+    INSTRUMENT_FIELD(radius_at_last_fret, real, 1),
+    INSTRUMENT_FIELD(radius_at_nut, real, 1),
+    INSTRUMENT_FIELD(scale_length, reals, 2),
+    INSTRUMENT_FIELD(space_before_nut, real, 1)
+};
+
+#undef INSTRUMENT_FIELD
+#undef PARSED_FIELD
+
+const int field_count = int(sizeof(fields) / sizeof(fields[0]));
+
+uint32_t field_bit(const char* name) {
+    for (int i = 0; i < field_count; i++) {
+        if (strcmp(fields[i].name, name) == 0) {
+            return uint32_t(1) << i;
+        }
+    }
+    return 0;
+}
+
+class Parser {
+public:
+    Parser(const char* begin, const char* end) : _p(begin), _end(end) {
+        // nlohmann converts with strtod() too, in the current locale
+        _decimal_point = *localeconv()->decimal_point;
+    }
+
+    void skip_whitespace() {
+        while (_p < _end && (*_p == ' ' || *_p == '\n' || *_p == '\r' || *_p == '\t')) {
+            _p++;
+        }
+    }
+
+    // Next character after whitespace, 0 at the end
+    char peek() {
+        skip_whitespace();
+        return _p < _end ? *_p : 0;
+    }
+
+    bool expect(char c) {
+        if (peek() != c) {
+            return false;
+        }
+        _p++;
+        return true;
+    }
+
+    bool at_end() {
+        skip_whitespace();
+        return _p == _end;
+    }
+
+    // Strings without escapes and with printable ASCII characters only
+    bool string(const char*& text, size_t& size) {
+        if (!expect('"')) {
+            return false;
+        }
+        text = _p;
+        while (_p < _end && *_p != '"') {
+            unsigned char c = *_p;
+            if (c < 0x20 || c >= 0x80 || c == '\\') {
+                return false;
+            }
+            _p++;
+        }
+        if (_p == _end) {
+            return false;
+        }
+        size = _p - text;
+        _p++;
+        return true;
+    }
+
+    bool literal(const char* text, size_t size) {
+        if (size_t(_end - _p) < size || memcmp(_p, text, size) != 0) {
+            return false;
+        }
+        _p += size;
+        return true;
+    }
+
+    bool boolean(bool& value) {
+        char c = peek();
+        if (c == 't' && literal("true", 4)) {
+            value = true;
+            return true;
+        }
+        if (c == 'f' && literal("false", 5)) {
+            value = false;
+            return true;
+        }
+        return false;
+    }
+
+    bool number(Number& number) {
+        skip_whitespace();
+        const char* begin = _p;
+        bool negative = _p < _end && *_p == '-';
+        if (negative) {
+            _p++;
+        }
+        // All the digits as an integer until it overflows, the decimal point being exponent digits from the right
+        uint64_t significand = 0;
+        bool overflow = false;
+        int exponent = 0;
+        if (_p < _end && *_p == '0') {
+            _p++;
+        } else if (_p < _end && *_p >= '1' && *_p <= '9') {
+            digits(significand, overflow);
+        } else {
+            return false;
+        }
+
+        bool integer = true;
+        if (_p < _end && *_p == '.') {
+            integer = false;
+            _p++;
+            const char* fraction = _p;
+            if (!digits(significand, overflow)) {
+                return false;
+            }
+            exponent = -int(_p - fraction);
+        }
+        if (_p < _end && (*_p == 'e' || *_p == 'E')) {
+            integer = false;
+            _p++;
+            bool negative_exponent = _p < _end && *_p == '-';
+            if (_p < _end && (*_p == '+' || *_p == '-')) {
+                _p++;
+            }
+            uint64_t value = 0;
+            bool exponent_overflow = false;
+            if (!digits(value, exponent_overflow)) {
+                return false;
+            }
+            // Only small exponents take the fast path below
+            int e = exponent_overflow || value > 1000 ? 1000 : int(value);
+            exponent += negative_exponent ? -e : e;
+        }
+
+        if (integer && !overflow) {
+            if (!negative) {
+                number.kind = Number::unsigned_integer;
+                number.u = significand;
+                return true;
+            }
+            if (significand <= uint64_t(std::numeric_limits<int64_t>::max()) + 1) {
+                number.kind = Number::signed_integer;
+                number.i = significand == 0 ? 0 : -int64_t(significand - 1) - 1;
+                return true;
+            }
+        }
+
+        number.kind = Number::real;
+        // Exact significand and power of ten: a single correctly rounded operation gives the same double as strtod()
+        static const double powers_of_ten[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+            1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+        if (!overflow && significand <= (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22) {
+            double d = double(significand);
+            d = exponent < 0 ? d / powers_of_ten[-exponent] : d * powers_of_ten[exponent];
+            number.d = negative ? -d : d;
+            return true;
+        }
+
+        // As nlohmann does, with the decimal point of the locale
+        char buffer[64];
+        size_t size = _p - begin;
+        if (size >= sizeof(buffer)) {
+            return false;
+        }
+        for (size_t i = 0; i < size; i++) {
+            buffer[i] = begin[i] == '.' ? _decimal_point : begin[i];
+        }
+        buffer[size] = 0;
+        number.d = strtod(buffer, nullptr);
+        // nlohmann rejects numbers that overflow
+        return std::isfinite(number.d);
+    }
+
+    // Any value, nesting up to depth
+    bool skip_value(int depth) {
+        const char* text;
+        size_t size;
+        Number n;
+        bool b;
+        switch (peek()) {
+            case '"': return string(text, size);
+            case 't':
+            case 'f': return boolean(b);
+            case 'n': return literal("null", 4);
+            case '[':
+                if (depth == 0) {
+                    return false;
+                }
+                _p++;
+                if (expect(']')) {
+                    return true;
+                }
+                do {
+                    if (!skip_value(depth - 1)) {
+                        return false;
+                    }
+                } while (expect(','));
+                return expect(']');
+            case '{':
+                if (depth == 0) {
+                    return false;
+                }
+                _p++;
+                if (expect('}')) {
+                    return true;
+                }
+                do {
+                    if (!string(text, size) || !expect(':') || !skip_value(depth - 1)) {
+                        return false;
+                    }
+                } while (expect(','));
+                return expect('}');
+            default: return number(n);
+        }
+    }
+
+    // Reads the value of field into parsed, valid is false if it isn't of the type of the field. False if the text
+    // isn't JSON.
+    bool value(const Field& field, Parsed& parsed, bool& valid) {
+        void* target = reinterpret_cast<char*>(&parsed) + field.offset;
+        Number number;
+        valid = false;
+        char c = peek();
+        switch (field.kind) {
+            case Kind::real:
+                if (c != '-' && (c < '0' || c > '9')) {
+                    return skip_value(max_depth);
+                }
+                if (!this->number(number)) {
+                    return false;
+                }
+                valid = convert(number, *static_cast<double*>(target));
+                return true;
+
+            case Kind::integer:
+            case Kind::overhang_type:
+                if (field.kind == Kind::integer && (c == 't' || c == 'f')) {
+                    bool b;
+                    if (!boolean(b)) {
+                        return false;
+                    }
+                    *static_cast<int*>(target) = int(b);
+                    valid = true;
+                    return true;
+                }
+                if (c != '-' && (c < '0' || c > '9')) {
+                    return skip_value(max_depth);
+                }
+                if (!this->number(number)) {
+                    return false;
+                }
+                if (field.kind == Kind::integer) {
+                    valid = convert(number, *static_cast<int*>(target));
+                } else {
+                    typename std::underlying_type<OverhangType>::type type = 0;
+                    valid = convert(number, type);
+                    if (valid) {
+                        *static_cast<OverhangType*>(target) = static_cast<OverhangType>(type);
+                    }
+                }
+                return true;
+
+            case Kind::boolean:
+                if (c != 't' && c != 'f') {
+                    return skip_value(max_depth);
+                }
+                valid = true;
+                return boolean(*static_cast<bool*>(target));
+
+            case Kind::reals: {
+                if (c != '[') {
+                    return skip_value(max_depth);
+                }
+                _p++;
+                if (expect(']')) {
+                    return true;
+                }
+                double* values = static_cast<double*>(target);
+                valid = true;
+                int i = 0;
+                do {
+                    c = peek();
+                    if (i < field.count && (c == '-' || (c >= '0' && c <= '9'))) {
+                        if (!this->number(number)) {
+                            return false;
+                        }
+                        valid = convert(number, values[i]) && valid;
+                    } else {
+                        valid = valid && i >= field.count;
+                        if (!skip_value(max_depth)) {
+                            return false;
+                        }
+                    }
+                    i++;
+                } while (expect(','));
+                valid = valid && i >= field.count;
+                return expect(']');
+            }
+        }
+        return false;
+    }
+
+private:
+    // Reads digits into value, false if there are none
+    bool digits(uint64_t& value, bool& overflow) {
+        const char* begin = _p;
+        while (_p < _end && *_p >= '0' && *_p <= '9') {
+            uint64_t digit = uint64_t(*_p - '0');
+            overflow = overflow || value > (std::numeric_limits<uint64_t>::max() - digit) / 10;
+            value = value * 10 + digit;
+            _p++;
+        }
+        return _p > begin;
+    }
+
+    const char* _p;
+    const char* _end;
+    char _decimal_point;
+};
+
+}
+
+bool parse_instrument_json(const char* begin, const char* end, Instrument& instrument) {
+    Parsed parsed;
+
+    const uint32_t all = (uint32_t(1) << field_count) - 1;
+    static const uint32_t frets_per_octave_bit = field_bit("number_of_frets_per_octave");
+    static const uint32_t overhangs_bits = field_bit("overhangs") | field_bit("overhang_type");
+    static const uint32_t overhang_bit = field_bit("overhang");
+
+    // Fields found, and those whose last value was of the right type: like in the DOM, the last one wins
+    uint32_t found = 0;
+    uint32_t valid = 0;
+
+    Parser parser(begin, end);
+    if (!parser.expect('{')) {
+        return false;
+    }
+    if (!parser.expect('}')) {
+        // Keys are usually in the order of fields, start looking after the last one found
+        int next = 0;
+        do {
+            const char* key;
+            size_t size;
+            if (!parser.string(key, size) || !parser.expect(':')) {
+                return false;
+            }
+            int index = -1;
+            for (int i = 0; i < field_count; i++) {
+                int candidate = (next + i) % field_count;
+                if (fields[candidate].size == size && memcmp(fields[candidate].name, key, size) == 0) {
+                    index = candidate;
+                    break;
+                }
+            }
+            if (index < 0) {
+                if (!parser.skip_value(max_depth)) {
+                    return false;
+                }
+                continue;
+            }
+
+            bool field_valid;
+            if (!parser.value(fields[index], parsed, field_valid)) {
+                return false;
+            }
+            uint32_t bit = uint32_t(1) << index;
+            found |= bit;
+            valid = field_valid ? valid | bit : valid & ~bit;
+            next = index + 1;
+        } while (parser.expect(','));
+        if (!parser.expect('}')) {
+            return false;
+        }
+    }
+    if (!parser.at_end()) {
+        return false;
+    }
+
+    // What from_json() needs is there and of the right type
+    uint32_t needed = all & ~frets_per_octave_bit & ~overhang_bit & ~overhangs_bits;
+    needed |= found & frets_per_octave_bit;
+    needed |= (found & overhang_bit) ? overhang_bit : overhangs_bits;
+    if ((valid & needed) != needed) {
+        return false;
+    }
+
+    if (found & overhang_bit) {
+        for (int n = 0; n < 4; n++) {
+            parsed.instrument.overhangs[n] = parsed.overhang;
+        }
+    } else {
+        parsed.instrument.overhang_type = parsed.overhang_type;
+        for (int n = 0; n < 4; n++) {
+            parsed.instrument.overhangs[n] = parsed.overhangs[n];
+        }
+    }
+    parsed.instrument.validate();
+
+    instrument = parsed.instrument;
+    return true;
+}
+
+}
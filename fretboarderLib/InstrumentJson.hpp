@@ -0,0 +1,29 @@
+//
+//  InstrumentJson.hpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+#ifndef instrument_json_hpp
+#define instrument_json_hpp
+
+#include <cstddef>
+#include "Fretboard.hpp"
+
+namespace fretboarder {
+
+// Parses the JSON form of an Instrument (see to_json()) straight into instrument, in one pass over the text with no
+// tree and no allocation. It reads the same keys with the same conversions as from_json(), legacy "overhang" and
+// optional "number_of_frets_per_octave" included, and gives the same instrument.
+//
+// Returns false and leaves instrument untouched when the text isn't a valid instrument, or uses what the parser
+// leaves to nlohmann: escapes or non ASCII characters in strings, deeply nested values, numbers that don't convert
+// exactly. Going through json::parse() and from_json() then gives the answer, an instrument or an exception, as
+// Instrument::load() does.
+bool parse_instrument_json(const char* begin, const char* end, Instrument& instrument);
+
+}
+
+#endif /* instrument_json_hpp */
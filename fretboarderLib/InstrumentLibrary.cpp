@@ -0,0 +1,189 @@
+//
+//  InstrumentLibrary.cpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+#include <cstring>
+#include <fstream>
+#include "InstrumentLibrary.hpp"
+
+namespace fretboarder {
+
+uint64_t instrument_library_hash(std::string_view name) {
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : name) {
+        hash ^= uint64_t(uint8_t(c));
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static size_t align8(size_t size) {
+    return (size + 7) & ~size_t(7);
+}
+
+bool InstrumentLibraryWriter::add(const std::string& name, const Instrument& instrument) {
+    if (!_indices.emplace(name, _names.size()).second) {
+        return false;
+    }
+    _names.push_back(name);
+    _records.emplace_back();
+    to_record(instrument, _records.back());
+    return true;
+}
+
+bool InstrumentLibraryWriter::save(const std::string& filename) const {
+    uint32_t count = uint32_t(_names.size());
+    uint32_t bucket_count = 1;
+    while (bucket_count < 2 * count) {
+        bucket_count *= 2;
+    }
+
+    std::vector<InstrumentLibraryEntry> entries(count);
+    std::vector<uint32_t> buckets(bucket_count, InstrumentLibrary::empty_bucket);
+    std::string names;
+    for (uint32_t i = 0; i < count; i++) {
+        InstrumentLibraryEntry& entry = entries[i];
+        entry.hash = instrument_library_hash(_names[i]);
+        entry.name_offset = uint32_t(names.size());
+        entry.name_size = uint32_t(_names[i].size());
+        names += _names[i];
+        names += '\0';
+
+        size_t bucket = entry.hash & (bucket_count - 1);
+        while (buckets[bucket] != InstrumentLibrary::empty_bucket) {
+            bucket = (bucket + 1) & (bucket_count - 1);
+        }
+        buckets[bucket] = i;
+    }
+    // Keeps the file size a multiple of 8 when appending sections in later versions
+    names.resize(align8(names.size()), '\0');
+
+    InstrumentLibraryHeader header = {};
+    memcpy(header.magic, instrument_library_magic, sizeof(header.magic));
+    header.version = instrument_library_version;
+    header.record_size = sizeof(InstrumentRecord);
+    header.count = count;
+    header.bucket_count = bucket_count;
+    header.names_size = names.size();
+
+    std::ofstream ofs(filename, std::ofstream::out | std::ofstream::binary);
+    if (!ofs.is_open()) {
+        return false;
+    }
+    static const char padding[8] = {};
+    ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    ofs.write(reinterpret_cast<const char*>(_records.data()), _records.size() * sizeof(InstrumentRecord));
+    ofs.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(InstrumentLibraryEntry));
+    ofs.write(reinterpret_cast<const char*>(buckets.data()), buckets.size() * sizeof(uint32_t));
+    ofs.write(padding, align8(buckets.size() * sizeof(uint32_t)) - buckets.size() * sizeof(uint32_t));
+    ofs.write(names.data(), names.size());
+    ofs.close();
+    return bool(ofs);
+}
+
+bool InstrumentLibrary::open(const std::string& filename) {
+    close();
+    _file = MappedFile(filename);
+    if (!_file.is_open()) {
+        return false;
+    }
+
+    const unsigned char* data = _file.data();
+    size_t size = _file.size();
+    InstrumentLibraryHeader header;
+    if (size < sizeof(header)) {
+        close();
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, instrument_library_magic, sizeof(header.magic)) != 0 ||
+        header.version != instrument_library_version ||
+        header.record_size < sizeof(InstrumentRecord) || header.record_size % 8 != 0 ||
+        header.bucket_count == 0 || (header.bucket_count & (header.bucket_count - 1)) != 0) {
+        close();
+        return false;
+    }
+
+    // Every section must be in the file, counting in 64 bits so that a damaged header can't overflow
+    uint64_t records = sizeof(header);
+    uint64_t entries = records + uint64_t(header.count) * header.record_size;
+    uint64_t buckets = entries + uint64_t(header.count) * sizeof(InstrumentLibraryEntry);
+    uint64_t names = buckets + align8(size_t(header.bucket_count) * sizeof(uint32_t));
+    if (names > size || header.names_size > size - names) {
+        close();
+        return false;
+    }
+
+    _count = header.count;
+    _record_size = header.record_size;
+    _bucket_mask = header.bucket_count - 1;
+    _records = data + records;
+    _entries = reinterpret_cast<const InstrumentLibraryEntry*>(data + entries);
+    _buckets = reinterpret_cast<const uint32_t*>(data + buckets);
+    _names = reinterpret_cast<const char*>(data + names);
+    _names_size = size_t(header.names_size);
+    return true;
+}
+
+void InstrumentLibrary::close() {
+    _file.close();
+    _count = 0;
+    _record_size = 0;
+    _bucket_mask = 0;
+    _records = nullptr;
+    _entries = nullptr;
+    _buckets = nullptr;
+    _names = nullptr;
+    _names_size = 0;
+}
+
+std::string_view InstrumentLibrary::name(size_t index) const {
+    if (index >= _count) {
+        return std::string_view();
+    }
+    const InstrumentLibraryEntry& entry = _entries[index];
+    if (entry.name_offset > _names_size || entry.name_size > _names_size - entry.name_offset) {
+        return std::string_view();
+    }
+    return std::string_view(_names + entry.name_offset, entry.name_size);
+}
+
+size_t InstrumentLibrary::find(std::string_view name) const {
+    if (!_buckets) {
+        return npos;
+    }
+    uint64_t hash = instrument_library_hash(name);
+    size_t bucket = hash & _bucket_mask;
+    for (size_t probes = 0; probes <= _bucket_mask; probes++) {
+        uint32_t index = _buckets[bucket];
+        if (index == empty_bucket) {
+            return npos;
+        }
+        if (index < _count && _entries[index].hash == hash && this->name(index) == name) {
+            return index;
+        }
+        bucket = (bucket + 1) & _bucket_mask;
+    }
+    return npos;
+}
+
+bool InstrumentLibrary::find(std::string_view name, Instrument& instrument) const {
+    size_t index = find(name);
+    return index != npos && this->instrument(index, instrument);
+}
+
+bool InstrumentLibrary::instrument(size_t index, Instrument& instrument) const {
+    if (index >= _count) {
+        return false;
+    }
+    // Same as loading it from its own file, the fields that aren't saved are the defaults
+    instrument = Instrument();
+    from_record(*reinterpret_cast<const InstrumentRecord*>(_records + index * _record_size), instrument);
+    return true;
+}
+
+}
@@ -0,0 +1,112 @@
+//
+//  InstrumentLibrary.hpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+#ifndef instrument_library_hpp
+#define instrument_library_hpp
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "InstrumentFile.hpp"
+
+namespace fretboarder {
+
+// Library file: many named instruments in one file, with a hash index on their names. Little endian like the binary
+// .frt, every section 8 bytes aligned, one after the other:
+//  - InstrumentLibraryHeader
+//  - count InstrumentRecords, see InstrumentFile.hpp
+//  - count InstrumentLibraryEntries, the names of the records
+//  - bucket_count uint32_t, an open addressing hash table of entry indices (linear probing, empty_bucket if unused)
+//  - names_size bytes of names, each followed by a 0
+struct InstrumentLibraryHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t count;
+    // Power of two, at least twice count
+    uint32_t bucket_count;
+    uint32_t reserved;
+    uint64_t names_size;
+};
+
+struct InstrumentLibraryEntry {
+    uint64_t hash;
+    uint32_t name_offset;
+    uint32_t name_size;
+};
+
+constexpr char instrument_library_magic[4] = { 'F', 'R', 'T', 'L' };
+constexpr uint32_t instrument_library_version = 1;
+
+static_assert(sizeof(InstrumentLibraryHeader) == 32, "The records must stay 8 bytes aligned in the file");
+static_assert(sizeof(InstrumentLibraryEntry) == 16, "The layout of InstrumentLibraryEntry is part of the file format");
+
+// Hash of the names in the index (64 bits FNV-1a).
+uint64_t instrument_library_hash(std::string_view name);
+
+// Builds a library file.
+class InstrumentLibraryWriter {
+public:
+    size_t size() const { return _names.size(); }
+
+    // False if the library already has an instrument with this name.
+    bool add(const std::string& name, const Instrument& instrument);
+
+    bool save(const std::string& filename) const;
+
+private:
+    std::vector<std::string> _names;
+    std::vector<InstrumentRecord> _records;
+    std::unordered_map<std::string, size_t> _indices;
+};
+
+// Read only library file, mapped in memory. Opening it only checks the header, finding an instrument by name reads
+// a few buckets and entries, and only the instruments asked for are decoded: the cost of both doesn't depend on the
+// size of the library.
+class InstrumentLibrary {
+public:
+    static constexpr size_t npos = size_t(-1);
+    static constexpr uint32_t empty_bucket = uint32_t(-1);
+
+    InstrumentLibrary() {}
+    explicit InstrumentLibrary(const std::string& filename) { open(filename); }
+
+    // False if the file can't be read or isn't a library of a known version.
+    bool open(const std::string& filename);
+    void close();
+    bool is_open() const { return _file.is_open(); }
+
+    size_t size() const { return _count; }
+
+    // Name of the instrument at index, empty if the file is damaged. Valid as long as the library is open.
+    std::string_view name(size_t index) const;
+
+    // Index of the instrument with this name, npos if there is none.
+    size_t find(std::string_view name) const;
+    // Decodes the instrument with this name, false if there is none.
+    bool find(std::string_view name, Instrument& instrument) const;
+
+    // Decodes the instrument at index.
+    bool instrument(size_t index, Instrument& instrument) const;
+
+private:
+    MappedFile _file;
+    size_t _count = 0;
+    size_t _record_size = 0;
+    size_t _bucket_mask = 0;
+    const unsigned char* _records = nullptr;
+    const InstrumentLibraryEntry* _entries = nullptr;
+    const uint32_t* _buckets = nullptr;
+    const char* _names = nullptr;
+    size_t _names_size = 0;
+};
+
+}
+
+#endif /* instrument_library_hpp */
@@ -0,0 +1,235 @@
+//
+//  LayoutOptimizer.cpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+#include <algorithm>
+#include <cmath>
+#include "Arena.hpp"
+#include "LayoutOptimizer.hpp"
+
+namespace fretboarder {
+
+static const double degrees_per_radian = 180 / 3.14159265358979323846;
+
+// Angle between the line going from (x1, y1) to (x2, y2) and the Y axis, in degrees
+static double angle_from_y_axis(double x1, double y1, double x2, double y2) {
+    return atan2(fabs(x2 - x1), fabs(y2 - y1)) * degrees_per_radian;
+}
+
+LayoutMetrics measure_layout(const Fretboard& fretboard) {
+    LayoutMetrics metrics;
+
+    const FretTable& table = fretboard.fret_table();
+    auto x1 = table.column(FretTable::line_x1);
+    auto y1 = table.column(FretTable::line_y1);
+    auto x2 = table.column(FretTable::line_x2);
+    auto y2 = table.column(FretTable::line_y2);
+    for (size_t i = 0; i < table.size(); i++) {
+        metrics.max_fret_angle = std::max(metrics.max_fret_angle, angle_from_y_axis(x1[i], y1[i], x2[i], y2[i]));
+    }
+
+    const Quad& nut = fretboard.nut_shape();
+    metrics.nut_width = nut.points[1].distanceFrom(nut.points[2]);
+
+    const Quad& strings = fretboard.strings_shape();
+    metrics.bridge_angle = angle_from_y_axis(strings.points[1].x, strings.points[1].y, strings.points[2].x, strings.points[2].y);
+
+    metrics.heel = fretboard.construction_distance_at_heel();
+    return metrics;
+}
+
+double LayoutTarget::cost(double metric) const {
+    double error = metric - value;
+    if ((kind == LayoutTargetKind::at_most && error <= 0) || (kind == LayoutTargetKind::at_least && error >= 0)) {
+        return 0;
+    }
+    return weight * error * error;
+}
+
+double LayoutTargets::cost(const LayoutMetrics& metrics) const {
+    return max_fret_angle.cost(metrics.max_fret_angle)
+        + nut_width.cost(metrics.nut_width)
+        + bridge_angle.cost(metrics.bridge_angle)
+        + heel.cost(metrics.heel);
+}
+
+static LayoutRange fixed_range(double value) {
+    LayoutRange range;
+    range.min = value;
+    range.max = value;
+    return range;
+}
+
+LayoutSearch::LayoutSearch(const Instrument& base) :
+    base(base),
+    perpendicular_fret_index(fixed_range(base.perpendicular_fret_index)),
+    scale_length_treble(fixed_range(base.scale_length[0])),
+    scale_length_bass(fixed_range(base.scale_length[1])),
+    inter_string_spacing_at_nut(fixed_range(base.inter_string_spacing_at_nut)),
+    inter_string_spacing_at_bridge(fixed_range(base.inter_string_spacing_at_bridge)) {
+}
+
+namespace {
+
+enum { parameter_count = 5 };
+
+struct Grid {
+    LayoutRange ranges[parameter_count];
+
+    size_t size() const {
+        size_t size = 1;
+        for (const auto& range : ranges) {
+            size *= std::max(1, range.steps);
+        }
+        return size;
+    }
+
+    // Candidate index is a mixed radix number, one digit per parameter
+    Instrument candidate(const Instrument& base, size_t index) const {
+        double values[parameter_count];
+        for (int p = 0; p < parameter_count; p++) {
+            size_t steps = std::max(1, ranges[p].steps);
+            values[p] = ranges[p].value(int(index % steps));
+            index /= steps;
+        }
+
+        Instrument instrument = base;
+        instrument.perpendicular_fret_index = values[0];
+        instrument.scale_length[0] = values[1];
+        instrument.scale_length[1] = values[2];
+        instrument.inter_string_spacing_at_nut = values[3];
+        instrument.inter_string_spacing_at_bridge = values[4];
+        instrument.validate();
+        return instrument;
+    }
+
+    // Same grid centered on value, spanning two steps of the current one, without leaving the original range
+    Grid refined(const Grid& original, const Instrument& best) const {
+        const double values[parameter_count] = {
+            best.perpendicular_fret_index,
+            best.scale_length[0],
+            best.scale_length[1],
+            best.inter_string_spacing_at_nut,
+            best.inter_string_spacing_at_bridge
+        };
+
+        Grid grid = *this;
+        for (int p = 0; p < parameter_count; p++) {
+            LayoutRange& range = grid.ranges[p];
+            if (range.steps <= 1) {
+                continue;
+            }
+            double step = (ranges[p].max - ranges[p].min) / (ranges[p].steps - 1);
+            range.min = std::max(original.ranges[p].min, values[p] - step);
+            range.max = std::min(original.ranges[p].max, values[p] + step);
+        }
+        return grid;
+    }
+};
+
+struct Scored {
+    LayoutCandidate candidate;
+    size_t order; // position in the search, to break ties the same way whatever the threads
+};
+
+bool operator<(const Scored& a, const Scored& b) {
+    if (a.candidate.cost != b.candidate.cost) {
+        return a.candidate.cost < b.candidate.cost;
+    }
+    return a.order < b.order;
+}
+
+bool same_layout(const Instrument& a, const Instrument& b) {
+    return a.perpendicular_fret_index == b.perpendicular_fret_index
+        && a.scale_length[0] == b.scale_length[0]
+        && a.scale_length[1] == b.scale_length[1]
+        && a.inter_string_spacing_at_nut == b.inter_string_spacing_at_nut
+        && a.inter_string_spacing_at_bridge == b.inter_string_spacing_at_bridge;
+}
+
+// Keeps the count best scored candidates, best first, skipping the layouts it already has
+void keep_best(std::vector<Scored>& best, const Scored& scored, size_t count) {
+    if (best.size() == count && !(scored < best.back())) {
+        return;
+    }
+    for (const auto& other : best) {
+        if (same_layout(other.candidate.instrument, scored.candidate.instrument)) {
+            return;
+        }
+    }
+    best.insert(std::upper_bound(best.begin(), best.end(), scored), scored);
+    if (best.size() > count) {
+        best.pop_back();
+    }
+}
+
+}
+
+std::vector<LayoutCandidate> optimize_layout(const LayoutSearch& search, ThreadPool& pool) {
+    const size_t count = std::max<size_t>(1, search.best_count);
+    const Grid original = { {
+        search.perpendicular_fret_index,
+        search.scale_length_treble,
+        search.scale_length_bass,
+        search.inter_string_spacing_at_nut,
+        search.inter_string_spacing_at_bridge
+    } };
+
+    // Per worker state: fretboards are built in the worker's arena and only the best candidates are kept
+    std::vector<std::unique_ptr<Arena>> arenas;
+    std::vector<std::vector<Scored>> worker_best(pool.thread_count());
+    for (size_t worker = 0; worker < pool.thread_count(); worker++) {
+        arenas.emplace_back(new Arena());
+        worker_best[worker].reserve(count + 1);
+    }
+
+    std::vector<Scored> best;
+    Grid grid = original;
+    size_t order = 0;
+    for (int pass = 0; pass <= std::max(0, search.refinements); pass++) {
+        size_t size = grid.size();
+        pool.parallel_for(size, 64, [&](size_t begin, size_t end, size_t worker) {
+            Arena& arena = *arenas[worker];
+            for (size_t i = begin; i < end; i++) {
+                Scored scored { { grid.candidate(search.base, i), LayoutMetrics(), 0 }, order + i };
+                arena.reset();
+                Fretboard fretboard(scored.candidate.instrument, arena);
+                scored.candidate.metrics = measure_layout(fretboard);
+                scored.candidate.cost = search.targets.cost(scored.candidate.metrics);
+                // Degenerated layouts have finite metrics measured on fallback geometry
+                if (std::isnan(scored.candidate.cost) || !fretboard.is_valid()) {
+                    continue;
+                }
+                keep_best(worker_best[worker], scored, count);
+            }
+        });
+        order += size;
+
+        for (auto& candidates : worker_best) {
+            for (const auto& scored : candidates) {
+                keep_best(best, scored, count);
+            }
+            candidates.clear();
+        }
+        if (best.empty()) {
+            break;
+        }
+        grid = grid.refined(original, best.front().candidate.instrument);
+    }
+
+    std::vector<LayoutCandidate> result;
+    for (const auto& scored : best) {
+        result.push_back(scored.candidate);
+    }
+    return result;
+}
+
+std::vector<LayoutCandidate> optimize_layout(const LayoutSearch& search) {
+    return optimize_layout(search, ThreadPool::shared());
+}
+
+}
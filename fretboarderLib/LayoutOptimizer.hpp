@@ -0,0 +1,99 @@
+//
+//  LayoutOptimizer.hpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+#ifndef layout_optimizer_hpp
+#define layout_optimizer_hpp
+
+#include <vector>
+#include "Fretboard.hpp"
+#include "ThreadPool.hpp"
+
+namespace fretboarder {
+
+// What we look at when choosing the layout of a (multiscale) fretboard. Angles are in degrees, 0 being
+// perpendicular to the center line of the fretboard, lengths are in the unit of the instrument.
+struct LayoutMetrics {
+    double max_fret_angle = 0;  // largest angle of a fret
+    double nut_width = 0;       // width of the fretboard along the nut
+    double bridge_angle = 0;    // angle of the line going through the bridge end of the outer strings
+    double heel = 0;            // Fretboard::construction_distance_at_heel()
+};
+
+LayoutMetrics measure_layout(const Fretboard& fretboard);
+
+enum class LayoutTargetKind {
+    exactly,
+    at_most,
+    at_least
+};
+
+// A target adds weight * (metric - value)^2 to the cost of a layout, only when the metric is above the value for
+// at_most and only when it's below for at_least. A weight of 0 ignores the metric.
+struct LayoutTarget {
+    double value = 0;
+    double weight = 0;
+    LayoutTargetKind kind = LayoutTargetKind::exactly;
+
+    double cost(double metric) const;
+};
+
+struct LayoutTargets {
+    LayoutTarget max_fret_angle;
+    LayoutTarget nut_width;
+    LayoutTarget bridge_angle;
+    LayoutTarget heel;
+
+    double cost(const LayoutMetrics& metrics) const;
+};
+
+// Values tried for a parameter: steps values evenly spread over [min, max]. One step keeps min.
+struct LayoutRange {
+    double min = 0;
+    double max = 0;
+    int steps = 1;
+
+    double value(int step) const { return steps > 1 ? min + (max - min) * step / (steps - 1) : min; }
+};
+
+struct LayoutSearch {
+    // Every other field of the candidates comes from base.
+    Instrument base;
+
+    LayoutRange perpendicular_fret_index;
+    LayoutRange scale_length_treble;
+    LayoutRange scale_length_bass;
+    LayoutRange inter_string_spacing_at_nut;
+    LayoutRange inter_string_spacing_at_bridge;
+
+    LayoutTargets targets;
+
+    // Number of designs returned.
+    size_t best_count = 10;
+
+    // After the first grid, search again refinements times on a grid of the same size around the best design so
+    // far, each time spanning two steps of the previous grid.
+    int refinements = 2;
+
+    // Starts with the values of base for every parameter, not searched.
+    explicit LayoutSearch(const Instrument& base);
+};
+
+struct LayoutCandidate {
+    Instrument instrument;
+    LayoutMetrics metrics;
+    double cost;
+};
+
+// Evaluates every candidate of the search grid in parallel on pool and returns the best_count best designs, best
+// first. The result only depends on the search, not on the number of threads.
+std::vector<LayoutCandidate> optimize_layout(const LayoutSearch& search, ThreadPool& pool);
+std::vector<LayoutCandidate> optimize_layout(const LayoutSearch& search);
+
+}
+
+#endif /* layout_optimizer_hpp */
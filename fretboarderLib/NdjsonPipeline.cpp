@@ -0,0 +1,303 @@
+//
+//  NdjsonPipeline.cpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include "BoundedQueue.hpp"
+#include "FretboardBatch.hpp"
+#include "InstrumentJson.hpp"
+#include "NdjsonPipeline.hpp"
+
+namespace fretboarder {
+
+namespace {
+
+// Lines going through the pipeline together, and everything made from them. Batches are reused: their buffers only
+// grow.
+struct Batch {
+    size_t size = 0;
+    std::vector<std::string> lines;
+    std::vector<size_t> line_numbers;
+    // For each line, its instrument in instruments and fretboards, or -1 and the error in errors
+    std::vector<int> boards;
+    std::vector<std::string> errors;
+    std::vector<Instrument> instruments;
+    FretboardBatch fretboards;
+    std::vector<char> output;
+    size_t output_size = 0;
+};
+
+bool is_blank(const std::string& line) {
+    for (char c : line) {
+        if (c != ' ' && c != '\t' && c != '\r' && c != '\n') {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Fills batch with the next lines of input, false once there are none.
+bool read(std::istream& input, size_t batch_size, Batch& batch, size_t& line_number) {
+    batch.lines.resize(std::max(batch.lines.size(), batch_size));
+    batch.line_numbers.resize(batch.lines.size());
+    batch.size = 0;
+    while (batch.size < batch_size && std::getline(input, batch.lines[batch.size])) {
+        line_number++;
+        if (!is_blank(batch.lines[batch.size])) {
+            batch.line_numbers[batch.size++] = line_number;
+        }
+    }
+    return batch.size > 0;
+}
+
+void parse(Batch& batch) {
+    batch.boards.resize(batch.size);
+    batch.errors.resize(batch.size);
+    batch.instruments.clear();
+    for (size_t i = 0; i < batch.size; i++) {
+        const std::string& line = batch.lines[i];
+        Instrument instrument;
+        if (!parse_instrument_json(line.data(), line.data() + line.size(), instrument)) {
+            // Same as Instrument::load()
+            try {
+                instrument = json::parse(line).get<Instrument>();
+            } catch (const json::exception& e) {
+                batch.boards[i] = -1;
+                batch.errors[i] = e.what();
+                continue;
+            }
+        }
+        if (const char* error = instrument.build_error()) {
+            batch.boards[i] = -1;
+            batch.errors[i] = error;
+            continue;
+        }
+        instrument.validate();
+        batch.boards[i] = int(batch.instruments.size());
+        batch.instruments.push_back(instrument);
+    }
+}
+
+void build(Batch& batch, ThreadPool& pool) {
+    generate_batch(Span<const Instrument>(batch.instruments), batch.fretboards, pool);
+}
+
+// Longest number written by write_number()
+const size_t max_number_length = 32;
+
+char* write_text(char* p, const char* text) {
+    size_t size = strlen(text);
+    memcpy(p, text, size);
+    return p + size;
+}
+
+char* write_number(char* p, double value) {
+    if (!std::isfinite(value)) {
+        return write_text(p, "null");
+    }
+    return nlohmann::detail::to_chars(p, p + max_number_length, value);
+}
+
+char* write_integer(char* p, size_t value) {
+    char digits[24];
+    size_t n = 0;
+    do {
+        digits[n++] = char('0' + value % 10);
+        value /= 10;
+    } while (value);
+    while (n) {
+        *p++ = digits[--n];
+    }
+    return p;
+}
+
+// Up to 6 characters per character of text
+char* write_string(char* p, const std::string& text) {
+    static const char hex[] = "0123456789abcdef";
+    *p++ = '"';
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            *p++ = '\\';
+            *p++ = char(c);
+        } else if (c < 0x20) {
+            p = write_text(p, "\\u00");
+            *p++ = hex[c >> 4];
+            *p++ = hex[c & 15];
+        } else {
+            // Messages quote the input, which isn't always UTF-8
+            *p++ = c < 0x80 ? char(c) : '?';
+        }
+    }
+    *p++ = '"';
+    return p;
+}
+
+char* write_fretboard(char* p, const Fretboard& fretboard) {
+    p = write_text(p, fretboard.is_valid() ? ",\"valid\":true" : ",\"valid\":false");
+
+    const FretTable& table = fretboard.fret_table();
+    auto write_vectors = [&](const char* key, FretTable::Column first) {
+        p = write_text(p, key);
+        *p++ = '[';
+        for (size_t i = 0; i < table.size(); i++) {
+            p = write_text(p, i ? ",[" : "[");
+            for (int c = 0; c < 4; c++) {
+                if (c) {
+                    *p++ = ',';
+                }
+                p = write_number(p, table.column(FretTable::Column(first + c))[i]);
+            }
+            *p++ = ']';
+        }
+        *p++ = ']';
+    };
+    write_vectors(",\"fret_lines\":", FretTable::line_x1);
+    write_vectors(",\"fret_slots\":", FretTable::slot_x1);
+
+    p = write_text(p, ",\"board_shape\":[");
+    const Quad& board = fretboard.board_shape();
+    for (int i = 0; i < 4; i++) {
+        p = write_text(p, i ? ",[" : "[");
+        p = write_number(p, board.points[i].x);
+        *p++ = ',';
+        p = write_number(p, board.points[i].y);
+        *p++ = ']';
+    }
+    *p++ = ']';
+
+    p = write_text(p, ",\"construction_distance_at_nut_side\":");
+    p = write_number(p, fretboard.construction_distance_at_nut_side());
+    p = write_text(p, ",\"construction_distance_at_heel\":");
+    p = write_number(p, fretboard.construction_distance_at_heel());
+    p = write_text(p, ",\"construction_distance_at_nut\":");
+    p = write_number(p, fretboard.construction_distance_at_nut());
+    p = write_text(p, ",\"construction_distance_at_last_fret\":");
+    p = write_number(p, fretboard.construction_distance_at_last_fret());
+    p = write_text(p, ",\"construction_distance_at_12th_fret\":");
+    p = write_number(p, fretboard.construction_distance_at_12th_fret());
+    p = write_text(p, ",\"construction_distance_at_octave\":");
+    p = write_number(p, fretboard.construction_distance_at_octave());
+    return p;
+}
+
+void serialize(Batch& batch) {
+    // Room for the longest output, so that lines are written without checking
+    const size_t keys_length = 512;
+    size_t bound = 0;
+    for (size_t i = 0; i < batch.size; i++) {
+        bound += keys_length;
+        if (batch.boards[i] < 0) {
+            bound += batch.errors[i].size() * 6;
+        } else {
+            size_t frets = batch.fretboards[batch.boards[i]].fret_table().size();
+            bound += (frets * 8 + 14) * (max_number_length + 3);
+        }
+    }
+    if (batch.output.size() < bound) {
+        batch.output.resize(bound);
+    }
+
+    char* p = batch.output.data();
+    for (size_t i = 0; i < batch.size; i++) {
+        p = write_text(p, "{\"line\":");
+        p = write_integer(p, batch.line_numbers[i]);
+        if (batch.boards[i] < 0) {
+            p = write_text(p, ",\"error\":");
+            p = write_string(p, batch.errors[i]);
+        } else {
+            p = write_fretboard(p, batch.fretboards[batch.boards[i]]);
+        }
+        p = write_text(p, "}\n");
+    }
+    batch.output_size = p - batch.output.data();
+}
+
+void count(const Batch& batch, NdjsonPipelineStats& stats) {
+    stats.lines += batch.size;
+    stats.fretboards += batch.instruments.size();
+    stats.errors += batch.size - batch.instruments.size();
+}
+
+}
+
+bool run_ndjson_pipeline(std::istream& input, std::ostream& output, const NdjsonPipelineOptions& options,
+                         NdjsonPipelineStats* stats) {
+    NdjsonPipelineStats counts;
+    size_t batch_size = std::max<size_t>(1, options.batch_size);
+    size_t line_number = 0;
+    // Building is the slowest stage by far, the fretboards of a batch are built on every core
+    ThreadPool& pool = ThreadPool::shared();
+
+    if (!options.pipelined) {
+        Batch batch;
+        while (read(input, batch_size, batch, line_number)) {
+            parse(batch);
+            build(batch, pool);
+            serialize(batch);
+            output.write(batch.output.data(), batch.output_size);
+            count(batch, counts);
+        }
+    } else {
+        size_t batch_count = std::max<size_t>(1, options.batch_count);
+        std::vector<Batch> batches(batch_count);
+        BoundedQueue<Batch*> empty(batch_count), parsing(batch_count), building(batch_count), serializing(batch_count),
+            writing(batch_count);
+        for (auto& batch : batches) {
+            empty.push(&batch);
+        }
+
+        std::thread reader([&]() {
+            Batch* batch;
+            while (empty.pop(batch) && read(input, batch_size, *batch, line_number)) {
+                parsing.push(batch);
+            }
+            parsing.close();
+        });
+        auto stage = [](BoundedQueue<Batch*>& in, BoundedQueue<Batch*>& out, auto&& function) {
+            Batch* batch;
+            while (in.pop(batch)) {
+                function(*batch);
+                out.push(batch);
+            }
+            out.close();
+        };
+        std::thread parser([&]() { stage(parsing, building, parse); });
+        std::thread builder([&]() { stage(building, serializing, [&](Batch& batch) { build(batch, pool); }); });
+        std::thread serializer([&]() { stage(serializing, writing, serialize); });
+
+        // Queues are FIFO and each stage has one thread: batches arrive in the order they were read
+        Batch* batch;
+        while (writing.pop(batch)) {
+            if (output) {
+                output.write(batch->output.data(), batch->output_size);
+                count(*batch, counts);
+            }
+            if (!output) {
+                // Nothing more to read, let what's in flight drain
+                empty.close();
+            }
+            empty.push(batch);
+        }
+
+        reader.join();
+        parser.join();
+        builder.join();
+        serializer.join();
+    }
+
+    output.flush();
+    if (stats) {
+        *stats = counts;
+    }
+    return bool(output);
+}
+
+}
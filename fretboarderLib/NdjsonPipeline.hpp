@@ -0,0 +1,52 @@
+//
+//  NdjsonPipeline.hpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+#ifndef ndjson_pipeline_hpp
+#define ndjson_pipeline_hpp
+
+#include <istream>
+#include <ostream>
+#include "Fretboard.hpp"
+
+namespace fretboarder {
+
+struct NdjsonPipelineOptions {
+    // Lines going through the stages together
+    size_t batch_size = 256;
+    // Batches in flight, which bounds the queues between the stages and the memory used
+    size_t batch_count = 8;
+    // One thread per stage, or every stage on the calling thread one batch after the other
+    bool pipelined = true;
+};
+
+struct NdjsonPipelineStats {
+    size_t lines = 0;
+    size_t fretboards = 0;
+    size_t errors = 0;
+};
+
+// Reads one Instrument JSON per line from input (see to_json(), empty lines are skipped) and writes one line per
+// instrument to output, in the same order:
+//   {"line":1,"valid":true,"fret_lines":[[x1,y1,x2,y2],...],"fret_slots":[[x1,y1,x2,y2],...],
+//    "board_shape":[[x0,y0],...,[x3,y3]],"construction_distance_at_nut_side":d,...}
+// with every construction distance of Fretboard, or {"line":2,"error":"..."} when the line isn't an instrument or
+// one a fretboard can be built from (no strings, more than 1000 frets, less than 1 fret per octave...).
+// Numbers are written with the fewest digits that read back to the same double, null if they aren't finite.
+//
+// Reading, parsing, building the fretboards and serializing them are stages running on their own thread, writing
+// runs on the calling one and the fretboards of a batch are built on ThreadPool::shared(). Batches of lines go from
+// one to the next through bounded queues, so throughput is that of the slowest stage rather than of all of them, and
+// batches are reused so that memory stops growing once they've seen the longest lines. Returns false if output
+// failed.
+bool run_ndjson_pipeline(std::istream& input, std::ostream& output,
+                         const NdjsonPipelineOptions& options = NdjsonPipelineOptions(),
+                         NdjsonPipelineStats* stats = nullptr);
+
+}
+
+#endif /* ndjson_pipeline_hpp */
@@ -8,3 +8,69 @@
 
 #include "String.hpp"
 
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace fretboarder;
+
+static const FretRatioTable twelve_tet_table(12, twelve_tet_ratios.data());
+
+namespace {
+
+// Ratios of a table built at runtime, kept alive for as long as the program runs.
+struct FretRatioStorage {
+    std::vector<double> ratios;
+    std::unique_ptr<FretRatioTable> table;
+};
+
+}
+
+const FretRatioTable* FretRatioTable::get(double frets_per_octave)
+{
+    if (frets_per_octave == 12) {
+        return &twelve_tet_table;
+    }
+
+    // Any sensible equal temperament, the 12 octaves of a 1200-EDO table are less than 120KB
+    if (!(frets_per_octave >= 1 && frets_per_octave <= max_frets_per_octave) || int(frets_per_octave) != frets_per_octave) {
+        return nullptr;
+    }
+    int n = int(frets_per_octave);
+
+    // Every string of every fretboard asks for its table: once built, they are found without locking
+    static std::atomic<const FretRatioTable*> built[max_frets_per_octave + 1];
+    const FretRatioTable* table = built[n].load(std::memory_order_acquire);
+    if (table) {
+        return table;
+    }
+
+    static std::mutex mutex;
+    static std::map<int, FretRatioStorage> tables;
+    std::lock_guard<std::mutex> lock(mutex);
+
+    FretRatioStorage& storage = tables[n];
+    if (!storage.table) {
+        int first = -octaves_below * n;
+        int count = (octaves_below + octaves_above) * n;
+        storage.ratios.resize(count);
+        // First octave with pow, the others are exact powers of two of it
+        for (int note = 0; note < n; note++) {
+            storage.ratios[note - first] = pow(2, -double(note) / n);
+        }
+        for (int i = 0; i < count; i++) {
+            int octave = (i + first) / n;
+            int note = (i + first) % n;
+            if (note < 0) {
+                note += n;
+                octave--;
+            }
+            storage.ratios[i] = ldexp(storage.ratios[note - first], -octave);
+        }
+        storage.table.reset(new FretRatioTable(n, storage.ratios.data()));
+        built[n].store(storage.table.get(), std::memory_order_release);
+    }
+    return storage.table.get();
+}
@@ -10,35 +10,159 @@
 #define string_hpp
 
 #include <math.h>
+#include <array>
 #include "Geometry.hpp"
+#include "FretKernel.hpp"
 
 namespace fretboarder {
 
-class String {
+// 2^(-k/12) for k in [0, 12), correctly rounded.
+constexpr double twelve_tet_octave_ratios[12] = {
+    1.0,
+    0.9438743126816935,
+    0.8908987181403393,
+    0.8408964152537145,
+    0.7937005259840998,
+    0.7491535384383408,
+    0.7071067811865476,
+    0.6674199270850172,
+    0.6299605249474366,
+    0.5946035575013605,
+    0.5612310241546865,
+    0.5297315471796477
+};
+
+// Ratio between the vibrating length of a string fretted at fret_index and its scale length (2^(-fret_index / N),
+// N being the number of frets per octave), precomputed for every integer fret index in [first_index(), last_index()].
+// Tables are built once per number of frets per octave and shared, see get(). The 12-TET table is computed at compile
+// time. Indices outside of the table are derived from the first octave, fractional ones are interpolated.
+class FretRatioTable {
+public:
+    // Octaves covered by the tables below and above the nut.
+    enum { octaves_below = 4, octaves_above = 8 };
+    // Largest number of frets per octave with a table.
+    enum { max_frets_per_octave = 1200 };
+
+    // Shared table for this number of frets per octave, or nullptr if it's not a whole number of divisions.
+    static const FretRatioTable* get(double frets_per_octave);
+
+    FretRatioTable(int frets_per_octave, const double* ratios)
+    : _frets_per_octave(frets_per_octave), _first_index(-octaves_below * frets_per_octave), _ratios(ratios) {}
+
+    int frets_per_octave() const { return _frets_per_octave; }
+    int first_index() const { return _first_index; }
+    int last_index() const { return octaves_above * _frets_per_octave - 1; }
+
+    // Fractional indices are interpolated in log-ratio between the frets around them, which follows the temperament
+    // of the table and is 2^(-fret_index / N) for equal divisions.
+    double ratio(double fret_index) const {
+        if (fabs(fret_index) < 1e6) {
+            double below = floor(fret_index);
+            double r = ratio(int(below));
+            if (below == fret_index) {
+                return r;
+            }
+            return r * exp2((fret_index - below) * log2(ratio(int(below) + 1) / r));
+        }
+        return pow(2, -fret_index / _frets_per_octave);
+    }
+
+    // Same for scalars with derivatives (see Dual), which are those of the interpolation. On the frets, they are the
+    // ones of the interval above.
+    template <class T>
+    T ratio(const T& fret_index) const {
+        using std::exp2;
+        using std::pow;
+
+        double index = ScalarTraits<T>::value(fret_index);
+        if (ScalarTraits<T>::is_constant(fret_index)) {
+            return T(ratio(index));
+        }
+        if (fabs(index) < 1e6) {
+            double below = floor(index);
+            double r = ratio(int(below));
+            return r * exp2((fret_index - below) * log2(ratio(int(below) + 1) / r));
+        }
+        return pow(2.0, fret_index / -double(_frets_per_octave));
+    }
+
+    double ratio(int fret_index) const {
+        if (fret_index >= _first_index && fret_index <= last_index()) {
+            return _ratios[fret_index - _first_index];
+        }
+        // Scale the ratio of the same note in the first octave
+        int octave = fret_index / _frets_per_octave;
+        int note = fret_index % _frets_per_octave;
+        if (note < 0) {
+            note += _frets_per_octave;
+            octave--;
+        }
+        return ldexp(_ratios[note - _first_index], -octave);
+    }
+
+private:
+    int _frets_per_octave;
+    int _first_index;
+    const double* _ratios;
+};
+
+constexpr int twelve_tet_ratio_count = (FretRatioTable::octaves_below + FretRatioTable::octaves_above) * 12;
+
+constexpr std::array<double, twelve_tet_ratio_count> make_twelve_tet_ratios() {
+    std::array<double, twelve_tet_ratio_count> ratios {};
+    for (int i = 0; i < twelve_tet_ratio_count; i++) {
+        int octave = i / 12 - FretRatioTable::octaves_below;
+        double ratio = twelve_tet_octave_ratios[i % 12];
+        // Scaling by powers of two is exact
+        for (int o = 0; o < octave; o++) {
+            ratio *= 0.5;
+        }
+        for (int o = 0; o > octave; o--) {
+            ratio *= 2;
+        }
+        ratios[i] = ratio;
+    }
+    return ratios;
+}
+
+constexpr std::array<double, twelve_tet_ratio_count> twelve_tet_ratios = make_twelve_tet_ratios();
+
+template <class T>
+class BasicString {
 private:
     int _index;
-    double _scale_length;
-    double _perpendicular_fret_index;
-    double _perpendicular_fret_from_start;
-    double _x_at_start;
-    double _x_at_nut;
-    double _y_at_start;
-    double _x_at_bridge;
-    double _y_at_bridge;
+    T _scale_length;
+    T _perpendicular_fret_index;
+    T _perpendicular_fret_from_start;
+    T _x_at_start;
+    T _x_at_nut;
+    T _y_at_start;
+    T _x_at_bridge;
+    T _y_at_bridge;
     double _number_of_frets_per_octave;
-    double _nut_to_zero_fret_offset;
-    double _x_offset = 0;
+    T _nut_to_zero_fret_offset;
+    T _x_offset = T(0);
+    const FretRatioTable* _ratios;
+    bool _tempered = false;
 
 public:
-    String(int index,
-           double scale_length,
-           double perpendicular_fret_index,
-           double y_at_start,
-           double y_at_bridge,
-           bool has_zero_fret,
-           double nut_to_zero_fret_offset,
-           double number_of_frets_per_octave=12)
+    typedef BasicPoint<T> Point;
+    typedef BasicVector<T> Vector;
+
+    BasicString(int index,
+                T scale_length,
+                T perpendicular_fret_index,
+                T y_at_start,
+                T y_at_bridge,
+                bool has_zero_fret,
+                T nut_to_zero_fret_offset,
+                double number_of_frets_per_octave=12,
+                const FretRatioTable* ratios=nullptr)
     {
+        using std::abs;
+        using std::pow;
+        using std::sqrt;
+
         _index = index;
         _scale_length = scale_length;
         _perpendicular_fret_index = perpendicular_fret_index;
@@ -47,6 +171,9 @@ public:
         _x_at_bridge = 0;
         _y_at_bridge = y_at_bridge;
         _number_of_frets_per_octave = number_of_frets_per_octave;
+        // A temperament's table (see Temperament), or the equal temperament one
+        _ratios = ratios ? ratios : FretRatioTable::get(number_of_frets_per_octave);
+        _tempered = ratios != nullptr;
         
         if (has_zero_fret) {
             _nut_to_zero_fret_offset = nut_to_zero_fret_offset;
@@ -60,21 +187,22 @@ public:
             _perpendicular_fret_from_start = distance_from_start(perpendicular_fret_index);
             auto virtual_length = distance_from_bridge(_perpendicular_fret_index);
 
-            double y_intersect = (
+            T y_intersect = (
                            y_at_start
                            + _perpendicular_fret_from_start
                            * (y_at_bridge - y_at_start)
                            / scale_length
                            );
             
-            String virtual_string(index,
+            BasicString virtual_string(index,
                    virtual_length,
                    0,
                    y_intersect,
                    y_at_bridge,
                    has_zero_fret,
                    nut_to_zero_fret_offset,
-                   number_of_frets_per_octave);
+                   number_of_frets_per_octave,
+                   ratios);
 
             _x_at_start = virtual_string.distance_from_start(-perpendicular_fret_index);
             _x_at_nut = _x_at_start - nut_to_zero_fret_offset;
@@ -85,7 +213,7 @@ public:
             // init StraightLine
             _perpendicular_fret_from_start = distance_from_start(perpendicular_fret_index);
             
-            double y_intersect = (
+            T y_intersect = (
                            y_at_start
                            + _perpendicular_fret_from_start
                            * (y_at_bridge - y_at_start)
@@ -96,18 +224,18 @@ public:
             _x_at_start = -sign * sqrt( pow(_perpendicular_fret_from_start, 2) - pow(y_intersect - y_at_start, 2) );
             _x_at_nut = _x_at_start - nut_to_zero_fret_offset;
             
-            double l = scale_length;
+            T l = scale_length;
             if (_perpendicular_fret_from_start < 0) {
                 l -= _perpendicular_fret_from_start;
             }
-            double xab = pow(scale_length, 2) - pow(y_at_bridge - y_at_start, 2);
+            T xab = pow(scale_length, 2) - pow(y_at_bridge - y_at_start, 2);
             xab = sqrt(xab);
             xab -= abs(_x_at_start);
             _x_at_bridge = xab;
         }
     }
 
-    String(const String& source) {
+    BasicString(const BasicString& source) {
         _index = source._index;
         _scale_length = source._scale_length;
         _perpendicular_fret_index = source._perpendicular_fret_index;
@@ -120,9 +248,11 @@ public:
         _number_of_frets_per_octave = source._number_of_frets_per_octave;
         _nut_to_zero_fret_offset = source._nut_to_zero_fret_offset;
         _x_offset = source._x_offset;
+        _ratios = source._ratios;
+        _tempered = source._tempered;
     }
 
-    String& operator =(const String& source) {
+    BasicString& operator =(const BasicString& source) {
         _index = source._index;
         _scale_length = source._scale_length;
         _perpendicular_fret_index = source._perpendicular_fret_index;
@@ -135,26 +265,36 @@ public:
         _number_of_frets_per_octave = source._number_of_frets_per_octave;
         _nut_to_zero_fret_offset = source._nut_to_zero_fret_offset;
         _x_offset = source._x_offset;
+        _ratios = source._ratios;
+        _tempered = source._tempered;
         return *this;
     }
     
 
-    double distance_from_start(double fret_index) const {
+    T distance_from_start(T fret_index) const {
         return _scale_length - distance_from_bridge(fret_index);
     }
     
-    double distance_from_bridge(double fret_index) const {
+    T distance_from_bridge(T fret_index) const {
+        using std::pow;
+
         if (fret_index == 100) {
-            return 0;
+            return T(0);
         }
 
-        double l = _scale_length;
-        double i = fret_index;
+        if (_ratios) {
+            return _scale_length * _ratios->ratio(fret_index);
+        }
+
+        double index = ScalarTraits<T>::value(fret_index);
+        T l = _scale_length;
+        T i = fret_index;
         if (i < 0) {
-            // We need to change the scale and recompute the index relative to the new scale
-            int s = (1 + int(-i / 12)) ;
+            // We need to change the scale and recompute the index relative to the new scale, s octaves lower
+            double n = _number_of_frets_per_octave;
+            int s = (1 + int(-index / n));
             l = l * (1 << s);
-            i = 12 * s + i;
+            i = n * s + i;
         }
         return l / pow(2, i / _number_of_frets_per_octave);
     }
@@ -167,14 +307,34 @@ public:
 //        return distance_between_frets(_perpendicular_fret_index, fret_index);
 //    }
 //
-    Point point_at_fret(double fret_index) const {
-        double d = distance_from_start(fret_index);
-        double t = d / _scale_length;
-        double x = t * (x_at_bridge() - x_at_start());
-        double y = t * (y_at_bridge() - y_at_start());
+    Point point_at_fret(T fret_index) const {
+        T d = distance_from_start(fret_index);
+        T t = d / _scale_length;
+        T x = t * (x_at_bridge() - x_at_start());
+        T y = t * (y_at_bridge() - y_at_start());
         return Point(x_at_start() + x, y_at_start() + y);
     }
     
+    // point_at_fret() for many fret indices at once, points must be at least as large as indices. Only for doubles:
+    // runs the SIMD fret kernel, within 1e-9 relative of point_at_fret() (see fretboarder::points_at_frets()). The
+    // kernel only knows equal temperament, tempered strings go through point_at_fret().
+    template <class U = T, class = typename std::enable_if<std::is_same<U, double>::value>::type>
+    void points_at_frets(Span<const double> indices, Span<Point> points) const {
+        if (_tempered) {
+            assert(points.size() >= indices.size());
+            for (size_t i = 0; i < indices.size(); i++) {
+                points[i] = point_at_fret(indices[i]);
+            }
+            return;
+        }
+        FretPointsInput input;
+        input.start = point_at_nut();
+        input.direction = point_at_bridge() - point_at_nut();
+        input.frets_per_octave = _number_of_frets_per_octave;
+        input.indices = indices;
+        fretboarder::points_at_frets(input, points);
+    }
+
     Point point_at_nut() const {
         return Point(x_at_start(), y_at_start());
     }
@@ -190,21 +350,26 @@ public:
 
     // Accessors:
     int index() const { return _index; }
-    double scale_length() const { return _scale_length; }
-    double perpendicular_fret_index() const { return _perpendicular_fret_index; }
-    double perpendicular_fret_from_start() const { return _perpendicular_fret_from_start; }
-    double x_at_start() const { return _x_offset + _x_at_start; }
-    double x_at_nut() const { return _x_offset + _x_at_nut; }
-    double y_at_start() const { return _y_at_start; }
-    double x_at_bridge() const { return _x_offset + _x_at_bridge; }
-    double y_at_bridge() const { return _y_at_bridge; }
+    T scale_length() const { return _scale_length; }
+    T perpendicular_fret_index() const { return _perpendicular_fret_index; }
+    T perpendicular_fret_from_start() const { return _perpendicular_fret_from_start; }
+    T x_at_start() const { return _x_offset + _x_at_start; }
+    T x_at_nut() const { return _x_offset + _x_at_nut; }
+    T y_at_start() const { return _y_at_start; }
+    T x_at_bridge() const { return _x_offset + _x_at_bridge; }
+    T y_at_bridge() const { return _y_at_bridge; }
     double number_of_frets_per_octave() const { return _number_of_frets_per_octave; }
-    double nut_to_zero_fret_offset() const { return _nut_to_zero_fret_offset; }
+    const FretRatioTable* ratios() const { return _ratios; }
+    bool is_tempered() const { return _tempered; }
+    T nut_to_zero_fret_offset() const { return _nut_to_zero_fret_offset; }
 
-    double x_offset() const { return _x_offset; }
-    void set_x_offset(double v) { _x_offset = v; }
+    T x_offset() const { return _x_offset; }
+    void set_x_offset(T v) { _x_offset = v; }
 };
 
+// The strings of a Fretboard
+typedef BasicString<double> String;
+
 } // namespace
     
 #endif /* string_hpp */
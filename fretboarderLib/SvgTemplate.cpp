@@ -0,0 +1,402 @@
+//
+//  SvgTemplate.cpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include "SvgTemplate.hpp"
+
+namespace fretboarder {
+
+namespace {
+
+// Longest number written by write_number()
+const size_t max_number_length = 24;
+// Longest point written by write_point(), with its command
+const size_t max_point_length = 2 * max_number_length + 4;
+// Room for everything on a page but the drawing
+const size_t max_page_length = 4096;
+
+const char* svg_style =
+    "<style>"
+    "path,circle{fill:none;stroke:#000;stroke-width:0.25}"
+    ".strings{stroke:#777;stroke-width:0.15}"
+    ".center{stroke:#c00;stroke-width:0.15;stroke-dasharray:6 1.5 1.5 1.5}"
+    ".frets{stroke-width:0.2}"
+    ".marks path,.marks circle{stroke-width:0.1}"
+    "text{font-family:Helvetica,Arial,sans-serif;text-anchor:middle;dominant-baseline:central}"
+    "</style>\n";
+
+char* write_text(char* p, const char* text) {
+    size_t size = strlen(text);
+    memcpy(p, text, size);
+    return p + size;
+}
+
+char* write_integer(char* p, long long value) {
+    if (value < 0) {
+        *p++ = '-';
+        value = -value;
+    }
+    char digits[24];
+    size_t n = 0;
+    do {
+        digits[n++] = char('0' + value % 10);
+        value /= 10;
+    } while (value);
+    while (n) {
+        *p++ = digits[--n];
+    }
+    return p;
+}
+
+// To the thousandth of a mm, more than any printer can do, and much shorter than the shortest round trip.
+char* write_number(char* p, double value) {
+    if (!std::isfinite(value)) {
+        value = 0;
+    }
+    long long thousandths = llround(std::max(-1e12, std::min(1e12, value)) * 1000);
+    if (thousandths < 0) {
+        *p++ = '-';
+        thousandths = -thousandths;
+    }
+    p = write_integer(p, thousandths / 1000);
+    int fraction = int(thousandths % 1000);
+    if (fraction) {
+        *p++ = '.';
+        *p++ = char('0' + fraction / 100);
+        fraction %= 100;
+        if (fraction) {
+            *p++ = char('0' + fraction / 10);
+            fraction %= 10;
+            if (fraction) {
+                *p++ = char('0' + fraction);
+            }
+        }
+    }
+    return p;
+}
+
+char* write_point(char* p, char command, const Point& point) {
+    *p++ = command;
+    p = write_number(p, point.x);
+    *p++ = ',';
+    return write_number(p, point.y);
+}
+
+char* write_attribute(char* p, const char* name, double value) {
+    *p++ = ' ';
+    p = write_text(p, name);
+    *p++ = '=';
+    *p++ = '"';
+    p = write_number(p, value);
+    *p++ = '"';
+    return p;
+}
+
+char* write_closed_path(char* p, const char* style, const Quad& quad) {
+    p = write_text(p, "<path class=\"");
+    p = write_text(p, style);
+    p = write_text(p, "\" d=\"");
+    for (int i = 0; i < 4; i++) {
+        p = write_point(p, i ? 'L' : 'M', quad.points[i]);
+    }
+    return write_text(p, "Z\"/>\n");
+}
+
+struct Extents {
+    Point min = Point(HUGE_VAL, HUGE_VAL);
+    Point max = Point(-HUGE_VAL, -HUGE_VAL);
+
+    void add(const Point& p, double dx = 0, double dy = 0) {
+        min = Point(std::min(min.x, p.x - dx), std::min(min.y, p.y - dy));
+        max = Point(std::max(max.x, p.x + dx), std::max(max.y, p.y + dy));
+    }
+};
+
+// Pages needed to cover size with pages of printable size overlapping by overlap.
+int tile_count(double size, double printable, double overlap) {
+    if (size <= printable) {
+        return 1;
+    }
+    return int(std::ceil((size - overlap) / (printable - overlap)));
+}
+
+}
+
+void SvgTemplate::generate(const Fretboard& fretboard, const SvgTemplateOptions& options) {
+    const double scale = options.scale;
+    const double font_size = options.font_size;
+    // SVG goes down, the fretboard up
+    auto to_page = [&](const Point& p) { return Point(p.x * scale, -p.y * scale); };
+    auto to_page_quad = [&](const Quad& quad) {
+        Quad result;
+        for (int i = 0; i < 4; i++) {
+            result.points[i] = to_page(quad.points[i]);
+        }
+        return result;
+    };
+
+    const auto& strings = fretboard.strings();
+    auto lines = fretboard.fret_lines();
+    bool curved = fretboard.has_curved_frets();
+    const FretPolylines& polylines = fretboard.fret_polylines();
+    Quad board = to_page_quad(fretboard.board_shape());
+    Quad nut = to_page_quad(fretboard.nut_shape());
+
+    // Fret numbers past the end of the frets on the side of the first border
+    auto number_position = [&](size_t i) {
+        Point a = to_page(lines[i].point1);
+        Point b = to_page(lines[i].point2);
+        if (a.y > b.y) {
+            std::swap(a, b);
+        }
+        Point direction = b - a;
+        double length = std::sqrt(direction.x * direction.x + direction.y * direction.y);
+        direction = length > 0 ? direction * (1 / length) : Point(0, 1);
+        return b + direction * (font_size * 0.75 + 1);
+    };
+    int first_number = fretboard.instrument().has_zero_fret ? 0 : 1;
+
+    Extents extents;
+    for (const Quad* quad : { &board, &nut }) {
+        for (const Point& p : quad->points) {
+            extents.add(p);
+        }
+    }
+    for (const String& string : strings) {
+        extents.add(to_page(string.point_at_nut()));
+        extents.add(to_page(string.point_at_bridge()));
+    }
+    for (size_t i = 0; i < lines.size(); i++) {
+        extents.add(number_position(i), font_size, font_size / 2);
+    }
+    if (extents.min.x > extents.max.x) {
+        extents = Extents();
+        extents.add(Point());
+    }
+
+    // The drawing, in mm
+    size_t points = 4 + 4 + 2 + strings.size() * 2 + (curved ? polylines.points().size() : lines.size() * 2);
+    size_t bound = 512 + points * max_point_length + lines.size() * (64 + 2 * max_number_length);
+    if (_drawing.size() < bound) {
+        _drawing.resize(bound);
+    }
+    char* p = _drawing.data();
+    p = write_closed_path(p, "board", board);
+    p = write_closed_path(p, "nut", nut);
+
+    if (!strings.empty()) {
+        // Through the middle of the outer strings, across the whole drawing
+        Point at_nut = to_page((strings.front().point_at_nut() + strings.back().point_at_nut()) * 0.5);
+        Point at_bridge = to_page((strings.front().point_at_bridge() + strings.back().point_at_bridge()) * 0.5);
+        if (std::abs(at_bridge.x - at_nut.x) > 1e-9) {
+            double slope = (at_bridge.y - at_nut.y) / (at_bridge.x - at_nut.x);
+            at_bridge = Point(extents.max.x, at_nut.y + (extents.max.x - at_nut.x) * slope);
+            at_nut = Point(extents.min.x, at_nut.y + (extents.min.x - at_nut.x) * slope);
+        }
+        p = write_text(p, "<path class=\"center\" d=\"");
+        p = write_point(p, 'M', at_nut);
+        p = write_point(p, 'L', at_bridge);
+        p = write_text(p, "\"/>\n");
+
+        p = write_text(p, "<path class=\"strings\" d=\"");
+        for (const String& string : strings) {
+            p = write_point(p, 'M', to_page(string.point_at_nut()));
+            p = write_point(p, 'L', to_page(string.point_at_bridge()));
+        }
+        p = write_text(p, "\"/>\n");
+    }
+
+    p = write_text(p, "<path class=\"frets\" d=\"");
+    if (curved) {
+        for (size_t i = 0; i < polylines.size(); i++) {
+            auto polyline = polylines[i];
+            for (size_t j = 0; j < polyline.size(); j++) {
+                p = write_point(p, j ? 'L' : 'M', to_page(polyline[j]));
+            }
+        }
+    } else {
+        for (size_t i = 0; i < lines.size(); i++) {
+            p = write_point(p, 'M', to_page(lines[i].point1));
+            p = write_point(p, 'L', to_page(lines[i].point2));
+        }
+    }
+    p = write_text(p, "\"/>\n");
+
+    p = write_text(p, "<g class=\"numbers\"");
+    p = write_attribute(p, "font-size", font_size);
+    p = write_text(p, ">\n");
+    for (size_t i = 0; i < lines.size(); i++) {
+        Point position = number_position(i);
+        p = write_text(p, "<text");
+        p = write_attribute(p, "x", position.x);
+        p = write_attribute(p, "y", position.y);
+        *p++ = '>';
+        p = write_integer(p, first_number + (long long)i);
+        p = write_text(p, "</text>\n");
+    }
+    p = write_text(p, "</g>\n");
+    size_t drawing_size = p - _drawing.data();
+
+    // Tiling, on the orientation needing the fewest pages
+    double paper_width = options.paper_size == PaperSize::letter ? 215.9 : 210;
+    double paper_height = options.paper_size == PaperSize::letter ? 279.4 : 297;
+    double margin = std::max(0.0, std::min(options.margin, std::min(paper_width, paper_height) / 4));
+    double width = extents.max.x - extents.min.x;
+    double height = extents.max.y - extents.min.y;
+    auto tiles = [&](double paper_width, double paper_height, double overlap, int& columns, int& rows) {
+        columns = tile_count(width, paper_width - 2 * margin, overlap);
+        rows = tile_count(height, paper_height - 2 * margin, overlap);
+    };
+    double overlap = std::max(0.0, std::min(options.overlap, (std::min(paper_width, paper_height) - 2 * margin) / 2));
+    int portrait_columns, portrait_rows, landscape_columns, landscape_rows;
+    tiles(paper_width, paper_height, overlap, portrait_columns, portrait_rows);
+    tiles(paper_height, paper_width, overlap, landscape_columns, landscape_rows);
+    int portrait_pages = portrait_columns * portrait_rows;
+    int landscape_pages = landscape_columns * landscape_rows;
+    _landscape = landscape_pages < portrait_pages || (landscape_pages == portrait_pages && width > height);
+    if (_landscape) {
+        std::swap(paper_width, paper_height);
+    }
+    _columns = _landscape ? landscape_columns : portrait_columns;
+    _rows = _landscape ? landscape_rows : portrait_rows;
+
+    // The drawing is centered on the area covered by the pages
+    double printable_width = paper_width - 2 * margin;
+    double printable_height = paper_height - 2 * margin;
+    double step_x = printable_width - overlap;
+    double step_y = printable_height - overlap;
+    Point origin(extents.min.x - (_columns * step_x + overlap - width) / 2,
+                 extents.min.y - (_rows * step_y + overlap - height) / 2);
+
+    size_t pages = page_count();
+    bound = pages * (drawing_size + max_page_length);
+    if (_pages.size() < bound) {
+        _pages.resize(bound);
+    }
+    _offsets.resize(pages + 1);
+
+    p = _pages.data();
+    for (int row = 0; row < _rows; row++) {
+        for (int column = 0; column < _columns; column++) {
+            _offsets[row * _columns + column] = p - _pages.data();
+
+            p = write_text(p, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"");
+            p = write_number(p, paper_width);
+            p = write_text(p, "mm\" height=\"");
+            p = write_number(p, paper_height);
+            p = write_text(p, "mm\" viewBox=\"0 0 ");
+            p = write_number(p, paper_width);
+            *p++ = ' ';
+            p = write_number(p, paper_height);
+            p = write_text(p, "\">\n");
+            p = write_text(p, svg_style);
+
+            p = write_text(p, "<clipPath id=\"printable\"><rect");
+            p = write_attribute(p, "x", margin);
+            p = write_attribute(p, "y", margin);
+            p = write_attribute(p, "width", printable_width);
+            p = write_attribute(p, "height", printable_height);
+            p = write_text(p, "/></clipPath>\n<g clip-path=\"url(#printable)\"><g transform=\"translate(");
+            p = write_number(p, margin - origin.x - column * step_x);
+            *p++ = ',';
+            p = write_number(p, margin - origin.y - row * step_y);
+            p = write_text(p, ")\">\n");
+            memcpy(p, _drawing.data(), drawing_size);
+            p += drawing_size;
+            p = write_text(p, "</g></g>\n");
+
+            // At the same place on the drawing on the pages sharing a corner
+            p = write_text(p, "<g class=\"marks\">\n");
+            double inset = margin + overlap / 2;
+            double radius = std::max(1.0, overlap * 0.3);
+            for (int corner = 0; corner < 4; corner++) {
+                Point center(corner & 1 ? paper_width - inset : inset, corner & 2 ? paper_height - inset : inset);
+                p = write_text(p, "<circle");
+                p = write_attribute(p, "cx", center.x);
+                p = write_attribute(p, "cy", center.y);
+                p = write_attribute(p, "r", radius);
+                p = write_text(p, "/><path d=\"");
+                p = write_point(p, 'M', Point(center.x - 2 * radius, center.y));
+                *p++ = 'h';
+                p = write_number(p, 4 * radius);
+                p = write_point(p, 'M', Point(center.x, center.y - 2 * radius));
+                *p++ = 'v';
+                p = write_number(p, 4 * radius);
+                p = write_text(p, "\"/>\n");
+            }
+            p = write_text(p, "</g>\n");
+
+            // Which page it is in the top margin, the ruler in the bottom one
+            p = write_text(p, "<text font-size=\"3\" style=\"text-anchor:start\"");
+            p = write_attribute(p, "x", margin);
+            p = write_attribute(p, "y", margin / 2);
+            p = write_text(p, ">Page ");
+            p = write_integer(p, row * _columns + column + 1);
+            *p++ = '/';
+            p = write_integer(p, (long long)pages);
+            p = write_text(p, ", row ");
+            p = write_integer(p, row + 1);
+            p = write_text(p, ", column ");
+            p = write_integer(p, column + 1);
+            p = write_text(p, "</text>\n");
+            double ruler_y = paper_height - margin / 2;
+            p = write_text(p, "<path d=\"");
+            p = write_point(p, 'M', Point(margin, ruler_y));
+            p = write_text(p, "h50");
+            p = write_point(p, 'M', Point(margin, ruler_y - 1.5));
+            p = write_text(p, "v3");
+            p = write_point(p, 'M', Point(margin + 50, ruler_y - 1.5));
+            p = write_text(p, "v3\"/>\n<text font-size=\"3\" style=\"text-anchor:start\"");
+            p = write_attribute(p, "x", margin + 52);
+            p = write_attribute(p, "y", ruler_y);
+            p = write_text(p, ">50 mm at 100%</text>\n</svg>\n");
+        }
+    }
+    _offsets[pages] = p - _pages.data();
+}
+
+bool SvgTemplate::save(const std::string& prefix) const {
+    for (int row = 0; row < _rows; row++) {
+        for (int column = 0; column < _columns; column++) {
+            std::ofstream ofs(prefix + "-" + std::to_string(row + 1) + "-" + std::to_string(column + 1) + ".svg",
+                              std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+            std::string_view svg = page(row * _columns + column);
+            ofs.write(svg.data(), svg.size());
+            if (!ofs) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void generate_svg_templates(const FretboardBatch& fretboards, SvgTemplateBatch& output,
+                            const SvgTemplateOptions& options, ThreadPool& pool) {
+    // Templates are only added: the ones past the end of this batch keep their buffers for the next one
+    if (output._templates.size() < fretboards.size()) {
+        output._templates.resize(fretboards.size());
+    }
+    output._size = fretboards.size();
+
+    size_t grain = std::min<size_t>(16, std::max<size_t>(1, fretboards.size() / (pool.thread_count() * 8)));
+    pool.parallel_for(fretboards.size(), grain, [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; i++) {
+            output._templates[i].generate(fretboards[i], options);
+        }
+    });
+}
+
+void generate_svg_templates(const FretboardBatch& fretboards, SvgTemplateBatch& output,
+                            const SvgTemplateOptions& options) {
+    generate_svg_templates(fretboards, output, options, ThreadPool::shared());
+}
+
+}
@@ -0,0 +1,100 @@
+//
+//  SvgTemplate.hpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+#ifndef svg_template_hpp
+#define svg_template_hpp
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Fretboard.hpp"
+#include "FretboardBatch.hpp"
+#include "ThreadPool.hpp"
+
+namespace fretboarder {
+
+enum class PaperSize {
+    a4,
+    letter
+};
+
+struct SvgTemplateOptions {
+    PaperSize paper_size = PaperSize::a4;
+    // Millimeters per unit of the fretboard, see DxfOptions
+    double scale = 10;
+    // Blank around each page, printers don't print up to the edges (mm)
+    double margin = 10;
+    // Printed on both pages where they meet, the registration marks are in the middle of it (mm)
+    double overlap = 12;
+    // Height of the fret numbers (mm)
+    double font_size = 4;
+};
+
+// Full scale template of a fretboard, to be printed at 100% and taped together: the board, the nut, the frets and
+// their numbers, the strings from the nut to the bridge and the centerline of the neck, tiled on as few pages as
+// possible, portrait or landscape. Each page is a complete SVG document sized in mm. Registration marks are at the
+// corners of the printable area of the pages, inside the overlaps: the marks of neighbouring pages are the same
+// marks, put them on top of each other. The bottom margin has a 50 mm ruler to check the print scale.
+//
+// The drawing is formatted once and copied on every page. Generating another template reuses the buffers: once they
+// have grown to the largest one, generating doesn't allocate.
+class SvgTemplate {
+public:
+    SvgTemplate() {}
+
+    void generate(const Fretboard& fretboard, const SvgTemplateOptions& options = SvgTemplateOptions());
+
+    int rows() const { return _rows; }
+    int columns() const { return _columns; }
+    bool is_landscape() const { return _landscape; }
+
+    // Pages row after row, page(row * columns() + column).
+    size_t page_count() const { return size_t(_rows) * size_t(_columns); }
+    std::string_view page(size_t i) const {
+        return std::string_view(_pages.data() + _offsets[i], _offsets[i + 1] - _offsets[i]);
+    }
+
+    // Writes each page to prefix-<row>-<column>.svg, counted from 1. False if a page couldn't be written.
+    bool save(const std::string& prefix) const;
+
+private:
+    std::vector<char> _drawing;
+    std::vector<char> _pages;
+    std::vector<size_t> _offsets;
+    int _rows = 0;
+    int _columns = 0;
+    bool _landscape = false;
+};
+
+// Templates generated by generate_svg_templates(), in the order of the fretboards they were generated from. Reusing
+// a batch reuses the buffers of its templates.
+class SvgTemplateBatch {
+public:
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+    const SvgTemplate& operator[](size_t i) const { return _templates[i]; }
+
+private:
+    friend void generate_svg_templates(const FretboardBatch& fretboards, SvgTemplateBatch& output,
+                                       const SvgTemplateOptions& options, ThreadPool& pool);
+
+    std::vector<SvgTemplate> _templates;
+    size_t _size = 0;
+};
+
+// Generates the template of every fretboard in parallel on pool, output[i] being the template of fretboards[i].
+void generate_svg_templates(const FretboardBatch& fretboards, SvgTemplateBatch& output,
+                            const SvgTemplateOptions& options, ThreadPool& pool);
+
+// Same, on the shared pool.
+void generate_svg_templates(const FretboardBatch& fretboards, SvgTemplateBatch& output,
+                            const SvgTemplateOptions& options = SvgTemplateOptions());
+
+}
+
+#endif /* svg_template_hpp */
@@ -0,0 +1,211 @@
+//
+//  Sweep.cpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include "Arena.hpp"
+#include "LayoutOptimizer.hpp"
+#include "Sweep.hpp"
+
+namespace fretboarder {
+
+static const char* metric_columns[] = {
+    "construction_distance_at_nut_side",
+    "construction_distance_at_heel",
+    "construction_distance_at_nut",
+    "construction_distance_at_last_fret",
+    "construction_distance_at_12th_fret",
+    "construction_distance_at_octave",
+    "board_x0", "board_y0", "board_x1", "board_y1", "board_x2", "board_y2", "board_x3", "board_y3",
+    "max_fret_angle",
+    "nut_width",
+    // 1 if the fretboard is valid (see Fretboard::is_valid()), 0 if not. Its metrics are NaN when the instrument
+    // isn't buildable.
+    "valid"
+};
+
+enum { metric_count = sizeof(metric_columns) / sizeof(metric_columns[0]) };
+
+bool CsvSweepWriter::begin(const std::vector<std::string>& columns) {
+    _column_count = columns.size();
+    for (size_t c = 0; c < columns.size(); c++) {
+        _stream << (c ? "," : "") << columns[c];
+    }
+    _stream << "\n";
+    return bool(_stream);
+}
+
+bool CsvSweepWriter::write(size_t rows, Span<const double> chunk) {
+    // Enough for the longest %.17g, and the separator
+    const size_t max_value_length = 26;
+    _buffer.resize(rows * _column_count * max_value_length + rows);
+
+    char* p = _buffer.data();
+    for (size_t row = 0; row < rows; row++) {
+        for (size_t c = 0; c < _column_count; c++) {
+            if (c) {
+                *p++ = ',';
+            }
+            p += snprintf(p, max_value_length, "%.17g", chunk[c * rows + row]);
+        }
+        *p++ = '\n';
+    }
+    _stream.write(_buffer.data(), p - _buffer.data());
+    return bool(_stream);
+}
+
+bool CsvSweepWriter::end() {
+    _stream.flush();
+    return bool(_stream);
+}
+
+template <class T>
+static void write_value(std::ostream& stream, T value) {
+    // Only little endian machines are supported by the add-in
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+bool ColumnarSweepWriter::begin(const std::vector<std::string>& columns) {
+    _stream.write("FRTSWEEP", 8);
+    write_value<uint32_t>(_stream, 1);
+    write_value<uint32_t>(_stream, uint32_t(columns.size()));
+    for (const auto& column : columns) {
+        write_value<uint32_t>(_stream, uint32_t(column.size()));
+        _stream.write(column.data(), column.size());
+    }
+    return bool(_stream);
+}
+
+bool ColumnarSweepWriter::write(size_t rows, Span<const double> chunk) {
+    write_value<uint64_t>(_stream, rows);
+    _stream.write(reinterpret_cast<const char*>(chunk.data()), chunk.size() * sizeof(double));
+    return bool(_stream);
+}
+
+bool ColumnarSweepWriter::end() {
+    write_value<uint64_t>(_stream, 0);
+    _stream.flush();
+    return bool(_stream);
+}
+
+bool Sweep::add_axis(const std::string& name, double min, double max, int steps, int element) {
+    const InstrumentField* field = find_instrument_field(name);
+    if (!field || field->type == InstrumentFieldType::temperament || element < 0 || element >= field->count
+        || steps < 1) {
+        return false;
+    }
+    _axes.push_back({ field, element, min, max, steps });
+    return true;
+}
+
+size_t Sweep::size() const {
+    size_t size = 1;
+    for (const auto& axis : _axes) {
+        size *= axis.steps;
+    }
+    return size;
+}
+
+Instrument Sweep::instrument(size_t point) const {
+    Instrument instrument = _base;
+    for (size_t a = _axes.size(); a-- > 0;) {
+        const Axis& axis = _axes[a];
+        axis.field->set(instrument, axis.value(point % axis.steps), axis.element);
+        point /= axis.steps;
+    }
+    instrument.validate();
+    return instrument;
+}
+
+std::vector<std::string> Sweep::columns() const {
+    std::vector<std::string> columns;
+    for (const auto& axis : _axes) {
+        std::string name = axis.field->name;
+        if (axis.field->count > 1) {
+            name += "[" + std::to_string(axis.element) + "]";
+        }
+        columns.push_back(name);
+    }
+    for (const char* metric : metric_columns) {
+        columns.push_back(metric);
+    }
+    return columns;
+}
+
+bool Sweep::run(SweepWriter& writer, ThreadPool& pool, size_t chunk_size) const {
+    const size_t size = this->size();
+    const size_t column_count = _axes.size() + metric_count;
+    chunk_size = std::max<size_t>(1, std::min(chunk_size, size));
+
+    std::vector<std::unique_ptr<Arena>> arenas;
+    for (size_t worker = 0; worker < pool.thread_count(); worker++) {
+        arenas.emplace_back(new Arena());
+    }
+    std::vector<double> chunk(chunk_size * column_count);
+
+    if (!writer.begin(columns())) {
+        return false;
+    }
+
+    for (size_t first = 0; first < size; first += chunk_size) {
+        const size_t rows = std::min(chunk_size, size - first);
+
+        pool.parallel_for(rows, 16, [&](size_t begin, size_t end, size_t worker) {
+            Arena& arena = *arenas[worker];
+            for (size_t row = begin; row < end; row++) {
+                Instrument instrument = this->instrument(first + row);
+                double values[metric_count];
+                if (!instrument.is_buildable()) {
+                    std::fill(values, values + metric_count - 1, NAN);
+                    values[metric_count - 1] = 0;
+                } else {
+                    arena.reset();
+                    Fretboard fretboard(instrument, arena);
+                    LayoutMetrics metrics = measure_layout(fretboard);
+                    const Quad& board = fretboard.board_shape();
+                    double* v = values;
+                    *v++ = fretboard.construction_distance_at_nut_side();
+                    *v++ = fretboard.construction_distance_at_heel();
+                    *v++ = fretboard.construction_distance_at_nut();
+                    *v++ = fretboard.construction_distance_at_last_fret();
+                    *v++ = fretboard.construction_distance_at_12th_fret();
+                    *v++ = fretboard.construction_distance_at_octave();
+                    for (const Point& corner : board.points) {
+                        *v++ = corner.x;
+                        *v++ = corner.y;
+                    }
+                    *v++ = metrics.max_fret_angle;
+                    *v++ = metrics.nut_width;
+                    *v++ = fretboard.is_valid() ? 1 : 0;
+                }
+
+                size_t c = 0;
+                for (const auto& axis : _axes) {
+                    chunk[c++ * rows + row] = axis.field->get(instrument, axis.element);
+                }
+                for (double value : values) {
+                    chunk[c++ * rows + row] = value;
+                }
+            }
+        });
+
+        if (!writer.write(rows, Span<const double>(chunk.data(), rows * column_count))) {
+            return false;
+        }
+    }
+
+    return writer.end();
+}
+
+bool Sweep::run(SweepWriter& writer, size_t chunk_size) const {
+    return run(writer, ThreadPool::shared(), chunk_size);
+}
+
+}
@@ -0,0 +1,105 @@
+//
+//  Sweep.hpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+#ifndef sweep_hpp
+#define sweep_hpp
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include "Fretboard.hpp"
+#include "ThreadPool.hpp"
+
+namespace fretboarder {
+
+// Receives the results of a Sweep chunk by chunk. A chunk is stored column after column: rows values of the
+// first column, then rows values of the second one, etc.
+class SweepWriter {
+public:
+    virtual ~SweepWriter() {}
+
+    virtual bool begin(const std::vector<std::string>& columns) = 0;
+    virtual bool write(size_t rows, Span<const double> chunk) = 0;
+    virtual bool end() = 0;
+};
+
+// One line per point, with a header line naming the columns.
+class CsvSweepWriter : public SweepWriter {
+public:
+    explicit CsvSweepWriter(std::ostream& stream) : _stream(stream) {}
+
+    bool begin(const std::vector<std::string>& columns) override;
+    bool write(size_t rows, Span<const double> chunk) override;
+    bool end() override;
+
+private:
+    std::ostream& _stream;
+    size_t _column_count = 0;
+    std::vector<char> _buffer;
+};
+
+// Binary columnar file, all little endian:
+//   "FRTSWEEP", uint32 version (1), uint32 column count, then for each column an uint32 length and its name,
+//   then chunks: uint64 row count followed by the doubles of each column one after the other,
+//   and a last chunk of 0 rows.
+class ColumnarSweepWriter : public SweepWriter {
+public:
+    explicit ColumnarSweepWriter(std::ostream& stream) : _stream(stream) {}
+
+    bool begin(const std::vector<std::string>& columns) override;
+    bool write(size_t rows, Span<const double> chunk) override;
+    bool end() override;
+
+private:
+    std::ostream& _stream;
+};
+
+// Evaluates the fretboard of every combination of values of some fields of an instrument and streams metrics
+// about each one to a SweepWriter. Points are evaluated in parallel one chunk at a time, so the memory used
+// doesn't depend on the size of the sweep, and written in order.
+class Sweep {
+public:
+    explicit Sweep(const Instrument& base) : _base(base) {}
+
+    // Sweeps an element of a field of Instrument (see instrument_fields()) over steps values evenly spread over
+    // [min, max]. The first axis added varies the slowest. Fields derived by Instrument::validate() (string spacings
+    // and y_at_*) are overwritten by it, sweep the inter string spacings instead. Points where the instrument isn't
+    // buildable (see Instrument::is_buildable()) aren't built, their metrics are NaN.
+    // Returns false if there's no such field or element, or if the field isn't a number (temperament).
+    bool add_axis(const std::string& field, double min, double max, int steps, int element = 0);
+
+    // Number of points of the sweep.
+    size_t size() const;
+
+    // Instrument evaluated at a point.
+    Instrument instrument(size_t point) const;
+
+    // Value of every axis, then the metrics of the fretboard.
+    std::vector<std::string> columns() const;
+
+    bool run(SweepWriter& writer, ThreadPool& pool, size_t chunk_size = 4096) const;
+    bool run(SweepWriter& writer, size_t chunk_size = 4096) const;
+
+private:
+    struct Axis {
+        const InstrumentField* field;
+        int element;
+        double min;
+        double max;
+        int steps;
+
+        double value(size_t step) const { return steps > 1 ? min + (max - min) * double(step) / (steps - 1) : min; }
+    };
+
+    Instrument _base;
+    std::vector<Axis> _axes;
+};
+
+}
+
+#endif /* sweep_hpp */
@@ -0,0 +1,96 @@
+//
+//  Temperament.cpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+#include <algorithm>
+#include <cassert>
+#include "Temperament.hpp"
+
+namespace fretboarder {
+
+namespace {
+
+// First octave of equal divisions, the others are derived from it like in the shared tables
+std::vector<double> equal_octave(int frets_per_octave) {
+    std::vector<double> octave(frets_per_octave);
+    for (int note = 0; note < frets_per_octave; note++) {
+        octave[note] = pow(2, -double(note) / frets_per_octave);
+    }
+    return octave;
+}
+
+}
+
+Temperament::Temperament(int frets_per_octave)
+: Temperament(equal_octave(std::max(1, frets_per_octave)), std::max(1, frets_per_octave)) {
+    // Same ratios as the untempered strings, when there is a shared table for them
+    if (const FretRatioTable* equal = FretRatioTable::get(_frets_per_octave)) {
+        for (size_t i = 0; i < _ratios.size(); i++) {
+            _ratios[i] = equal->ratio(equal->first_index() + int(i));
+        }
+    }
+}
+
+Temperament::Temperament(const std::vector<double>& octave, int frets_per_octave)
+: _frets_per_octave(frets_per_octave) {
+    int first = -FretRatioTable::octaves_below * frets_per_octave;
+    _ratios.resize(table_size());
+    for (size_t i = 0; i < _ratios.size(); i++) {
+        int octave_index = (int(i) + first) / frets_per_octave;
+        int note = (int(i) + first) % frets_per_octave;
+        if (note < 0) {
+            note += frets_per_octave;
+            octave_index--;
+        }
+        _ratios[i] = ldexp(octave[note], -octave_index);
+    }
+    update_tables();
+}
+
+Temperament Temperament::just(const std::vector<double>& ratios) {
+    // Lengths are inversely proportional to frequencies
+    std::vector<double> octave(ratios.size() + 1);
+    octave[0] = 1;
+    for (size_t i = 0; i < ratios.size(); i++) {
+        assert(ratios[i] > 1 && ratios[i] < 2 && (i == 0 || ratios[i] > ratios[i - 1]));
+        octave[i + 1] = 1 / ratios[i];
+    }
+    return Temperament(octave, int(octave.size()));
+}
+
+void Temperament::set_offsets(int string, const std::vector<double>& cents) {
+    assert(string >= 0);
+    if (size_t(string) >= _string_tables.size()) {
+        _string_tables.resize(string + 1, 0);
+    }
+
+    size_t size = table_size();
+    if (_string_tables[string] == 0) {
+        _string_tables[string] = _ratios.size() / size;
+        _ratios.resize(_ratios.size() + size);
+    }
+
+    // Start over from the shared table so that offsets don't accumulate
+    double* ratios = _ratios.data() + _string_tables[string] * size;
+    std::copy(_ratios.begin(), _ratios.begin() + size, ratios);
+    size_t nut = size_t(FretRatioTable::octaves_below * _frets_per_octave);
+    for (size_t fret = 0; fret < cents.size() && nut + fret < size; fret++) {
+        // A note higher by c cents has a length shorter by 2^(-c / 1200)
+        ratios[nut + fret] *= pow(2, -cents[fret] / 1200);
+    }
+    update_tables();
+}
+
+void Temperament::update_tables() {
+    size_t size = table_size();
+    _tables.clear();
+    for (size_t i = 0; i < _ratios.size(); i += size) {
+        _tables.push_back(FretRatioTable(_frets_per_octave, _ratios.data() + i));
+    }
+}
+
+}
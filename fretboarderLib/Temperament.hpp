@@ -0,0 +1,73 @@
+//
+//  Temperament.hpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+#ifndef temperament_hpp
+#define temperament_hpp
+
+#include <vector>
+#include "String.hpp"
+
+namespace fretboarder {
+
+// Where the frets go on each string when they are not the plain equal temperament of Instrument: any number of equal
+// divisions of the octave, just intonation ratios, and per string per fret offsets in cents (True Temperament style).
+// Everything is precomputed in FretRatioTables, one per string with offsets and one shared by the others, so that the
+// strings built with them (see Instrument::temperament) find the position of a fret in O(1) like in equal temperament.
+// Fractional fret indices are not tempered and stay equally spaced.
+//
+// The tables point into the temperament: it can be moved but not copied.
+class Temperament {
+public:
+    // frets_per_octave equal divisions of the octave, at least 1. Same ratios as the untempered strings up to
+    // FretRatioTable::max_frets_per_octave, computed here past it.
+    explicit Temperament(int frets_per_octave = 12);
+
+    // Just intonation, ratios being the frequency ratios between the notes of the frets of an octave and its first
+    // note, increasing in (1, 2): {9/8, 5/4, 4/3, 3/2, 5/3, 15/8} is a diatonic major scale with 7 frets per octave.
+    // The other octaves repeat the first one.
+    static Temperament just(const std::vector<double>& ratios);
+
+    Temperament(Temperament&&) = default;
+    Temperament& operator =(Temperament&&) = default;
+    Temperament(const Temperament&) = delete;
+    Temperament& operator =(const Temperament&) = delete;
+
+    int frets_per_octave() const { return _frets_per_octave; }
+    // True if some strings have offsets, their frets don't line up anymore.
+    bool has_offsets() const { return _tables.size() > 1; }
+
+    // Offsets of the frets of a string in cents, cents[0] being for the zero fret: positive offsets raise the note and
+    // move the fret towards the bridge. Frets past the end of cents, and those below the nut, aren't offset.
+    void set_offsets(int string, const std::vector<double>& cents);
+
+    // Ratio table of a string, see BasicString. Strings without offsets share the same table.
+    const FretRatioTable* table(int string) const {
+        size_t i = string >= 0 && size_t(string) < _string_tables.size() ? _string_tables[string] : 0;
+        return &_tables[i];
+    }
+
+    // Ratio between the vibrating length of string at fret_index and its scale length.
+    double ratio(int string, int fret_index) const { return table(string)->ratio(fret_index); }
+
+private:
+    explicit Temperament(const std::vector<double>& octave, int frets_per_octave);
+    // Ratio count of a table
+    size_t table_size() const { return size_t((FretRatioTable::octaves_below + FretRatioTable::octaves_above) * _frets_per_octave); }
+    void update_tables();
+
+    int _frets_per_octave;
+    // All the tables one after the other, the shared one first
+    std::vector<double> _ratios;
+    std::vector<FretRatioTable> _tables;
+    // Index in _tables of the table of each string, 0 for the shared one
+    std::vector<size_t> _string_tables;
+};
+
+}
+
+#endif /* temperament_hpp */
@@ -0,0 +1,162 @@
+//
+//  ThreadPool.cpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+#include <algorithm>
+#include "ThreadPool.hpp"
+
+namespace fretboarder {
+
+ThreadPool::ThreadPool(size_t thread_count) {
+    if (thread_count == 0) {
+        thread_count = hardware_thread_count();
+    }
+    _queues.reset(new Queue[thread_count]);
+    for (size_t worker = 1; worker < thread_count; worker++) {
+        _threads.emplace_back(&ThreadPool::thread_main, this, worker);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _wake.notify_all();
+    for (auto& thread : _threads) {
+        thread.join();
+    }
+}
+
+size_t ThreadPool::hardware_thread_count() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::parallel_for(size_t count, size_t grain, const Function& function) {
+    if (count == 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> run_lock(_run_mutex);
+
+    // Everybody starts with a contiguous share of the loop
+    size_t workers = thread_count();
+    for (size_t worker = 0; worker < workers; worker++) {
+        std::lock_guard<std::mutex> lock(_queues[worker].mutex);
+        _queues[worker].begin = count * worker / workers;
+        _queues[worker].end = count * (worker + 1) / workers;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _function = &function;
+        _grain = std::max<size_t>(1, grain);
+        _busy = _threads.size();
+        _exception = nullptr;
+        _generation++;
+    }
+    _wake.notify_all();
+
+    work(0);
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _done.wait(lock, [this]() { return _busy == 0; });
+    _function = nullptr;
+    if (_exception) {
+        std::exception_ptr exception = _exception;
+        _exception = nullptr;
+        std::rethrow_exception(exception);
+    }
+}
+
+void ThreadPool::thread_main(size_t worker) {
+    uint64_t generation = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _wake.wait(lock, [&]() { return _stop || _generation != generation; });
+            if (_stop) {
+                return;
+            }
+            generation = _generation;
+        }
+
+        work(worker);
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (--_busy == 0) {
+            _done.notify_one();
+        }
+    }
+}
+
+void ThreadPool::work(size_t worker) {
+    size_t begin, end;
+    for (;;) {
+        if (!pop(worker, begin, end)) {
+            // Nothing is ever added to the queues, if there's nothing left to steal we are done.
+            if (!steal(worker)) {
+                return;
+            }
+            continue;
+        }
+
+        try {
+            (*_function)(begin, end, worker);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (!_exception) {
+                _exception = std::current_exception();
+            }
+        }
+    }
+}
+
+bool ThreadPool::pop(size_t worker, size_t& begin, size_t& end) {
+    Queue& queue = _queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.begin == queue.end) {
+        return false;
+    }
+    begin = queue.begin;
+    end = std::min(queue.end, begin + _grain);
+    queue.begin = end;
+    return true;
+}
+
+bool ThreadPool::steal(size_t worker) {
+    size_t workers = thread_count();
+    for (size_t i = 1; i < workers; i++) {
+        Queue& victim = _queues[(worker + i) % workers];
+        size_t begin, end;
+        {
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            size_t remaining = victim.end - victim.begin;
+            if (remaining == 0) {
+                continue;
+            }
+            // Take the back half, the victim keeps going from the front
+            begin = victim.end - (remaining + 1) / 2;
+            end = victim.end;
+            victim.end = begin;
+        }
+
+        Queue& queue = _queues[worker];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.begin = begin;
+        queue.end = end;
+        return true;
+    }
+    return false;
+}
+
+}
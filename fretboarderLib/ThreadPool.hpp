@@ -0,0 +1,80 @@
+//
+//  ThreadPool.hpp
+//  Fretboarder
+//
+//  Created by Sebastien Metrot on 17/10/2026.
+//  Copyright © 2026 Autodesk. All rights reserved.
+//
+
+#ifndef thread_pool_hpp
+#define thread_pool_hpp
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fretboarder {
+
+// Fixed set of threads running parallel loops. Each worker starts with its own contiguous share of the loop and
+// steals half of the remaining share of another worker once it's done with its own, so that uneven items don't
+// leave workers idle. The thread calling parallel_for() is worker 0 and works too.
+class ThreadPool {
+public:
+    // 0 threads means one per hardware thread.
+    explicit ThreadPool(size_t thread_count = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Number of workers, including the calling thread.
+    size_t thread_count() const { return _threads.size() + 1; }
+
+    static size_t hardware_thread_count();
+
+    // Pool shared by the whole library, with one worker per hardware thread.
+    static ThreadPool& shared();
+
+    typedef std::function<void(size_t begin, size_t end, size_t worker)> Function;
+
+    // Calls function over every index of [0, count), grain indices (or less) at a time, and returns once all
+    // of them are done. The first exception thrown by function is rethrown here.
+    void parallel_for(size_t count, size_t grain, const Function& function);
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    void thread_main(size_t worker);
+    void work(size_t worker);
+    bool pop(size_t worker, size_t& begin, size_t& end);
+    bool steal(size_t worker);
+
+    std::vector<std::thread> _threads;
+    std::unique_ptr<Queue[]> _queues;
+
+    // Only one parallel_for at a time
+    std::mutex _run_mutex;
+
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+    const Function* _function = nullptr;
+    size_t _grain = 1;
+    uint64_t _generation = 0;
+    size_t _busy = 0;
+    bool _stop = false;
+    std::exception_ptr _exception;
+};
+
+}
+
+#endif /* thread_pool_hpp */
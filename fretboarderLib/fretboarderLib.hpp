@@ -14,7 +14,23 @@
 
 #include "Fretboard.hpp"
 #include "String.hpp"
+#include "Temperament.hpp"
 #include "Geometry.hpp"
+#include "Dual.hpp"
+#include "Arena.hpp"
+#include "FretTable.hpp"
+#include "FretPolylines.hpp"
+#include "FretboardBatch.hpp"
+#include "FretboardBuilder.hpp"
+#include "FretboardLocator.hpp"
+#include "InstrumentFile.hpp"
+#include "InstrumentJson.hpp"
+#include "InstrumentLibrary.hpp"
+#include "Sweep.hpp"
+#include "LayoutOptimizer.hpp"
+#include "NdjsonPipeline.hpp"
+#include "DxfWriter.hpp"
+#include "SvgTemplate.hpp"
 
 //class fretboarderLib
 //{
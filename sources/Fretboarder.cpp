@@ -139,8 +139,18 @@ bool createFretboard(const fretboarder::Instrument& instrument,
     CHECK(fret_slots_sketch, false);
     fret_slots_sketch->name("Fret slots as lines");
     fret_slots_sketch->isComputeDeferred(true);
-    for (auto &&vector : fretboard.fret_slots()) {
-        create_line(fret_slots_sketch->sketchCurves()->sketchLines(), vector);
+    if (fretboard.has_curved_frets()) {
+        const auto& polylines = fretboard.fret_slot_polylines();
+        for (size_t i = 0; i < polylines.size(); i++) {
+            auto points = polylines[i];
+            for (size_t p = 1; p < points.size(); p++) {
+                create_line(fret_slots_sketch->sketchCurves()->sketchLines(), Vector(points[p - 1], points[p]));
+            }
+        }
+    } else {
+        for (auto &&vector : fretboard.fret_slots()) {
+            create_line(fret_slots_sketch->sketchCurves()->sketchLines(), vector);
+        }
     }
     fret_slots_sketch->isComputeDeferred(false);
     fret_slots_sketch->isVisible(false);
@@ -149,8 +159,18 @@ bool createFretboard(const fretboarder::Instrument& instrument,
     CHECK(fret_lines_sketch, false);
     fret_lines_sketch->name("Fret lines as lines");
     fret_lines_sketch->isComputeDeferred(true);
-    for (auto &&vector : fretboard.fret_lines()) {
-        create_line(fret_lines_sketch->sketchCurves()->sketchLines(), vector);
+    if (fretboard.has_curved_frets()) {
+        const auto& polylines = fretboard.fret_polylines();
+        for (size_t i = 0; i < polylines.size(); i++) {
+            auto points = polylines[i];
+            for (size_t p = 1; p < points.size(); p++) {
+                create_line(fret_lines_sketch->sketchCurves()->sketchLines(), Vector(points[p - 1], points[p]));
+            }
+        }
+    } else {
+        for (auto &&vector : fretboard.fret_lines()) {
+            create_line(fret_lines_sketch->sketchCurves()->sketchLines(), vector);
+        }
     }
     fret_lines_sketch->isComputeDeferred(false);
     fret_lines_sketch->isVisible(false);
@@ -196,17 +216,17 @@ bool createFretboard(const fretboarder::Instrument& instrument,
     CHECK(construction_plane_at_heel, false);
     construction_plane_at_heel->name("Heel Side");
     
-    // create construction plane at 12th fret (only when there are enough frets)
-    Ptr<ConstructionPlane> construction_plane_at_12th_fret;
-    if (instrument.number_of_frets > 12) {
+    // create construction plane at the octave, the 12th fret in 12-TET (only when there are enough frets)
+    Ptr<ConstructionPlane> construction_plane_at_octave;
+    if (instrument.number_of_frets > fretboard.octave_fret()) {
         planeInput = planes->createInput();
         CHECK(planeInput, false);
-        offsetValue = ValueInput::createByReal(fretboard.construction_distance_at_12th_fret() * 0.1);
+        offsetValue = ValueInput::createByReal(fretboard.construction_distance_at_octave() * 0.1);
         CHECK(offsetValue, false);
         planeInput->setByOffset(component->yZConstructionPlane(), offsetValue);
-        construction_plane_at_12th_fret = planes->add(planeInput);
-        CHECK(construction_plane_at_12th_fret, false);
-        construction_plane_at_12th_fret->name("12th Fret");
+        construction_plane_at_octave = planes->add(planeInput);
+        CHECK(construction_plane_at_octave, false);
+        construction_plane_at_octave->name(fretboard.octave_fret() == 12 ? "12th Fret" : "Octave");
     }
     
     // draw radius circle at nut
@@ -247,6 +267,7 @@ bool createFretboard(const fretboarder::Instrument& instrument,
             << "  Bass scale:    " << instrument.scale_length[0] << " mm\n"
             << "  Treble scale:  " << instrument.scale_length[1] << " mm\n"
             << "  Frets:         " << instrument.number_of_frets << "\n"
+            << "  Frets/octave:  " << instrument.number_of_frets_per_octave << "\n"
             << "  Perp fret:     " << instrument.perpendicular_fret_index << "\n"
             << "  Radius at nut: " << instrument.radius_at_nut << " mm\n"
             << "  Radius at 12:  " << instrument.radius_at_last_fret << " mm\n"
@@ -13,6 +13,8 @@
 #include <Fusion/FusionAll.h>
 #include <CAM/CAM/CAM.h>
 #include "Fretboard.hpp"
+#include "FretboardBuilder.hpp"
+#include "InstrumentLibrary.hpp"
 #include <iostream>
 #include <sstream>
 #include <algorithm>
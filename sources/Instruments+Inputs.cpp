@@ -29,6 +29,7 @@ Instrument InstrumentFromInputs(const Ptr<CommandInputs>& inputs) {
     Ptr<ValueCommandInput>        radius_at_last_fret            = inputs->itemById(Param::radius_at_last_fret);
     Ptr<ValueCommandInput>        fretboard_thickness            = inputs->itemById(Param::fretboard_thickness);
     Ptr<ValueCommandInput>        number_of_frets                = inputs->itemById(Param::number_of_frets);
+    Ptr<ValueCommandInput>        number_of_frets_per_octave     = inputs->itemById(Param::number_of_frets_per_octave);
     Ptr<BoolValueCommandInput>    draw_strings                   = inputs->itemById(Param::draw_strings);
     Ptr<BoolValueCommandInput>    draw_frets                     = inputs->itemById(Param::draw_frets);
     Ptr<BoolValueCommandInput>    carve_fret_slots               = inputs->itemById(Param::carve_fret_slots);
@@ -67,6 +68,7 @@ Instrument InstrumentFromInputs(const Ptr<CommandInputs>& inputs) {
     CHECK(radius_at_last_fret, instrument);
     CHECK(fretboard_thickness, instrument);
     CHECK(number_of_frets, instrument);
+    CHECK(number_of_frets_per_octave, instrument);
     CHECK(draw_strings, instrument);
     CHECK(draw_frets, instrument);
     CHECK(carve_fret_slots, instrument);
@@ -96,6 +98,7 @@ Instrument InstrumentFromInputs(const Ptr<CommandInputs>& inputs) {
     instrument.has_zero_fret = has_zero_fret->value();
     instrument.nut_to_zero_fret_offset = nut_to_zero_fret_offset->value();
     instrument.number_of_frets = (int)round(number_of_frets->value());
+    instrument.number_of_frets_per_octave = std::max(1.0, round(number_of_frets_per_octave->value()));
     instrument.draw_frets = draw_frets->value();
     instrument.carve_fret_slots = carve_fret_slots->value();
     OverhangType t = single;
@@ -162,6 +165,7 @@ void InstrumentToInputs(const Ptr<CommandInputs>& inputs, const Instrument& i) {
     Ptr<ValueCommandInput>        radius_at_last_fret            = inputs->itemById(Param::radius_at_last_fret);
     Ptr<ValueCommandInput>        fretboard_thickness            = inputs->itemById(Param::fretboard_thickness);
     Ptr<ValueCommandInput>        number_of_frets                = inputs->itemById(Param::number_of_frets);
+    Ptr<ValueCommandInput>        number_of_frets_per_octave     = inputs->itemById(Param::number_of_frets_per_octave);
     Ptr<DropDownCommandInput>     overhang_type                  = inputs->itemById(Param::overhang_type);
     Ptr<ValueCommandInput>        overhangSingle                 = inputs->itemById(Param::overhangSingle);
     Ptr<ValueCommandInput>        overhangNut                    = inputs->itemById(Param::overhangNut);
@@ -195,6 +199,7 @@ void InstrumentToInputs(const Ptr<CommandInputs>& inputs, const Instrument& i) {
     CHECK2(radius_at_last_fret);
     CHECK2(fretboard_thickness);
     CHECK2(number_of_frets);
+    CHECK2(number_of_frets_per_octave);
     CHECK2(overhang_type);
     CHECK2(overhangSingle);
     CHECK2(overhangNut);
@@ -227,6 +232,7 @@ void InstrumentToInputs(const Ptr<CommandInputs>& inputs, const Instrument& i) {
     radius_at_last_fret->value(instrument.radius_at_last_fret);
     fretboard_thickness->value(instrument.fretboard_thickness);
     number_of_frets->value((double)instrument.number_of_frets);
+    number_of_frets_per_octave->value(instrument.number_of_frets_per_octave);
     OverhangType t = single;
     auto selected_item = overhang_type->selectedItem();
     if (selected_item != nullptr) {
@@ -277,6 +283,14 @@ void InstrumentToInputs(const Ptr<CommandInputs>& inputs, const Instrument& i) {
     nut_width->value(std::max(number_of_strings->valueOne() - 1, 1) * inter_string_spacing_at_nut->value() + overhang0->value() + overhang2->value());
 }
 
+const InstrumentLibrary& PresetLibrary() {
+    static const InstrumentLibrary library([] {
+        const char* filename = getenv("FRETBOARDER_LIBRARY");
+        return std::string(filename ? filename : "");
+    }());
+    return library;
+}
+
 // ---------------------------------------------------------------------------
 // BuildFretboardDialogInputs
 // Creates all tab groups and command inputs for the fretboard dialog.
@@ -296,6 +310,10 @@ void BuildFretboardDialogInputs(const Ptr<CommandInputs>& inputs) {
     for (size_t i = 0; i < allPresets.size(); i++) {
         presets->add(allPresets[i].name, false);
     }
+    const InstrumentLibrary& library = PresetLibrary();
+    for (size_t i = 0; i < library.size(); i++) {
+        presets->add(std::string(library.name(i)), false);
+    }
 
     group->addBoolValueInput("Load", "Load preset", false);
     group->addBoolValueInput("Save", "Save preset", false);
@@ -380,6 +398,11 @@ void BuildFretboardDialogInputs(const Ptr<CommandInputs>& inputs) {
     number_of_frets_input->tooltip("This is the number of frets not counting the zero fret.");
     CHECK2(number_of_frets_input);
 
+    auto number_of_frets_per_octave = group->addValueInput(Param::number_of_frets_per_octave, "Frets per octave", "", ValueInput::createByString("12"));
+    number_of_frets_per_octave->tooltip("This is the number of equal divisions of the octave: 12 for a standard instrument.");
+    number_of_frets_per_octave->tooltipDescription("Use 19, 24, 31... to build a microtonal (N-EDO) fretboard. Don't forget to raise the number of frets accordingly: a two octaves 31-EDO fretboard has 62 frets.");
+    CHECK2(number_of_frets_per_octave);
+
     auto perpendicular_fret_index = group->addValueInput(Param::perpendicular_fret_index, "Perpendicular Fret", "", ValueInput::createByString("0"));
     perpendicular_fret_index->tooltip("This is the position of the perpendicular fret for multiscale instruments. Use 100 to have the bridge be perpendicular to the strings (i.e. not slanted)");
     perpendicular_fret_index->tooltipDescription("This number is a floating point representing the position of the fretboard. If you choose, say, 7.5, the perpandicular position will be calculated as if it was right in between the 7th and the 8th fret. You can also use a negative number to completely offset the slanting of the string.");
@@ -562,6 +585,7 @@ void InstrumentToCustomFeatureInput(const Ptr<CustomFeatureInput>& cfInput,
         return D((double)instrument.number_of_frets);
     };
     addP(Param::number_of_frets,          "Fret Count",       fretCountExpr(),                                     "");
+    addP(Param::number_of_frets_per_octave, "Frets Per Octave", D(instrument.number_of_frets_per_octave),          "");
     addP(Param::overhang_type,            "Overhang Type",    D((double)instrument.overhang_type),                 "");
     addP(Param::right_handed,             "Right Handed",     D(instrument.right_handed     ? 1.0 : 0.0),          "");
     addP(Param::has_zero_fret,            "Has Zero Fret",    D(instrument.has_zero_fret    ? 1.0 : 0.0),          "");
@@ -604,6 +628,9 @@ Instrument InstrumentFromCustomFeature(const Ptr<CustomFeature>& feature) {
     instrument.perpendicular_fret_index     = D(Param::perpendicular_fret_index);
     instrument.number_of_strings            = I(Param::number_of_strings);
     instrument.number_of_frets              = I(Param::number_of_frets);
+    // Features created before N-EDO support don't have it and are 12-TET
+    double frets_per_octave                 = D(Param::number_of_frets_per_octave);
+    instrument.number_of_frets_per_octave   = frets_per_octave >= 1 ? frets_per_octave : 12;
     instrument.overhang_type                = (OverhangType)I(Param::overhang_type);
     instrument.right_handed                 = B(Param::right_handed);
     instrument.has_zero_fret                = B(Param::has_zero_fret);
@@ -657,6 +684,7 @@ void InstrumentToCustomFeature(const Ptr<CustomFeature>& feature,
     setD(Param::perpendicular_fret_index,       instrument.perpendicular_fret_index);
     setD(Param::number_of_strings,              (double)instrument.number_of_strings);
     setD(Param::number_of_frets,                (double)instrument.number_of_frets);
+    setD(Param::number_of_frets_per_octave,     instrument.number_of_frets_per_octave);
     setD(Param::overhang_type,                  (double)instrument.overhang_type);
     setD(Param::right_handed,                   instrument.right_handed  ? 1.0 : 0.0);
     setD(Param::has_zero_fret,                  instrument.has_zero_fret ? 1.0 : 0.0);
@@ -707,6 +735,7 @@ void CfExpressionsToInputs(const Ptr<CommandInputs>& inputs,
     setExpr(Param::fretboard_thickness,            Param::fretboard_thickness);
     setExpr(Param::perpendicular_fret_index,       Param::perpendicular_fret_index);
     setExpr(Param::number_of_frets,                Param::number_of_frets);
+    setExpr(Param::number_of_frets_per_octave,     Param::number_of_frets_per_octave);
 
     // Overhang fields: pick the visible input for the current overhang mode.
     int overhangType = (int)cfParamVal(cf, Param::overhang_type);
@@ -38,6 +38,7 @@ namespace Param {
     constexpr const char* perpendicular_fret_index       = "perpendicular_fret_index";
     constexpr const char* number_of_strings              = "number_of_strings";
     constexpr const char* number_of_frets                = "number_of_frets";
+    constexpr const char* number_of_frets_per_octave     = "number_of_frets_per_octave";
     constexpr const char* overhang_type                  = "overhang_type";
 
     // Boolean parameters (stored in CF and used as dialog input IDs)
@@ -68,6 +69,12 @@ namespace Param {
 Instrument InstrumentFromInputs(const Ptr<CommandInputs>& inputs);
 void InstrumentToInputs(const Ptr<CommandInputs>& inputs, const Instrument& i);
 
+// Instruments listed in the presets drop down after the built-in presets, in mm
+// like the .frt files. Read from the library file named by the
+// FRETBOARDER_LIBRARY environment variable, opened once and empty if there is
+// none; only the instrument picked in the drop down is decoded.
+const InstrumentLibrary& PresetLibrary();
+
 // Builds all tab/input controls for the fretboard dialog (used by both
 // the create and edit commands).
 void BuildFretboardDialogInputs(const Ptr<CommandInputs>& inputs);
@@ -34,7 +34,7 @@ void OnExecutePreviewEventHandler::notify(const Ptr<CommandEventArgs>& eventArgs
         return;
 
     auto instrument = InstrumentFromInputs(inputs);
-    fretboarder::Fretboard fretboard(instrument);
+    const fretboarder::Fretboard& fretboard = builder.build(instrument);
 
     // Get (or refresh) the custom graphics groups from the active product.
     if (!Fretboarder::cgGroups) {
@@ -70,14 +70,24 @@ void OnExecutePreviewEventHandler::notify(const Ptr<CommandEventArgs>& eventArgs
         }
     }
 
-    {
+    if (!fretboard.strings().empty()) {
         // Draw bridge line
         AddLine(vecCoords, fretboard.strings().front().point_at_bridge(), fretboard.strings().back().point_at_bridge());
     }
 
     // Draw the fret positions
-    for (auto s : fretboard.fret_lines()) {
-        AddLine(vecCoords, s.point1, s.point2);
+    if (fretboard.has_curved_frets()) {
+        const auto& polylines = fretboard.fret_polylines();
+        for (size_t i = 0; i < polylines.size(); i++) {
+            auto points = polylines[i];
+            for (size_t p = 1; p < points.size(); p++) {
+                AddLine(vecCoords, points[p - 1], points[p]);
+            }
+        }
+    } else {
+        for (auto s : fretboard.fret_lines()) {
+            AddLine(vecCoords, s.point1, s.point2);
+        }
     }
 
     // Draw the frettboard shape
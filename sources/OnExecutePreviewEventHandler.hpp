@@ -14,6 +14,10 @@ class OnExecutePreviewEventHandler : public adsk::core::CommandEventHandler
 public:
     void notify(const Ptr<CommandEventArgs>& eventArgs);
     void applyLinesProperties(Ptr<CustomGraphicsLines> cgLines);
+
+private:
+    // Previews follow the changes of the inputs one at a time, most only recompute a part of the fretboard
+    fretboarder::FretboardBuilder builder;
 };
 
 
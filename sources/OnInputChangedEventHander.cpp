@@ -32,12 +32,23 @@ void OnInputChangedEventHander::notify(const Ptr<InputChangedEventArgs>& eventAr
             return;
         }
 
-        auto index = item->index();
-        auto preset = Preset::presets()[index];
-        preset.instrument.validate();
+        size_t index = item->index();
+        auto presets = Preset::presets();
+        if (index < presets.size()) {
+            auto preset = presets[index];
+            preset.instrument.validate();
 
-        // Apply Preset:
-        InstrumentToInputs(inputs, preset.instrument);
+            // Apply Preset:
+            InstrumentToInputs(inputs, preset.instrument);
+        } else {
+            // From the library, decoded now
+            Instrument instrument;
+            if (!PresetLibrary().instrument(index - presets.size(), instrument)) {
+                return;
+            }
+            instrument.scale(0.1); // mm to cm
+            InstrumentToInputs(inputs, instrument);
+        }
 
     } else if (cmdInput->id() == "Load") {
         auto fileDialog = Fretboarder::ui->createFileDialog();